@@ -0,0 +1,461 @@
+/*  Copyright 2026 OpenTag contributors
+  *
+  * Licensed under the OpenTag License, Version 1.0 (the "License");
+  * you may not use this file except in compliance with the License.
+  * You may obtain a copy of the License at
+  *
+  * http://www.indigresso.com/wiki/doku.php?id=opentag:license_1_0
+  *
+  * Unless required by applicable law or agreed to in writing, software
+  * distributed under the License is distributed on an "AS IS" BASIS,
+  * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  * See the License for the specific language governing permissions and
+  * limitations under the License.
+  */
+/**
+  * @file       /Supplements/aes_bench/bench.c
+  * @author     OpenTag contributors
+  * @version    V1.0
+  * @date       16 October 2026
+  * @brief      Host known-answer test & benchmark for otlib/crypto_aes128.c
+  *
+  * Links otlib/crypto_aes128.c against a stub ISF (for AES_load_static_key)
+  * and checks each AES backend that it was built with against the FIPS-197,
+  * SP 800-38A and RFC 3610 (CCM) test vectors.  If they all pass, it times
+  * the block cipher, the key schedules and CCM on a DLL-sized frame.  The
+  * program fails (exit 1) if any test vector fails.
+  *
+  * Usage: bench [-t ms] [-c results.csv]
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#   include <x86intrin.h>
+#   define BENCH_CYCLES()   ((double)__rdtsc())
+#else
+#   define BENCH_CYCLES()   (0.0)
+#endif
+
+#include "OT_types.h"
+#include "OT_config.h"
+#include "OT_platform.h"
+#include "veelite.h"
+#include "crypto_aes128.h"
+
+
+#ifndef BENCH_NAME
+#   define BENCH_NAME   "default"
+#endif
+
+#define FRAME_AAD   8
+#define FRAME_MSG   48
+
+
+
+
+/** Stub platform & ISF
+  * ============================================================================
+  * AES_load_static_key() reads the key from an ISF.  Here, every ISF is the
+  * 16 bytes in "stub_isf".
+  */
+static ot_u8 stub_isf[16];
+
+void platform_memcpy(ot_u8* dest, ot_u8* src, ot_int length) {
+    memmove(dest, src, length);
+}
+
+vlFILE* ISF_open_su(ot_u8 id) {
+    return (vlFILE*)stub_isf;
+}
+
+ot_u16 vl_read(vlFILE* fp, ot_uint offset) {
+    return *(ot_u16*)&stub_isf[offset];
+}
+
+ot_u8 vl_close(vlFILE* fp) {
+    return 0;
+}
+
+
+
+
+/** Test vectors
+  * ============================================================================
+  */
+typedef struct {
+    const char* name;
+    ot_u8       key[16];
+    ot_u8       plain[16];
+    ot_u8       cipher[16];
+} block_kat;
+
+static const block_kat block_kats[] = {
+    {   "FIPS-197 C.1",
+        { 0x00,0x01,0x02,0x03, 0x04,0x05,0x06,0x07, 0x08,0x09,0x0a,0x0b, 0x0c,0x0d,0x0e,0x0f },
+        { 0x00,0x11,0x22,0x33, 0x44,0x55,0x66,0x77, 0x88,0x99,0xaa,0xbb, 0xcc,0xdd,0xee,0xff },
+        { 0x69,0xc4,0xe0,0xd8, 0x6a,0x7b,0x04,0x30, 0xd8,0xcd,0xb7,0x80, 0x70,0xb4,0xc5,0x5a } },
+
+    {   "SP800-38A F.1.1",
+        { 0x2b,0x7e,0x15,0x16, 0x28,0xae,0xd2,0xa6, 0xab,0xf7,0x15,0x88, 0x09,0xcf,0x4f,0x3c },
+        { 0x6b,0xc1,0xbe,0xe2, 0x2e,0x40,0x9f,0x96, 0xe9,0x3d,0x7e,0x11, 0x73,0x93,0x17,0x2a },
+        { 0x3a,0xd7,0x7b,0xb4, 0x0d,0x7a,0x36,0x60, 0xa8,0x9e,0xca,0xf3, 0x24,0x66,0xef,0x97 } }
+};
+
+
+/// RFC 3610, Packet Vector #1: 8 bytes of AAD, 23 bytes of message, 8 byte MIC
+static const ot_u8 ccm_key[16] = {
+    0xc0,0xc1,0xc2,0xc3, 0xc4,0xc5,0xc6,0xc7, 0xc8,0xc9,0xca,0xcb, 0xcc,0xcd,0xce,0xcf
+};
+static const ot_u8 ccm_nonce[AES_CCM_NONCE_SIZE] = {
+    0x00,0x00,0x00,0x03, 0x02,0x01,0x00,0xa0, 0xa1,0xa2,0xa3,0xa4, 0xa5
+};
+static const ot_u8 ccm_packet[39] = {
+    0x00,0x01,0x02,0x03, 0x04,0x05,0x06,0x07, 0x58,0x8c,0x97,0x9a, 0x61,0xc6,0x63,0xd2,
+    0xf0,0x66,0xd0,0xc2, 0xc0,0xf9,0x89,0x80, 0x6d,0x5f,0x6b,0x61, 0xda,0xc3,0x84,0x17,
+    0xe8,0xd1,0x2c,0xfd, 0xf9,0x26,0xe0
+};
+
+
+
+
+/** Backends
+  * ============================================================================
+  * With AES-NI, the same build is run twice: once on the T-table path and once
+  * on AES-NI (if the CPU has it).
+  */
+#if (AES_USELITE == ENABLED)
+#   define NAME_SW      "lite"
+#else
+#   define NAME_SW      "ttable"
+#endif
+
+static const char* backend_name;
+
+
+static ot_bool sub_backend(ot_int i) {
+/// Selects backend i, and returns False if there isn't one
+#if (AES_USENI == ENABLED)
+    if (i == 0) {
+        AES_use_ni(False);
+        backend_name = NAME_SW;
+        return True;
+    }
+    if ((i == 1) && AES_use_ni(True)) {
+        backend_name = "aesni";
+        return True;
+    }
+    return False;
+#else
+    backend_name = NAME_SW;
+    return (ot_bool)(i == 0);
+#endif
+}
+
+
+
+
+/** Known Answer Tests
+  * ============================================================================
+  */
+static void sub_pack(ot_u32* words, const ot_u8* bytes) {
+    ot_int i;
+    for (i=0; i<4; i++) {
+        words[i] = ((ot_u32)bytes[(i<<2)+0] << 24) | ((ot_u32)bytes[(i<<2)+1] << 16) |
+                   ((ot_u32)bytes[(i<<2)+2] << 8)  |  (ot_u32)bytes[(i<<2)+3];
+    }
+}
+
+
+static ot_bool sub_kat_block(const block_kat* kat) {
+    ot_u32 key[AES_KEY_SIZE];
+    ot_u32 expkey[AES_EXPKEY_SIZE];
+    ot_u32 block[4];
+    ot_u32 plain[4];
+    ot_u32 cipher[4];
+
+    sub_pack(plain, kat->plain);
+    sub_pack(cipher, kat->cipher);
+
+    /// The key comes from the stub ISF, to test AES_load_static_key() too
+    memcpy(stub_isf, kat->key, 16);
+    AES_load_static_key(0, key);
+
+    AES_keyschedule_enc(key, expkey);
+    AES_encrypt(plain, block, expkey);
+    if (memcmp(block, cipher, 16) != 0) {
+        return False;
+    }
+
+    AES_keyschedule_dec(key, expkey);
+    AES_decrypt(cipher, block, expkey);
+    return (ot_bool)(memcmp(block, plain, 16) == 0);
+}
+
+
+static ot_bool sub_kat_ccm() {
+    ot_u32      key[AES_KEY_SIZE];
+    ot_u32      expkey[AES_EXPKEY_SIZE];
+    ot_u8       packet[39];
+    ot_int      i;
+    aes_ccm_ctx ccm;
+
+    sub_pack(key, ccm_key);
+    AES_keyschedule_enc(key, expkey);
+
+    /// Encrypt, with the AAD and message split so that the blocks are streamed
+    memcpy(packet, ccm_packet, 8);
+    for (i=8; i<31; i++) {
+        packet[i] = (ot_u8)i;
+    }
+    AES_ccm_init(&ccm, expkey, (ot_u8*)ccm_nonce, 8, 23, 8);
+    AES_ccm_aad(&ccm, packet, 3);
+    AES_ccm_aad(&ccm, packet+3, 5);
+    AES_ccm_encrypt(&ccm, packet+8, 10);
+    AES_ccm_encrypt(&ccm, packet+18, 13);
+    AES_ccm_final(&ccm, packet+31);
+    if (memcmp(packet, ccm_packet, 39) != 0) {
+        return False;
+    }
+
+    /// Decrypt and verify, and then make sure a changed bit fails
+    AES_ccm_init(&ccm, expkey, (ot_u8*)ccm_nonce, 8, 23, 8);
+    AES_ccm_aad(&ccm, packet, 8);
+    AES_ccm_decrypt(&ccm, packet+8, 23);
+    if ((AES_ccm_verify(&ccm, packet+31) == False) || (packet[30] != 30)) {
+        return False;
+    }
+    memcpy(packet, ccm_packet, 39);
+    packet[20] ^= 0x10;
+    AES_ccm_init(&ccm, expkey, (ot_u8*)ccm_nonce, 8, 23, 8);
+    AES_ccm_aad(&ccm, packet, 8);
+    AES_ccm_decrypt(&ccm, packet+8, 23);
+    return (ot_bool)(AES_ccm_verify(&ccm, packet+31) == False);
+}
+
+
+static int sub_kats() {
+    ot_int i;
+    int    err = 0;
+
+    for (i=0; i<(ot_int)(sizeof(block_kats)/sizeof(block_kat)); i++) {
+        if (sub_kat_block(&block_kats[i]) == False) {
+            fprintf(stderr, "%s/%s: %s failed\n", BENCH_NAME, backend_name, block_kats[i].name);
+            err = -1;
+        }
+    }
+    if (sub_kat_ccm() == False) {
+        fprintf(stderr, "%s/%s: RFC 3610 #1 (CCM) failed\n", BENCH_NAME, backend_name);
+        err = -1;
+    }
+    return err;
+}
+
+
+
+
+/** Benchmark
+  * ============================================================================
+  */
+typedef struct {
+    double  ns;
+    double  cycles;
+    long    n;
+} result_t;
+
+typedef enum {
+    TEST_ENC = 0,
+    TEST_DEC,
+    TEST_KEYENC,
+    TEST_KEYDEC,
+    TEST_CCM,
+    TEST_MAX
+} test_t;
+
+static const char* test_names[TEST_MAX] = { "enc", "dec", "keyenc", "keydec", "ccm" };
+static const int   test_bytes[TEST_MAX] = { 16, 16, 16, 16, FRAME_AAD+FRAME_MSG };
+
+static ot_u32   bench_key[AES_KEY_SIZE]     = { 0x2b7e1516, 0x28aed2a6, 0xabf71588, 0x09cf4f3c };
+static ot_u32   bench_expkey[AES_EXPKEY_SIZE];
+static ot_u32   bench_block[4];
+static ot_u8    bench_frame[FRAME_AAD+FRAME_MSG+4];
+
+
+static double sub_now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((double)ts.tv_sec * 1e9) + (double)ts.tv_nsec;
+}
+
+
+static void sub_test(test_t test, long n) {
+    aes_ccm_ctx ccm;
+
+    switch (test) {
+        case TEST_ENC:      while (--n >= 0) AES_encrypt(bench_block, bench_block, bench_expkey);
+                            break;
+
+        case TEST_DEC:      while (--n >= 0) AES_decrypt(bench_block, bench_block, bench_expkey);
+                            break;
+
+        case TEST_KEYENC:   while (--n >= 0) {
+                                AES_keyschedule_enc(bench_key, bench_expkey);
+                                bench_key[0] ^= bench_expkey[43];
+                            }
+                            break;
+
+        case TEST_KEYDEC:   while (--n >= 0) {
+                                AES_keyschedule_dec(bench_key, bench_expkey);
+                                bench_key[0] ^= bench_expkey[43];
+                            }
+                            break;
+
+        /// A DLL-secured frame: MIC over the header, encrypt & MIC the payload
+        case TEST_CCM:      while (--n >= 0) {
+                                AES_ccm_init(&ccm, bench_expkey, bench_frame,
+                                            FRAME_AAD, FRAME_MSG, 4);
+                                AES_ccm_aad(&ccm, bench_frame, FRAME_AAD);
+                                AES_ccm_encrypt(&ccm, &bench_frame[FRAME_AAD], FRAME_MSG);
+                                AES_ccm_final(&ccm, &bench_frame[FRAME_AAD+FRAME_MSG]);
+                            }
+                            break;
+
+        default:            break;
+    }
+}
+
+
+static void sub_run(result_t* result, test_t test, double min_ns) {
+    long    n;
+    double  t0, c0;
+
+    /// The encrypt schedule is used for everything except decryption
+    if (test == TEST_DEC)   AES_keyschedule_dec(bench_key, bench_expkey);
+    else                    AES_keyschedule_enc(bench_key, bench_expkey);
+
+    /// Find an iteration count that takes about min_ns, then time it
+    for (n=64; ; n<<=1) {
+        t0 = sub_now_ns();
+        sub_test(test, n);
+        if ((sub_now_ns() - t0) >= (min_ns / 4)) break;
+    }
+    n <<= 2;
+
+    t0 = sub_now_ns();
+    c0 = BENCH_CYCLES();
+    sub_test(test, n);
+    result->cycles  = BENCH_CYCLES() - c0;
+    result->ns      = sub_now_ns() - t0;
+    result->n       = n;
+}
+
+
+static void sub_report(FILE* csv, test_t test, result_t* r) {
+    double bytes    = (double)r->n * (double)test_bytes[test];
+    double ns_op    = r->ns / (double)r->n;
+    double mb_s     = (bytes * 1e3) / r->ns;
+    double cyc_byte = r->cycles / bytes;
+
+    printf("%-8s %-8s %-7s %5d %10.1f %10.1f %10.2f\n",
+            BENCH_NAME, backend_name, test_names[test], test_bytes[test], ns_op, mb_s, cyc_byte);
+
+    if (csv != NULL) {
+        fprintf(csv, "%s,%s,%s,%d,%ld,%.3f,%.3f,%.3f\n", BENCH_NAME, backend_name,
+                test_names[test], test_bytes[test], r->n, ns_op, mb_s, cyc_byte);
+    }
+}
+
+
+static int sub_bench(FILE* csv, double min_ns) {
+    test_t      test;
+    result_t    result;
+
+    if (sub_kats() != 0) {
+        return -1;
+    }
+    for (test=TEST_ENC; test<TEST_MAX; test++) {
+        sub_run(&result, test, min_ns);
+        sub_report(csv, test, &result);
+    }
+    return 0;
+}
+
+
+int main(int argc, char** argv) {
+    int     opt;
+    int     err         = 0;
+    ot_int  i;
+    double  min_ns      = 200e6;
+    FILE*   csv         = NULL;
+
+    while ((opt = getopt(argc, argv, "t:c:")) != -1) {
+        switch (opt) {
+            case 't':   min_ns = atof(optarg) * 1e6;
+                        break;
+
+            case 'c':   csv = fopen(optarg, "a+");
+                        if (csv == NULL) {
+                            perror(optarg);
+                            return 2;
+                        }
+                        fseek(csv, 0, SEEK_END);
+                        if (ftell(csv) == 0) {
+                            fprintf(csv, "config,backend,test,bytes,ops,ns_per_op,mb_per_s,cycles_per_byte\n");
+                        }
+                        break;
+
+            default:    fprintf(stderr, "Usage: %s [-t ms] [-c results.csv]\n", argv[0]);
+                        return 2;
+        }
+    }
+
+    printf("%-8s %-8s %-7s %5s %10s %10s %10s\n",
+            "config", "backend", "test", "bytes", "ns/op", "MB/s", "cyc/byte");
+
+    for (i=0; sub_backend(i); i++) {
+        err |= sub_bench(csv, min_ns);
+    }
+
+#   if (AES_USENI == ENABLED)
+    /// AES-NI and the T-table path must give the same answer for any input
+    if (sub_backend(1)) {
+        ot_u32  expkey[AES_EXPKEY_SIZE];
+        ot_u32  a[4], b[4];
+        ot_int  j;
+
+        srand(1);
+        for (i=0; (i<1000) && (err == 0); i++) {
+            for (j=0; j<4; j++) {
+                bench_key[j]    = ((ot_u32)rand() << 16) ^ (ot_u32)rand();
+                bench_block[j]  = ((ot_u32)rand() << 16) ^ (ot_u32)rand();
+            }
+            AES_keyschedule_enc(bench_key, expkey);
+            AES_use_ni(False);
+            AES_encrypt(bench_block, a, expkey);
+            AES_use_ni(True);
+            AES_encrypt(bench_block, b, expkey);
+            err = memcmp(a, b, 16);
+            AES_keyschedule_dec(bench_key, expkey);
+            AES_decrypt(b, b, expkey);
+            AES_use_ni(False);
+            AES_decrypt(a, a, expkey);
+            AES_use_ni(True);
+            err |= memcmp(a, bench_block, 16) | memcmp(b, bench_block, 16);
+            if (err != 0) {
+                fprintf(stderr, "%s: AES-NI and T-table differ (case %d)\n", BENCH_NAME, i);
+                err = -1;
+            }
+        }
+    }
+#   endif
+
+    if (csv != NULL) {
+        fclose(csv);
+    }
+    return (err != 0);
+}
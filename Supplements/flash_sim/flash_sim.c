@@ -0,0 +1,122 @@
+/*  Copyright 2026 OpenTag contributors
+  *
+  * Licensed under the OpenTag License, Version 1.0 (the "License");
+  * you may not use this file except in compliance with the License.
+  * You may obtain a copy of the License at
+  *
+  * http://www.indigresso.com/wiki/doku.php?id=opentag:license_1_0
+  *
+  * Unless required by applicable law or agreed to in writing, software
+  * distributed under the License is distributed on an "AS IS" BASIS,
+  * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  * See the License for the specific language governing permissions and
+  * limitations under the License.
+  */
+/**
+  * @file       /Supplements/flash_sim/flash_sim.c
+  * @author     OpenTag contributors
+  * @version    V1.0
+  * @date       16 October 2026
+  * @brief      Simulated NAND/NOR Flash for the host Flash simulator
+  ******************************************************************************
+  */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "OT_types.h"
+#include "OT_config.h"
+#include "OT_platform.h"
+#include "flash_sim.h"
+
+
+flashsim_struct flashsim;
+ot_u16          flashsim_mem[FLASHSIM_PAGES * FLASHSIM_PAGEWORDS];
+
+static flashsim_ctl flashsim_reg;
+flashsim_ctl*       FLASH = &flashsim_reg;
+
+
+
+/// A power cut stops the operation it happens on.  A torn operation has
+/// changed a random part of the bits when power goes.
+static void sub_cut(ot_u16* word, ot_int length, ot_u16 data, ot_bool erase) {
+    if (flashsim.torn) {
+        for (; length>0; length--, word++) {
+            ot_u16 partial = (ot_u16)rand();
+            *word = erase ? (*word | partial) : (*word & (data | partial));
+        }
+    }
+    flashsim.cut_countdown = 0;
+    longjmp(*flashsim.cut_jmp, 1);
+}
+
+
+static ot_bool sub_power_on() {
+    if ((flashsim.cut_countdown > 0) && (--flashsim.cut_countdown == 0)) {
+        return False;
+    }
+    return True;
+}
+
+
+
+
+void flashsim_reset() {
+    ot_u32      program_us  = flashsim.program_us;
+    ot_u32      erase_us    = flashsim.erase_us;
+    ot_bool     torn        = flashsim.torn;
+    jmp_buf*    cut_jmp     = flashsim.cut_jmp;
+
+    /// The settings are kept
+    memset(&flashsim, 0, sizeof(flashsim_struct));
+    memset(flashsim_mem, 0xFF, sizeof(flashsim_mem));
+    flashsim.program_us = program_us;
+    flashsim.erase_us   = erase_us;
+    flashsim.torn       = torn;
+    flashsim.cut_jmp    = cut_jmp;
+}
+
+
+
+ot_u8 FLASH_EraseSegment(ot_u16* page) {
+    long offset = page - flashsim_mem;
+
+    if ((offset < 0) || (offset >= (FLASHSIM_PAGES*FLASHSIM_PAGEWORDS)) || \
+        (offset % FLASHSIM_PAGEWORDS)) {
+        flashsim.faults++;
+        return 1;
+    }
+    if (sub_power_on() == False) {
+        sub_cut(page, FLASHSIM_PAGEWORDS, 0xFFFF, True);
+    }
+
+    memset(page, 0xFF, FLASH_PAGE_SIZE);
+    flashsim.clock_us += flashsim.erase_us;
+    flashsim.erases++;
+    flashsim.page_erases[offset / FLASHSIM_PAGEWORDS]++;
+    return 0;
+}
+
+
+
+ot_u8 FLASH_WriteShort(ot_u16* addr, ot_u16 data) {
+    long offset = addr - flashsim_mem;
+
+    if ((offset < 0) || (offset >= (FLASHSIM_PAGES*FLASHSIM_PAGEWORDS))) {
+        flashsim.faults++;
+        return 1;
+    }
+    if (sub_power_on() == False) {
+        sub_cut(addr, 1, data, False);
+    }
+
+    /// Programming can only clear bits
+    if (data & ~(*addr)) {
+        flashsim.violations++;
+    }
+    *addr              &= data;
+    flashsim.clock_us  += flashsim.program_us;
+    flashsim.programs++;
+    return 0;
+}
@@ -0,0 +1,99 @@
+/*  Copyright 2026 OpenTag contributors
+  *
+  * Licensed under the OpenTag License, Version 1.0 (the "License");
+  * you may not use this file except in compliance with the License.
+  * You may obtain a copy of the License at
+  *
+  * http://www.indigresso.com/wiki/doku.php?id=opentag:license_1_0
+  *
+  * Unless required by applicable law or agreed to in writing, software
+  * distributed under the License is distributed on an "AS IS" BASIS,
+  * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  * See the License for the specific language governing permissions and
+  * limitations under the License.
+  */
+/**
+  * @file       /Supplements/flash_sim/flash_sim.h
+  * @author     OpenTag contributors
+  * @version    V1.0
+  * @date       16 October 2026
+  * @brief      Simulated NAND/NOR Flash for the host Flash simulator
+  *
+  * The Flash is an array of 16 bit words, organized in pages.  Like real
+  * Flash, a program can only clear bits (a program that needs a 0->1 change
+  * is counted as a violation), and an erase sets a whole page to 0xFFFF.
+  * Each operation adds its latency to a clock, each erase is counted on its
+  * page, and a power cut can be set to happen at any operation.
+  ******************************************************************************
+  */
+
+#ifndef __FLASH_SIM_H
+#define __FLASH_SIM_H
+
+#include <setjmp.h>
+#include "OT_types.h"
+
+
+/// Pages in the simulated Flash: the filesystem pages plus two for a journal
+#define FLASHSIM_PAGES          (FLASH_NUM_PAGES + 2)
+#define FLASHSIM_PAGEWORDS      (FLASH_PAGE_SIZE / 2)
+
+
+/** @typedef flashsim_struct
+  * State and statistics of the simulated Flash.  Set the latencies, then
+  * clear the statistics with flashsim_reset() (which also erases everything).
+  * To cut power, point cut_jmp at a jmp_buf and set cut_countdown to the
+  * number of operations to allow: the operation after them does not happen
+  * (or happens partly, if torn is True) and the simulator longjmp()s to
+  * cut_jmp.
+  */
+typedef struct {
+    ot_u32      program_us;                 // Latency of one word program
+    ot_u32      erase_us;                   // Latency of one page erase
+    double      clock_us;                   // Total Flash busy time
+    ot_u32      programs;
+    ot_u32      erases;
+    ot_u32      violations;                 // Programs that needed 0->1
+    ot_u32      faults;                     // Operations outside the Flash
+    ot_u32      page_erases[FLASHSIM_PAGES];
+    long        cut_countdown;              // 0: no power cut is set
+    ot_bool     torn;
+    jmp_buf*    cut_jmp;
+} flashsim_struct;
+
+extern flashsim_struct flashsim;
+extern ot_u16 flashsim_mem[FLASHSIM_PAGES * FLASHSIM_PAGEWORDS];
+
+
+/** @brief Erases all the simulated Flash and clears the statistics
+  * @param none
+  * @retval none
+  */
+void flashsim_reset();
+
+
+/** @brief Erases one page (the CC430 driver function that NAND_erase_page uses)
+  * @param page     (ot_u16*) start of the page
+  * @retval ot_u8   0 on success, 1 if the address is not a page of the Flash
+  */
+ot_u8 FLASH_EraseSegment(ot_u16* page);
+
+
+/** @brief Programs one word (the CC430 driver function that NAND_write_short uses)
+  * @param addr     (ot_u16*) address of the word
+  * @param data     (ot_u16) value to program
+  * @retval ot_u8   0 on success, 1 if the address is not in the Flash
+  */
+ot_u8 FLASH_WriteShort(ot_u16* addr, ot_u16 data);
+
+
+/// Flash controller register that the CC430 core flags access violations in
+typedef struct {
+    ot_u16 CTL3;
+} flashsim_ctl;
+
+extern flashsim_ctl* FLASH;
+#define ACCVIFG     0x0004
+
+
+#endif
@@ -0,0 +1,123 @@
+/*  Copyright 2026 OpenTag contributors
+  *
+  * Licensed under the OpenTag License, Version 1.0 (the "License");
+  * you may not use this file except in compliance with the License.
+  * You may obtain a copy of the License at
+  *
+  * http://www.indigresso.com/wiki/doku.php?id=opentag:license_1_0
+  *
+  * Unless required by applicable law or agreed to in writing, software
+  * distributed under the License is distributed on an "AS IS" BASIS,
+  * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  * See the License for the specific language governing permissions and
+  * limitations under the License.
+  */
+/**
+  * @file       /Supplements/flash_sim/platform_config.h
+  * @author     OpenTag contributors
+  * @version    V1.0
+  * @date       16 October 2026
+  * @brief      Host Platform & simulated Flash for the Flash simulator
+  *
+  * The X2 Veelite Core is built as it is for the CC430.  Its NAND macros call
+  * FLASH_EraseSegment() and FLASH_WriteShort(), which are the simulated Flash
+  * in flash_sim.c.  The Flash geometry can be set with -D (see the Makefile).
+  *
+  * Don't actually include this.  Include OT_platform.h instead.
+  ******************************************************************************
+  */
+
+#ifndef __PLATFORM_CONFIG_H
+#define __PLATFORM_CONFIG_H
+
+#include "build_config.h"
+
+
+#define PLATFORM_POSIX
+
+
+
+/// The simulator is built with GCC, but not as GCC firmware: the linker
+/// workarounds in the MCU Veelite Cores do not apply to it.
+#undef CC_SUPPORT
+#define CC_SUPPORT      SIM_GCC
+
+
+
+/// Macro settings: ENABLED, DISABLED, NOT_AVAILABLE
+#ifdef ENABLED
+#   undef ENABLED
+#endif
+#define ENABLED  1
+
+#ifdef DISABLED
+#   undef DISABLED
+#endif
+#define DISABLED  0
+
+#ifdef NOT_AVAILABLE
+#   undef NOT_AVAILABLE
+#endif
+#define NOT_AVAILABLE   DISABLED
+
+
+
+/// Host "MCU": no peripherals
+#define MCU_FEATURE(VAL)                MCU_FEATURE_##VAL
+#define MCU_FEATURE_CRC                 DISABLED
+#define MCU_FEATURE_AES128              DISABLED
+#define MCU_FEATURE_RADIODMA_TXBYTES    0
+#define MCU_FEATURE_RADIODMA_RXBYTES    0
+
+#define MCU_PARAM(VAL)                  MCU_PARAM_##VAL
+#define MCU_PARAM_CRCSLICE              8                       // SW CRC block engine: bytes per step (1, 4, 8)
+
+
+
+/// Simulated Flash.  The defaults are the CC430 boards: 512 byte segments,
+/// 8 for the filesystem, with 3 of them fallow.  With OT_FEATURE_VLJOURNAL,
+/// there are 2 more pages for the journal.
+#ifndef FLASH_PAGE_SIZE
+#   define FLASH_PAGE_SIZE              512
+#endif
+#ifndef FLASH_NUM_PAGES
+#   define FLASH_NUM_PAGES              8
+#endif
+#ifndef FLASH_FS_FALLOWS
+#   define FLASH_FS_FALLOWS             3
+#endif
+#define FLASH_WORD_BYTES                2
+#define FLASH_WORD_BITS                 (FLASH_WORD_BYTES*8)
+#define FLASH_FS_ALLOC                  (FLASH_PAGE_SIZE*FLASH_NUM_PAGES)
+#define FLASH_FS_ADDR                   ((unsigned long)flashsim_mem)
+
+#define OTF_VWORM_PAGES                 FLASH_NUM_PAGES
+#define OTF_VWORM_FALLOW_PAGES          FLASH_FS_FALLOWS
+#define OTF_VWORM_PAGESIZE              FLASH_PAGE_SIZE
+#define OTF_VWORM_START_ADDR            FLASH_FS_ADDR
+
+#define PLATFORM_POINTER_SIZE           8
+
+#include "flash_sim.h"
+
+
+
+/// Stub Radio (not used)
+#define RF_FEATURE(VAL)                 RF_FEATURE_##VAL
+#define RF_FEATURE_PN9                  DISABLED
+#define RF_FEATURE_CRC                  DISABLED
+#define RF_FEATURE_FEC                  DISABLED
+#define RF_FEATURE_SOFTBITS             DISABLED
+#define RF_FEATURE_FIFO                 ENABLED
+#define RF_FEATURE_TXFIFO_BYTES         1024
+#define RF_FEATURE_RXFIFO_BYTES         1024
+
+
+
+#define OS_FEATURE(VAL)                 DISABLED                // NO OS Featuresetting just yet
+#define OS_FEATURE_MEMCPY               DISABLED                //
+#define OS_FEATURE_MALLOC               DISABLED
+
+
+
+#endif
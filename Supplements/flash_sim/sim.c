@@ -0,0 +1,424 @@
+/*  Copyright 2026 OpenTag contributors
+  *
+  * Licensed under the OpenTag License, Version 1.0 (the "License");
+  * you may not use this file except in compliance with the License.
+  * You may obtain a copy of the License at
+  *
+  * http://www.indigresso.com/wiki/doku.php?id=opentag:license_1_0
+  *
+  * Unless required by applicable law or agreed to in writing, software
+  * distributed under the License is distributed on an "AS IS" BASIS,
+  * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  * See the License for the specific language governing permissions and
+  * limitations under the License.
+  */
+/**
+  * @file       /Supplements/flash_sim/sim.c
+  * @author     OpenTag contributors
+  * @version    V1.0
+  * @date       16 October 2026
+  * @brief      Workload runner for the X2 Veelite Core on simulated Flash
+  *
+  * Runs a workload of VWORM writes through the X2 Veelite Core, on the Flash
+  * in flash_sim.c, and keeps a model of what VWORM should contain.  The
+  * workload is a trace file (see _Readme.txt) or a built-in one, which is
+  * like a node that updates some counters and appends to a sensor log.  With
+  * -k, power is cut at random points (once per that many events, on average),
+  * then the core is started again and every word is checked against the
+  * model.  The report gives the erase amplification, the wear of the most-
+  * erased page and the lifetime that it gives, the write latency, and the
+  * recovery results.
+  *
+  * Usage: sim [-f trace] [-n writes] [-s seed] [-i interval] [-k interval] [-t]
+  *            [-p program_us] [-e erase_us] [-E endurance] [-T seconds]
+  *            [-c results.csv]
+  ******************************************************************************
+  */
+
+#include <setjmp.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "OT_types.h"
+#include "OT_config.h"
+#include "OT_platform.h"
+#include "veelite_core.h"
+#include "flash_sim.h"
+
+
+#ifndef SIM_NAME
+#   define SIM_NAME     "default"
+#endif
+
+#define SIM_WORDS       ((VWORM_PRIMARY_PAGES*VWORM_PAGESIZE) / 2)
+
+/// Built-in workload: counters in the first page, and a sensor log ring in
+/// the second (or in the first, if there is only one primary page)
+#define SIM_COUNTERS    8
+#define SIM_LOGBASE     ((VWORM_PRIMARY_PAGES > 1) ? (VWORM_PAGESIZE/2) : 32)
+#define SIM_LOGWORDS    64
+
+
+/** @typedef sim_event
+  * One step of the workload: 'w' writes value to addr, 'i' is idle time, and
+  * 'r' is an orderly reboot.
+  */
+typedef struct {
+    char    op;
+    vaddr   addr;
+    ot_u16  value;
+} sim_event;
+
+/** @typedef sim_stats
+  * Results of a run.  Latencies are simulated Flash time.
+  */
+typedef struct {
+    ot_u32  writes;
+    ot_u32  idles;
+    ot_u32  reboots;
+    ot_u32  cuts;
+    ot_u32  lost;               // Recoveries with a wrong word
+    ot_u32  crashes;            // Recoveries that crashed
+    ot_u32  bad_reboots;        // Orderly reboots with a wrong word
+    double  write_us;
+    double  max_write_us;
+    double  max_idle_us;
+    double  max_init_us;
+} sim_stats;
+
+
+static ot_u16       model[SIM_WORDS];
+static sim_stats    stats;
+static jmp_buf      cut_jmp;
+static sigjmp_buf   crash_jmp;
+
+/// Platform stubs for the core
+platform_struct platform;
+
+void otapi_log_code(ot_u8 label_len, ot_u8* label, ot_u16 code) { }
+
+
+
+
+/** Workloads
+  * ============================================================================
+  */
+static FILE*    trace       = NULL;
+static ot_u32   trace_line  = 0;
+static ot_u32   gen_writes  = 20000;
+static ot_u32   gen_idle    = 16;
+static ot_u32   gen_count   = 0;
+static ot_u32   gen_log     = 0;
+
+
+static ot_bool sub_next_trace(sim_event* ev) {
+    char            line[128];
+    char            op;
+    unsigned long   addr, value;
+    int             n;
+
+    while (fgets(line, sizeof(line), trace) != NULL) {
+        trace_line++;
+        n = sscanf(line, " %c %li %li", &op, (long*)&addr, (long*)&value);
+        if ((n < 1) || (op == '#')) {
+            continue;
+        }
+        if ((op == 'w') && (n == 3) && ((addr & 1) == 0) && (addr < (SIM_WORDS*2))) {
+            ev->op      = 'w';
+            ev->addr    = (vaddr)addr;
+            ev->value   = (ot_u16)value;
+            return True;
+        }
+        if ((op == 'i') || (op == 'r')) {
+            ev->op = op;
+            return True;
+        }
+        fprintf(stderr, "trace line %u: not understood\n", (unsigned)trace_line);
+    }
+    return False;
+}
+
+
+static ot_bool sub_next_builtin(sim_event* ev) {
+    ot_u32 pick;
+
+    if (gen_count >= gen_writes) {
+        return False;
+    }
+
+    /// Idle time after every gen_idle writes
+    if ((gen_idle != 0) && (gen_count % gen_idle == 0) && (ev->op == 'w')) {
+        ev->op = 'i';
+        return True;
+    }
+
+    /// 50% counter increments, 45% log appends, 5% random configuration
+    ev->op  = 'w';
+    pick    = rand() % 100;
+    if (pick < 50) {
+        ev->addr    = (vaddr)((rand() % SIM_COUNTERS) * 2);
+        ev->value   = model[ev->addr >> 1] + 1;
+    }
+    else if (pick < 95) {
+        ev->addr    = (vaddr)((SIM_LOGBASE + gen_log) * 2);
+        ev->value   = (ot_u16)rand();
+        gen_log     = (gen_log + 1) % SIM_LOGWORDS;
+    }
+    else {
+        ev->addr    = (vaddr)((rand() % SIM_WORDS) * 2);
+        ev->value   = (ot_u16)rand();
+    }
+    gen_count++;
+    return True;
+}
+
+
+static ot_bool sub_next(sim_event* ev) {
+    return (trace != NULL) ? sub_next_trace(ev) : sub_next_builtin(ev);
+}
+
+
+
+
+/** Checks
+  * ============================================================================
+  */
+static void sub_segv(int sig) {
+    siglongjmp(crash_jmp, 1);
+}
+
+
+static void sub_format() {
+    ot_int i;
+
+    flashsim.cut_countdown = 0;
+    vworm_format();
+    vworm_init();
+    for (i=0; i<SIM_WORDS; i++) {
+        model[i] = 0xFFFF;
+    }
+}
+
+
+/// Starts the core from Flash and checks it against the model.  The word at
+/// "pending" was being written, so it can have the old or the new value.
+/// Returns 0 if all is well, 1 if a word is wrong, 2 if the core crashed.
+static ot_int sub_restart(ot_int pending, ot_u16 new_value) {
+    volatile ot_int result = 0;
+    double          start;
+    ot_int          i;
+    ot_u16          value;
+
+    if (sigsetjmp(crash_jmp, 1) != 0) {
+        result = 2;
+    }
+    else {
+        signal(SIGSEGV, &sub_segv);
+        start = flashsim.clock_us;
+        vworm_init();
+        if ((flashsim.clock_us - start) > stats.max_init_us) {
+            stats.max_init_us = flashsim.clock_us - start;
+        }
+        for (i=0; i<SIM_WORDS; i++) {
+            value = vworm_read((vaddr)(i*2));
+            if ((i == pending) && (value == new_value)) {
+                model[i] = value;
+            }
+            if (value != model[i]) {
+                result = 1;
+            }
+        }
+    }
+    signal(SIGSEGV, SIG_DFL);
+
+    /// A core that lost data is started over, so later checks only find new
+    /// losses
+    if (result != 0) {
+        sub_format();
+    }
+    return result;
+}
+
+
+
+
+/** Runner
+  * ============================================================================
+  */
+static void sub_run(ot_u32 cut_interval) {
+    static sim_event ev;
+    volatile ot_int pending = -1;
+    double          start;
+    double          cut_rate;
+
+    ev.op       = 'w';
+    cut_rate    = (cut_interval == 0) ? 0.0 : (1.0 / (double)cut_interval);
+
+    if (setjmp(cut_jmp) != 0) {
+        ot_int result;
+        stats.cuts++;
+        result = sub_restart(pending, ev.value);
+        stats.lost     += (result == 1);
+        stats.crashes  += (result == 2);
+        pending         = -1;
+    }
+
+    while (sub_next(&ev)) {
+        /// Power cuts land at a random operation among the next 64
+        if ((cut_rate > 0.0) && (flashsim.cut_countdown == 0) && \
+            ((double)rand() < (cut_rate * (double)RAND_MAX))) {
+            flashsim.cut_countdown = 1 + (rand() % 64);
+        }
+
+        start = flashsim.clock_us;
+        switch (ev.op) {
+            case 'w':   pending = ev.addr >> 1;
+                        vworm_write(ev.addr, ev.value);
+                        model[pending]  = ev.value;
+                        pending         = -1;
+                        stats.writes++;
+                        stats.write_us += flashsim.clock_us - start;
+                        if ((flashsim.clock_us - start) > stats.max_write_us) {
+                            stats.max_write_us = flashsim.clock_us - start;
+                        }
+                        break;
+
+            case 'i':   while (vworm_journal_step()) {
+                            if ((flashsim.clock_us - start) > stats.max_idle_us) {
+                                stats.max_idle_us = flashsim.clock_us - start;
+                            }
+                            start = flashsim.clock_us;
+                        }
+                        stats.idles++;
+                        break;
+
+            case 'r':   vworm_save();
+                        stats.bad_reboots += (sub_restart(-1, 0) != 0);
+                        stats.reboots++;
+                        break;
+        }
+    }
+
+    /// Finish with an orderly reboot, which must not lose anything
+    flashsim.cut_countdown = 0;
+    vworm_save();
+    stats.bad_reboots += (sub_restart(-1, 0) != 0);
+}
+
+
+
+
+int main(int argc, char** argv) {
+    int     opt;
+    ot_int  i;
+    ot_u32  cut_interval = 0;
+    ot_u32  endurance   = 10000;
+    double  seconds     = 86400.0;
+    ot_u32  max_erases  = 0;
+    double  data_pages;
+    double  erase_amp;
+    double  years;
+    FILE*   csv         = NULL;
+
+    /// CC430 datasheet maximums
+    flashsim.program_us = 85;
+    flashsim.erase_us   = 32000;
+    flashsim.cut_jmp    = &cut_jmp;
+
+    while ((opt = getopt(argc, argv, "f:n:s:i:k:tp:e:E:T:c:")) != -1) {
+        switch (opt) {
+            case 'f':   trace = fopen(optarg, "r");
+                        if (trace == NULL) {
+                            perror(optarg);
+                            return 2;
+                        }
+                        break;
+
+            case 'n':   gen_writes          = atol(optarg);     break;
+            case 's':   srand(atoi(optarg));                    break;
+            case 'i':   gen_idle            = atol(optarg);     break;
+            case 'k':   cut_interval        = atol(optarg);     break;
+            case 't':   flashsim.torn       = True;             break;
+            case 'p':   flashsim.program_us = atol(optarg);     break;
+            case 'e':   flashsim.erase_us   = atol(optarg);     break;
+            case 'E':   endurance           = atol(optarg);     break;
+            case 'T':   seconds             = atof(optarg);     break;
+
+            case 'c':   csv = fopen(optarg, "a+");
+                        if (csv == NULL) {
+                            perror(optarg);
+                            return 2;
+                        }
+                        fseek(csv, 0, SEEK_END);
+                        if (ftell(csv) == 0) {
+                            fprintf(csv, "config,pages,fallows,page_size,writes,erases,erase_amp,"
+                                         "max_page_erases,mean_write_us,max_write_us,max_idle_us,"
+                                         "cuts,lost,crashes,lifetime_years\n");
+                        }
+                        break;
+
+            default:    fprintf(stderr, "Usage: %s [-f trace] [-n writes] [-s seed] [-i interval] "
+                                        "[-k interval] [-t] [-p program_us] [-e erase_us] "
+                                        "[-E endurance] [-T seconds] [-c results.csv]\n", argv[0]);
+                        return 2;
+        }
+    }
+
+    /// Start from erased Flash, and count the workload only
+    flashsim_reset();
+    sub_format();
+    for (i=0; i<FLASHSIM_PAGES; i++) {
+        flashsim.page_erases[i] = 0;
+    }
+    flashsim.erases     = 0;
+    flashsim.programs   = 0;
+    flashsim.clock_us   = 0.0;
+
+    sub_run(cut_interval);
+
+    /// Erase amplification: pages erased per page of data written
+    for (i=0; i<FLASHSIM_PAGES; i++) {
+        if (flashsim.page_erases[i] > max_erases) {
+            max_erases = flashsim.page_erases[i];
+        }
+    }
+    data_pages  = ((double)stats.writes * 2.0) / (double)FLASH_PAGE_SIZE;
+    erase_amp   = (data_pages > 0.0) ? ((double)flashsim.erases / data_pages) : 0.0;
+    years       = (max_erases == 0) ? 0.0 : \
+                  (((double)endurance / (double)max_erases) * seconds / (365.25*86400.0));
+
+    printf("config:         %s (%d pages, %d fallow, %d bytes each)\n",
+            SIM_NAME, FLASH_NUM_PAGES, FLASH_FS_FALLOWS, FLASH_PAGE_SIZE);
+    printf("workload:       %u writes, %u idles, %u reboots\n",
+            (unsigned)stats.writes, (unsigned)stats.idles, (unsigned)stats.reboots);
+    printf("flash:          %u programs, %u erases, erase amplification %.2f\n",
+            (unsigned)flashsim.programs, (unsigned)flashsim.erases, erase_amp);
+    printf("wear:           %u erases on the most-erased page, %.2f years at %u cycles\n",
+            (unsigned)max_erases, years, (unsigned)endurance);
+    printf("write latency:  mean %.0f us, max %.0f us\n",
+            (stats.writes == 0) ? 0.0 : (stats.write_us / stats.writes), stats.max_write_us);
+    printf("idle latency:   max %.0f us per step\n", stats.max_idle_us);
+    printf("recovery:       %u cuts%s, %u lost data, %u crashed, max init %.0f us\n",
+            (unsigned)stats.cuts, flashsim.torn ? " (torn)" : "",
+            (unsigned)stats.lost, (unsigned)stats.crashes, stats.max_init_us);
+    printf("errors:         %u 0->1 programs, %u bad addresses, %u bad reboots\n",
+            (unsigned)flashsim.violations, (unsigned)flashsim.faults, (unsigned)stats.bad_reboots);
+
+    if (csv != NULL) {
+        fprintf(csv, "%s,%d,%d,%d,%u,%u,%.3f,%u,%.1f,%.1f,%.1f,%u,%u,%u,%.2f\n",
+                SIM_NAME, FLASH_NUM_PAGES, FLASH_FS_FALLOWS, FLASH_PAGE_SIZE,
+                (unsigned)stats.writes, (unsigned)flashsim.erases, erase_amp,
+                (unsigned)max_erases,
+                (stats.writes == 0) ? 0.0 : (stats.write_us / stats.writes),
+                stats.max_write_us, stats.max_idle_us,
+                (unsigned)stats.cuts, (unsigned)stats.lost, (unsigned)stats.crashes, years);
+        fclose(csv);
+    }
+
+    /// Errors in the Flash driver usage, or losses without a power cut, are
+    /// failures.  Losses after a power cut are results.
+    return ((flashsim.violations != 0) || (flashsim.faults != 0) || (stats.bad_reboots != 0));
+}
@@ -0,0 +1,131 @@
+/*  Copyright 2026 OpenTag contributors
+  *
+  * Licensed under the OpenTag License, Version 1.0 (the "License");
+  * you may not use this file except in compliance with the License.
+  * You may obtain a copy of the License at
+  *
+  * http://www.indigresso.com/wiki/doku.php?id=opentag:license_1_0
+  *
+  * Unless required by applicable law or agreed to in writing, software
+  * distributed under the License is distributed on an "AS IS" BASIS,
+  * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  * See the License for the specific language governing permissions and
+  * limitations under the License.
+  */
+/**
+  * @file       /Supplements/host_config/platform_config.h
+  * @author     OpenTag contributors
+  * @version    V1.0
+  * @date       16 October 2026
+  * @brief      Host Platform shared by the host supplements
+  *
+  * A host "MCU" with no peripherals, and a stub radio.  The settings that a
+  * supplement changes are given a default with #ifndef, and the supplement
+  * sets them with -D in its Makefile.  HOST_CC_SUPPORT replaces CC_SUPPORT,
+  * for supplements that are built with GCC, but not as GCC firmware.
+  *
+  * Don't actually include this.  Include OT_platform.h instead.
+  ******************************************************************************
+  */
+
+#ifndef __PLATFORM_CONFIG_H
+#define __PLATFORM_CONFIG_H
+
+#include "build_config.h"
+
+
+#define PLATFORM_POSIX
+
+
+
+#ifdef HOST_CC_SUPPORT
+#   undef CC_SUPPORT
+#   define CC_SUPPORT   HOST_CC_SUPPORT
+#endif
+
+
+
+/// Macro settings: ENABLED, DISABLED, NOT_AVAILABLE
+#ifdef ENABLED
+#   undef ENABLED
+#endif
+#define ENABLED  1
+
+#ifdef DISABLED
+#   undef DISABLED
+#endif
+#define DISABLED  0
+
+#ifdef NOT_AVAILABLE
+#   undef NOT_AVAILABLE
+#endif
+#define NOT_AVAILABLE   DISABLED
+
+
+
+/// Host "MCU": no peripherals, so CRC and AES128 are done in SW
+#define MCU_FEATURE(VAL)                MCU_FEATURE_##VAL
+#define MCU_FEATURE_CRC                 DISABLED
+#define MCU_FEATURE_AES128              DISABLED
+#ifndef MCU_FEATURE_AES128_LITE
+#   define MCU_FEATURE_AES128_LITE      DISABLED
+#endif
+#define MCU_FEATURE_RADIODMA_TXBYTES    0
+#define MCU_FEATURE_RADIODMA_RXBYTES    0
+
+#define MCU_PARAM(VAL)                  MCU_PARAM_##VAL
+#ifndef MCU_PARAM_CRCSLICE
+#   define MCU_PARAM_CRCSLICE           8                       // SW CRC block engine: bytes per step (1, 4, 8)
+#endif
+
+#define PLATFORM_POINTER_SIZE           8
+
+
+
+/// Kernel timer: M2NP uses this for background frames
+#define OT_GPTIM_ERRDIV                 32
+
+
+
+/// VWORM geometry, like the CC430 boards: 8 pages of 512 bytes, 3 of them
+/// fallow (see veelite_core_posix.c)
+#ifndef FLASH_PAGE_SIZE
+#   define FLASH_PAGE_SIZE              512
+#endif
+#ifndef FLASH_NUM_PAGES
+#   define FLASH_NUM_PAGES              8
+#endif
+#ifndef FLASH_FS_FALLOWS
+#   define FLASH_FS_FALLOWS             3
+#endif
+#define FLASH_FS_ADDR                   0
+
+
+
+/// Stub Radio
+#define RF_FEATURE(VAL)                 RF_FEATURE_##VAL
+#ifndef RF_FEATURE_PN9
+#   define RF_FEATURE_PN9               DISABLED
+#endif
+#ifndef RF_FEATURE_CRC
+#   define RF_FEATURE_CRC               DISABLED
+#endif
+#ifndef RF_FEATURE_FEC
+#   define RF_FEATURE_FEC               DISABLED
+#endif
+#ifndef RF_FEATURE_SOFTBITS
+#   define RF_FEATURE_SOFTBITS          DISABLED
+#endif
+#define RF_FEATURE_FIFO                 ENABLED
+#define RF_FEATURE_TXFIFO_BYTES         1024
+#define RF_FEATURE_RXFIFO_BYTES         1024
+
+
+
+#define OS_FEATURE(VAL)                 DISABLED                // NO OS Featuresetting just yet
+#define OS_FEATURE_MEMCPY               DISABLED                //
+#define OS_FEATURE_MALLOC               DISABLED
+
+
+
+#endif
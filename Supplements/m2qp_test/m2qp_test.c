@@ -0,0 +1,389 @@
+/*  Copyright 2026 OpenTag contributors
+  *
+  * Licensed under the OpenTag License, Version 1.0 (the "License");
+  * you may not use this file except in compliance with the License.
+  * You may obtain a copy of the License at
+  *
+  * http://www.indigresso.com/wiki/doku.php?id=opentag:license_1_0
+  *
+  * Unless required by applicable law or agreed to in writing, software
+  * distributed under the License is distributed on an "AS IS" BASIS,
+  * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  * See the License for the specific language governing permissions and
+  * limitations under the License.
+  */
+/**
+  * @file       /Supplements/m2qp_test/m2qp_test.c
+  * @author     OpenTag contributors
+  * @version    V1.0
+  * @date       16 October 2026
+  * @brief      Random M2QP queries, checked against byte-wise references
+  *
+  * Each query is written to rxq the way it comes in a request, loaded with
+  * sub_load_query(), and run with m2qp_isf_comp() on a stub file, which is
+  * given to the query a few bytes at a time.  The result is checked against
+  * a simple model that compares the bytes one at a time:
+  * - Exact searches (threshold of length or length-1) run as Shift-And
+  *   (sub_search_start() and sub_load_search()), and they must give the
+  *   same number of hits as the correlation (sub_load_charcorrelation()),
+  *   which is also run on the same spans, and as the model.
+  * - Other searches run as the correlation, and must match the model.
+  * - Arithmetic queries are compiled into words (sub_compile_alu() and
+  *   sub_run_alu()), and they must give the same result as the byte-wise
+  *   comparison that they replaced.
+  * Tokens of 16 bytes are always in the mix.  Tokens of 17 bytes or more
+  * must fail, without a file being opened or LOCAL_U8 being written.
+  *
+  * Usage: m2qp_test [-s seed] [-n queries]
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "OT_types.h"
+#include "OT_config.h"
+#include "OT_platform.h"
+#include "buffers.h"
+#include "m2_network.h"
+#include "m2_transport.h"
+#include "queue.h"
+#include "system.h"
+#include "veelite.h"
+
+
+#define TEST_FILE_MAX       240
+#define TEST_TOKEN_MAX      16
+#define TEST_LOCAL          (sizeof(rx_buffer) - 32)    // LOCAL_U8(0) in rxq
+
+
+/// Not in m2_transport.h
+void    sub_load_query(void);
+ot_bool sub_search_start();
+ot_int  sub_load_search(ot_int* cursor, ot_u8* data, ot_int length);
+ot_int  sub_load_charcorrelation(ot_int* cursor, ot_u8* data, ot_int length);
+
+
+
+
+/** Stub platform, Veelite & network
+  * ============================================================================
+  * The file the query runs on is "file_data".  vl_series_next() gives it in
+  * spans of 1 to 40 bytes, and remembers them for the correlation re-run.
+  */
+static ot_u8    file_data[TEST_FILE_MAX];
+static ot_int   file_length;
+static ot_int   file_opens;
+static ot_int   span_length[TEST_FILE_MAX];
+static ot_int   spans;
+
+static ot_u8    tx_buffer[256];
+static ot_u8    rx_buffer[256];
+Queue           txq;
+Queue           rxq;
+m2np_struct     m2np;
+m2dll_struct    dll;
+
+void platform_memcpy(ot_u8* dest, ot_u8* src, ot_int length) {
+    memmove(dest, src, length);
+}
+
+ot_int vl_series_open(vlSERIES* it, ot_u8 is_series, ot_u8 isf_id,
+                      ot_int offset, ot_int window, id_tmpl* user_id) {
+    file_opens++;
+    spans       = 0;
+    it->genmask = 0;
+    it->offset  = (offset < file_length) ? offset : file_length;
+    it->window  = window;
+    return 0;
+}
+
+ot_int vl_series_next(vlSERIES* it) {
+    ot_int length = file_length - it->offset;
+
+    if (length > it->window) {
+        length = it->window;
+    }
+    if (length > 0) {
+        length  = 1 + (rand() % ((length < 40) ? length : 40));
+        it->span            = &file_data[it->offset];
+        it->offset         += length;
+        it->window         -= length;
+        span_length[spans++] = length;
+    }
+    return length;
+}
+
+void vl_series_close(vlSERIES* it) { }
+
+vlFILE* ISF_open(ot_u8 id, ot_u8 mod, id_tmpl* user_id)     { return NULL; }
+vlFILE* ISFS_open(ot_u8 id, ot_u8 mod, id_tmpl* user_id)    { return NULL; }
+vlFILE* ISF_open_su(ot_u8 id)                               { return NULL; }
+ot_u16  vl_read(vlFILE* fp, ot_uint offset)                 { return 0; }
+ot_u8   vl_close(vlFILE* fp)                                { return 0; }
+ot_u16  vl_read_block(vlFILE* fp, ot_uint offset, ot_uint length, ot_u8* data) { return 0; }
+ot_u8   ext_get_m2appflags()                                { return 0; }
+ot_u16  otutils_calc_timeout(ot_u8 timeout_code)            { return 0; }
+ot_bool m2np_idcmp(ot_int length, void* id)                 { return False; }
+void    m2np_header(m2session* session, ot_u8 addressing, ot_u8 nack) { }
+
+
+
+
+/** Queries
+  * ============================================================================
+  */
+static ot_u8    tmpl_code;
+static ot_int   tmpl_length;
+static ot_u8    tmpl_value[32];
+static ot_u8    tmpl_mask[32];
+static ot_int   tmpl_offset;
+
+static long     n_exact, n_corr, n_alu, n_long;
+
+
+static ot_int sub_run() {
+/// Puts the query in rxq the way a request has it, and runs it
+    ot_int i;
+
+    q_init(&rxq, rx_buffer, sizeof(rx_buffer));
+    q_writebyte(&rxq, (ot_u8)tmpl_length);
+    q_writebyte(&rxq, tmpl_code);
+    if (tmpl_code & M2QC_MASKED) {
+        for (i=0; i<tmpl_length; i++)   q_writebyte(&rxq, tmpl_mask[i]);
+    }
+    for (i=0; i<tmpl_length; i++)       q_writebyte(&rxq, tmpl_value[i]);
+    q_writebyte(&rxq, 0x20);            // comp_id
+    q_writebyte(&rxq, (ot_u8)tmpl_offset);
+
+    sub_load_query();
+    return m2qp_isf_comp(0, NULL);
+}
+
+
+static ot_u8 sub_mask(ot_int i) {
+    return (tmpl_code & M2QC_MASKED) ? tmpl_mask[i] : 0xFF;
+}
+
+
+static ot_int sub_model_search() {
+/// Windows of the file, from the offset, that correlate at the threshold
+    ot_int hits = 0;
+    ot_int start, i, c;
+
+    for (start=tmpl_offset; (start + tmpl_length) <= file_length; start++) {
+        for (i=0, c=0; i<tmpl_length; i++) {
+            c += ((file_data[start+i] & sub_mask(i)) == (tmpl_value[i] & sub_mask(i))) ? 1 : -1;
+        }
+        hits += (c >= (ot_int)(tmpl_code & M2QC_COR_THRMASK));
+    }
+    return (hits == 0) ? -1 : hits;
+}
+
+
+static ot_int sub_model_alu() {
+/// The byte-wise comparison that sub_run_alu() replaced
+    ot_int i, j, k;
+
+    for (i=0; i<tmpl_length; i++) {
+        j = sub_mask(i) & tmpl_value[i];
+        k = sub_mask(i) & file_data[tmpl_offset+i];
+        if (j != k) {
+            switch (tmpl_code & 0x1F) {
+                case 0: return 0;
+                case 1: return -1;
+                case 2:
+                case 3: return (j < k) - 1;
+                case 4:
+                case 5: return (j > k) - 1;
+                default: return -1;
+            }
+        }
+    }
+    return ((ot_int)tmpl_code & 1) - 1;
+}
+
+
+static ot_int sub_correlation_hits() {
+/// Runs the correlation on the spans that the last query was given
+    ot_int i;
+    ot_int cursor   = 0;
+    ot_int hits     = 0;
+    ot_u8* data     = &file_data[tmpl_offset];
+
+    sub_search_start();
+    for (i=0; i<spans; data+=span_length[i], i++) {
+        hits += sub_load_charcorrelation(&cursor, data, span_length[i]);
+    }
+    return (hits == 0) ? -1 : hits;
+}
+
+
+static void sub_make_file() {
+/// A small alphabet, so that searches hit
+    ot_int i;
+    file_length = 20 + (rand() % (TEST_FILE_MAX - 19));
+    for (i=0; i<file_length; i++) {
+        file_data[i] = (ot_u8)("abcd"[rand() & 3] ^ ((rand() % 13) == 0));
+    }
+}
+
+
+static void sub_make_token(ot_int length, ot_u8 code) {
+/// Usually a piece of the file, so that there is something to find.  Masks
+/// are a mix of all-ones, nibbles, zero and random bytes.
+    static const ot_u8 masks[] = { 0xFF, 0xFF, 0xFF, 0xF0, 0x0F, 0x00, 0xDF };
+    ot_int i, from;
+
+    tmpl_code   = code;
+    tmpl_length = length;
+    tmpl_offset = rand() % (file_length - length + 1);
+    from        = tmpl_offset + (rand() % (file_length - tmpl_offset - length + 1));
+    for (i=0; i<length; i++) {
+        tmpl_value[i]   = (rand() & 3) ? file_data[from+i] : (ot_u8)rand();
+        tmpl_mask[i]    = (rand() & 7) ? masks[rand() % sizeof(masks)] : (ot_u8)rand();
+    }
+    if (code & M2QC_MASKED) {
+        return;
+    }
+    for (i=0; i<length; i++) {
+        tmpl_mask[i] = 0xFF;
+    }
+}
+
+
+static ot_int sub_token_length() {
+/// 16 bytes one time in four
+    return (rand() & 3) ? (1 + (rand() % TEST_TOKEN_MAX)) : TEST_TOKEN_MAX;
+}
+
+
+static int sub_fail(const char* what, ot_int got, ot_int expected) {
+    ot_int i;
+    fprintf(stderr, "%s: got %d, expected %d\n  code %02X length %d offset %d\n  value",
+            what, got, expected, tmpl_code, tmpl_length, tmpl_offset);
+    for (i=0; i<tmpl_length; i++)   fprintf(stderr, " %02X", tmpl_value[i]);
+    fprintf(stderr, "\n  mask ");
+    for (i=0; i<tmpl_length; i++)   fprintf(stderr, " %02X", sub_mask(i));
+    fprintf(stderr, "\n");
+    return 1;
+}
+
+
+static int sub_check_search() {
+    ot_int  length  = sub_token_length();
+    ot_u8   masked  = (rand() & 1) ? M2QC_MASKED : 0;
+    ot_int  thr, got, model;
+
+    /// Mostly exact thresholds, which run as Shift-And
+    thr = (rand() & 3) ? (length - (rand() & 1)) : (rand() % (length + 1));
+    if (thr < 0) thr = 0;
+    sub_make_token(length, (ot_u8)(M2QC_COR_SEARCH | masked | thr));
+
+    got     = sub_run();
+    model   = sub_model_search();
+    if (got != model) {
+        return sub_fail("search does not match the model", got, model);
+    }
+    if (thr >= (length - 1)) {
+        n_exact++;
+        model = sub_correlation_hits();
+        if (got != model) {
+            return sub_fail("Shift-And does not match the correlation", got, model);
+        }
+    }
+    else {
+        n_corr++;
+    }
+    return 0;
+}
+
+
+static int sub_check_alu() {
+/// The file gets the token (as masked), and sometimes a change in one byte,
+/// so every outcome of every code is tested.
+    ot_int  length  = sub_token_length();
+    ot_u8   masked  = (rand() & 1) ? M2QC_MASKED : 0;
+    ot_int  got, model, i;
+
+    sub_make_token(length, (ot_u8)(M2QC_ALU | masked | (rand() % 6)));
+    for (i=0; i<length; i++) {
+        file_data[tmpl_offset+i] = (tmpl_value[i] & sub_mask(i)) | (file_data[tmpl_offset+i] & ~sub_mask(i));
+    }
+    if (rand() & 3) {
+        file_data[tmpl_offset + (rand() % length)] += (ot_u8)((rand() & 1) ? 1 : -1);
+    }
+    n_alu++;
+
+    got     = sub_run();
+    model   = sub_model_alu();
+    return (got != model) ? sub_fail("ALU does not match the byte-wise compare", got, model) : 0;
+}
+
+
+static int sub_check_long() {
+/// Tokens longer than 16 bytes fail before anything is loaded
+    static ot_u8 codes[] = { M2QC_COR_SEARCH|17, M2QC_COR_SEARCH|M2QC_MASKED|10,
+                             M2QC_ALU_EQ, M2QC_ALU_GTE|M2QC_MASKED };
+    ot_u8   canary[32];
+    ot_int  length, got;
+
+    for (length=TEST_TOKEN_MAX+1; length<=32; length+=(length < 20) ? 1 : 4) {
+        file_length = TEST_FILE_MAX;
+        sub_make_token(length, codes[rand() & 3]);
+        memset(canary, 0x5A, sizeof(canary));
+        memset(&rx_buffer[TEST_LOCAL], 0x5A, 32);
+        file_opens = 0;
+        n_long++;
+
+        got = sub_run();
+        if (got != -1) {
+            return sub_fail("long token does not fail", got, -1);
+        }
+        if ((file_opens != 0) || (memcmp(&rx_buffer[TEST_LOCAL], canary, 32) != 0)) {
+            return sub_fail("long token loaded data", file_opens, 0);
+        }
+    }
+    return 0;
+}
+
+
+
+
+int main(int argc, char** argv) {
+    int     opt;
+    long    n       = 20000;
+    long    i;
+    int     fails   = 0;
+    unsigned seed   = 1;
+
+    while ((opt = getopt(argc, argv, "s:n:")) != -1) {
+        switch (opt) {
+            case 's':   seed = (unsigned)atoi(optarg);  break;
+            case 'n':   n = atol(optarg);               break;
+            default:    fprintf(stderr, "Usage: %s [-s seed] [-n queries]\n", argv[0]);
+                        return 2;
+        }
+    }
+    srand(seed);
+    q_init(&txq, tx_buffer, sizeof(tx_buffer));
+
+    for (i=0; (i<n) && (fails == 0); i++) {
+        sub_make_file();
+        fails += (rand() & 1) ? sub_check_search() : sub_check_alu();
+        if ((i & 255) == 0) {
+            fails += sub_check_long();
+        }
+    }
+
+    printf("%ld queries: %ld exact searches, %ld correlations, %ld ALU, %ld too long\n",
+            i, n_exact, n_corr, n_alu, n_long);
+    if (fails != 0) {
+        printf("FAILED (seed %u)\n", seed);
+        return 1;
+    }
+    printf("PASS\n");
+    return 0;
+}
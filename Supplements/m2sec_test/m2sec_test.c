@@ -0,0 +1,392 @@
+/*  Copyright 2026 OpenTag contributors
+  *
+  * Licensed under the OpenTag License, Version 1.0 (the "License");
+  * you may not use this file except in compliance with the License.
+  * You may obtain a copy of the License at
+  *
+  * http://www.indigresso.com/wiki/doku.php?id=opentag:license_1_0
+  *
+  * Unless required by applicable law or agreed to in writing, software
+  * distributed under the License is distributed on an "AS IS" BASIS,
+  * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  * See the License for the specific language governing permissions and
+  * limitations under the License.
+  */
+/**
+  * @file       /Supplements/m2sec_test/m2sec_test.c
+  * @author     OpenTag contributors
+  * @version    V1.0
+  * @date       16 October 2026
+  * @brief      TX -> RX round trip of M2NP frames with DLLS and NLS
+  *
+  * Frames are built with m2np_header() and m2np_footer(), as a request would
+  * be, copied to rxq (with a dummy CRC), and parsed with network_route_ff().
+  * The transport layer is a stub that keeps the payload it is given, so each
+  * check knows whether the frame got through and what it decrypted to.  The
+  * same node sends and receives, which is fine for the network layer: the
+  * only shared state is the frame counter (TX) and the replay table (RX).
+  *
+  * Every check is run, and the program exits with 1 if any of them fails.
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "OT_types.h"
+#include "OT_config.h"
+#include "OT_platform.h"
+#include "auth.h"
+#include "buffers.h"
+#include "m2_network.h"
+#include "queue.h"
+#include "session.h"
+#include "veelite.h"
+
+
+#define TEST_SUBNET     0xF5
+#define TEST_PAYLOAD    21
+
+
+/** Stub platform, ISF & upper layers
+  * ============================================================================
+  * Every ISF is 16 bytes of "stub_isf".  ISF 1 (device_features) starts with
+  * the UID of the device, the key files hold the AES keys, and the frame 
+  * counter file holds the saved TX counter.
+  */
+static ot_u8    stub_isf[256][16];
+static ot_u8    stub_payload[256];
+static ot_int   stub_length;            // -1 if the frame did not get through
+
+static ot_u8    tx_buffer[256];
+static ot_u8    rx_buffer[256];
+Queue           txq;
+Queue           rxq;
+Queue           dir_out;
+
+void platform_memcpy(ot_u8* dest, ot_u8* src, ot_int length) {
+    memmove(dest, src, length);
+}
+
+void platform_rand(ot_u8* rand_out, ot_int bytes_out) {
+    while (bytes_out-- > 0) {
+        *rand_out++ = (ot_u8)rand();
+    }
+}
+
+vlFILE* ISF_open_su(ot_u8 id) {
+    return (vlFILE*)stub_isf[id];
+}
+
+ot_u16 vl_read(vlFILE* fp, ot_uint offset) {
+    return *(ot_u16*)&((ot_u8*)fp)[offset];
+}
+
+ot_u8 vl_write(vlFILE* fp, ot_uint offset, ot_u16 data) {
+    *(ot_u16*)&((ot_u8*)fp)[offset] = data;
+    return 0;
+}
+
+ot_u8 vl_close(vlFILE* fp) {
+    return 0;
+}
+
+ot_int m2qp_parse_frame(m2session* session) {
+/// Keeps the (decrypted) payload.  The MIC and CRC have been stripped from the
+/// length byte, so the payload ends there.
+    stub_length = (ot_int)(&rxq.front[rxq.front[0] + 1] - rxq.getcursor);
+    memcpy(stub_payload, rxq.getcursor, stub_length);
+    return -1;
+}
+
+m2session* session_new(ot_u16 new_counter, ot_u8 new_netstate, ot_u8 new_channel) {
+    return NULL;
+}
+
+void alp_proc(alp_record* in_rec, alp_record* out_rec, Queue* in_q, Queue* out_q,
+              id_tmpl* user_id) { }
+
+void network_sig_route(ot_int code, ot_int protocol) { }
+
+
+
+
+/** Frames
+  * ============================================================================
+  */
+typedef struct {
+    ot_u8   data[256];
+    ot_int  length;
+    ot_u8   payload[TEST_PAYLOAD];
+} frame_t;
+
+#define RX_REJECTED     0
+#define RX_OK           1
+#define RX_WRONG        2
+
+
+/// Builds a broadcast request, with DLLS and/or NLS, and keeps it in "frame"
+static void sub_tx(frame_t* frame, ot_bool dlls, ot_bool nls) {
+    m2session   s;
+    ot_int      i;
+
+    for (i=0; i<TEST_PAYLOAD; i++) {
+        frame->payload[i] = (ot_u8)rand();
+    }
+    memset(&s, 0, sizeof(s));
+    s.subnet    = TEST_SUBNET;
+    s.dialog_id = (ot_u8)rand();
+    s.flags     = dlls ? M2FI_DLLS : 0;
+
+    q_init(&txq, tx_buffer, sizeof(tx_buffer));
+    m2np_header(&s, (M2RT_BROADCAST | (nls ? M2AC_NLS : 0)), 0);
+    q_writestring(&txq, frame->payload, TEST_PAYLOAD);
+    m2np_footer(&s);
+
+    /// The whole frame, with a dummy CRC
+    frame->length = txq.front[0] + 1;
+    memset(frame->data, 0, sizeof(frame->data));
+    memcpy(frame->data, txq.front, txq.length);
+}
+
+
+/// Receives a frame.  Returns RX_OK if it got through with the payload that
+/// was sent, RX_WRONG if it got through with another payload, or RX_REJECTED.
+static ot_int sub_rx(frame_t* frame) {
+    m2session s;
+
+    memset(&s, 0, sizeof(s));
+    q_init(&rxq, rx_buffer, sizeof(rx_buffer));
+    memcpy(rx_buffer, frame->data, frame->length);
+    rxq.length  = frame->length;
+    stub_length = -1;
+
+    network_route_ff(&s);
+    if (stub_length < 0) {
+        return RX_REJECTED;
+    }
+    if ((stub_length == TEST_PAYLOAD) && \
+        (memcmp(stub_payload, frame->payload, TEST_PAYLOAD) == 0)) {
+        return RX_OK;
+    }
+    return RX_WRONG;
+}
+
+
+/// True if the payload is nowhere in the frame as it was sent
+static ot_bool sub_hidden(frame_t* frame) {
+    ot_int i;
+    for (i=0; i<=(frame->length - TEST_PAYLOAD); i++) {
+        if (memcmp(&frame->data[i], frame->payload, TEST_PAYLOAD) == 0) {
+            return False;
+        }
+    }
+    return True;
+}
+
+
+static int sub_check(ot_bool ok, const char* what) {
+    printf("%-56s %s\n", what, ok ? "ok" : "FAILED");
+    return (ok == False);
+}
+
+
+
+
+/** Checks
+  * ============================================================================
+  */
+static int sub_checks(ot_bool dlls, ot_bool nls, const char* name) {
+    frame_t old, now, bad;
+    char    what[80];
+    int     fails = 0;
+
+    sub_tx(&old, dlls, nls);
+    sprintf(what, "%s: round trip", name);
+    fails += sub_check((ot_bool)(sub_rx(&old) == RX_OK), what);
+
+    sprintf(what, "%s: encrypted on the air", name);
+    fails += sub_check(sub_hidden(&old), what);
+
+    sprintf(what, "%s: replay is rejected", name);
+    fails += sub_check((ot_bool)(sub_rx(&old) == RX_REJECTED), what);
+
+    /// A frame with a changed byte is rejected, and it does not move the
+    /// replay counter: the real frame still gets through afterwards
+    sub_tx(&now, dlls, nls);
+    bad = now;
+    bad.data[bad.length - 3] ^= 0x01;
+    sprintf(what, "%s: changed payload is rejected", name);
+    fails += sub_check((ot_bool)(sub_rx(&bad) == RX_REJECTED), what);
+
+    bad = now;
+    bad.data[dlls ? 12 : 14] ^= 0x80;            // MSB of the counter
+    sprintf(what, "%s: changed counter is rejected", name);
+    fails += sub_check((ot_bool)(sub_rx(&bad) == RX_REJECTED), what);
+
+    sprintf(what, "%s: next frame after the forgeries", name);
+    fails += sub_check((ot_bool)(sub_rx(&now) == RX_OK), what);
+
+    sprintf(what, "%s: older frame is rejected", name);
+    sub_tx(&now, dlls, nls);
+    fails += sub_check((ot_bool)(sub_rx(&old) == RX_REJECTED), what);
+
+    /// The counter can wrap.  A jump of more than 2^31 counts as older, so
+    /// the replay table is cleared first, and the sender is new again.
+    network_init();
+    m2np.sec.counter = 0xFFFFFFFF;
+    sub_tx(&old, dlls, nls);
+    sub_tx(&now, dlls, nls);
+    sprintf(what, "%s: counter wraps", name);
+    fails += sub_check((ot_bool)((sub_rx(&old) == RX_OK) && \
+                                 (sub_rx(&now) == RX_OK)), what);
+
+    return fails;
+}
+
+
+static ot_bool sub_newer(ot_u32 counter, ot_u32 last) {
+    return (ot_bool)((ot_s32)(counter - last) > 0);
+}
+
+
+static ot_u32 sub_saved() {
+    vlFILE* fp = ISF_open_su(ISF_ID(frame_counter));
+    return ((ot_u32)vl_read(fp, 0) << 16) | vl_read(fp, 2);
+}
+
+
+static void sub_set_sender(ot_u8 sender) {
+/// Changes the UID of the device, so frames come from another sender
+    stub_isf[1][7] = (ot_u8)(0xA7 ^ sender);
+}
+
+
+static int sub_check_senders() {
+/// Each sender has its own counter: a second device with a lower counter is
+/// not a replay.
+    frame_t a, b;
+    int     fails = 0;
+
+    m2np.sec.counter = 1000;
+    sub_tx(&a, True, False);
+    fails += sub_check((ot_bool)(sub_rx(&a) == RX_OK), "DLLS: sender A, counter 1000");
+
+    sub_set_sender(0x5A);
+    m2np.sec.counter = 10;
+    sub_tx(&b, True, False);
+    fails += sub_check((ot_bool)(sub_rx(&b) == RX_OK), "DLLS: sender B, counter 10");
+    sub_set_sender(0);
+
+    fails += sub_check((ot_bool)(sub_rx(&a) == RX_REJECTED), "DLLS: sender A replay is still rejected");
+    return fails;
+}
+
+
+
+
+static int sub_check_counter() {
+/// The TX counter is saved ahead of its use, and a reset starts past it: a
+/// peer that got frames before the reset still accepts the new ones.
+    security_struct peer_side;
+    frame_t         before, after;
+    ot_u32          used;
+    ot_bool         ahead;
+    ot_int          i;
+    int             fails = 0;
+
+    network_init();
+    sub_tx(&before, True, False);
+    fails += sub_check((ot_bool)(sub_rx(&before) == RX_OK), "Counter: frame before the reset");
+
+    ahead = True;
+    for (i=0; i<(OT_PARAM(M2SEC_SAVE_FRAMES) * 3); i++) {
+        sub_tx(&after, True, False);
+        ahead &= sub_newer(sub_saved(), m2np.sec.counter - 1);
+    }
+    fails += sub_check(ahead, "Counter: saved one stays ahead of the frames");
+
+    /// The reset clears the RX side too, so it is kept, as a peer would
+    used        = m2np.sec.counter - 1;
+    peer_side   = m2np.sec;
+    network_init();
+    fails += sub_check(sub_newer(m2np.sec.counter, used), "Counter: reset starts past the frames used");
+    fails += sub_check((ot_bool)(sub_saved() == (m2np.sec.counter + OT_PARAM(M2SEC_SAVE_FRAMES))), 
+                        "Counter: reset saves the counter ahead");
+
+    sub_tx(&after, True, False);
+    m2np.sec = peer_side;
+    fails += sub_check((ot_bool)(sub_rx(&after) == RX_OK), "Counter: frame after the reset is accepted");
+    return fails;
+}
+
+
+static int sub_check_replaced() {
+/// A sender that is pushed out of the replay table by others must not have
+/// its old frames accepted again.  The floor is per layer.
+    frame_t a1, a2, b, nls;
+    ot_int  i;
+    int     fails = 0;
+
+    network_init();
+    m2np.sec.counter = 5000;
+    sub_tx(&a1, True, False);
+    sub_tx(&a2, True, False);
+    fails += sub_check((ot_bool)((sub_rx(&a1) == RX_OK) && (sub_rx(&a2) == RX_OK)), 
+                        "Replaced: sender A, two frames");
+
+    for (i=1; i<=OT_PARAM(M2SEC_PEERS); i++) {
+        sub_set_sender((ot_u8)i);
+        m2np.sec.counter = 6000 + (i * 10);
+        sub_tx(&b, True, False);
+        fails += sub_check((ot_bool)(sub_rx(&b) == RX_OK), "Replaced: other sender");
+    }
+    sub_set_sender(0);
+
+    fails += sub_check((ot_bool)(sub_rx(&a1) == RX_REJECTED), "Replaced: sender A, old frame is rejected");
+    fails += sub_check((ot_bool)(sub_rx(&a2) == RX_REJECTED), "Replaced: sender A, last frame is rejected");
+
+    sub_tx(&a1, True, False);
+    fails += sub_check((ot_bool)(sub_rx(&a1) == RX_OK), "Replaced: sender A, new frame is accepted");
+
+    /// The NLS layer has no floor yet
+    sub_set_sender(0x33);
+    m2np.sec.counter = 10;
+    sub_tx(&nls, False, True);
+    sub_set_sender(0);
+    fails += sub_check((ot_bool)(sub_rx(&nls) == RX_OK), "Replaced: NLS sender, lower counter");
+    return fails;
+}
+
+
+
+
+int main(int argc, char** argv) {
+    ot_int  i;
+    int     fails = 0;
+
+    srand(1);
+    for (i=0; i<16; i++) {
+        stub_isf[1][i]                                  = (ot_u8)(0xA0 + i);
+        stub_isf[ISF_ID(root_authentication_key)][i]    = (ot_u8)(0x10 + i);
+        stub_isf[ISF_ID(user_authentication_key)][i]    = (ot_u8)(0x40 + i);
+    }
+
+    auth_init();
+    network_init();
+
+    fails += sub_checks(True,  False, "DLLS");
+    fails += sub_checks(False, True,  "NLS");
+    fails += sub_checks(True,  True,  "DLLS+NLS");
+    fails += sub_check_senders();
+    fails += sub_check_counter();
+    fails += sub_check_replaced();
+
+    if (fails != 0) {
+        printf("%d checks FAILED\n", fails);
+        return 1;
+    }
+    printf("PASS\n");
+    return 0;
+}
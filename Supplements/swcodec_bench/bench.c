@@ -0,0 +1,771 @@
+/*  Copyright 2026 OpenTag contributors
+  *
+  * Licensed under the OpenTag License, Version 1.0 (the "License");
+  * you may not use this file except in compliance with the License.
+  * You may obtain a copy of the License at
+  *
+  * http://www.indigresso.com/wiki/doku.php?id=opentag:license_1_0
+  *
+  * Unless required by applicable law or agreed to in writing, software
+  * distributed under the License is distributed on an "AS IS" BASIS,
+  * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  * See the License for the specific language governing permissions and
+  * limitations under the License.
+  */
+/**
+  * @file       /Supplements/swcodec_bench/bench.c
+  * @author     OpenTag contributors
+  * @version    V1.0
+  * @date       16 October 2026
+  * @brief      Host benchmark for the Mode 2 SW encoder & decoder
+  *
+  * Links otlib/m2_encode.c and otlib/crc16.c against a stub radio that just
+  * reads and writes a RAM buffer, and then times the encoder and decoder for
+  * each frame size.  Which m2_encoder[] / m2_decoder[] variants exist depends
+  * on the RF_FEATURE and M2_FEATURE settings this is built with (see the
+  * Makefile).  Each frame is round-tripped and checked before it is timed,
+  * so the benchmark also fails (exit 1) if a codec change breaks the frame.
+  * With M2_FEATURE(BLOCKCODEC), each frame is also round-tripped through the
+  * block codec, which must give the same bytes as the streaming encoder.
+  *
+  * The FEC decoders also have to match the reference decoder on the noisy
+  * frames in fec_vectors.h, hard and soft, and "-g" writes that file (see
+  * sub_write_vectors()).  Soft builds also check that soft decision decodes
+  * more frames than hard decision on a noisy channel.
+  *
+  * Every build checks the SW CRC engine it was built with (CRC_SLICE and 
+  * PCLMUL, see otlib/crc16.c) against a bitwise CRC, over many lengths and
+  * alignments, both in one block and split in two.
+  *
+  * Usage: bench [-t ms] [-c results.csv] [-g fec_vectors.h]
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#   include <x86intrin.h>
+#   define BENCH_CYCLES()   ((double)__rdtsc())
+#else
+#   define BENCH_CYCLES()   (0.0)
+#endif
+
+#include "OT_types.h"
+#include "OT_config.h"
+#include "OT_platform.h"
+#include "buffers.h"
+#include "queue.h"
+#include "crc16.h"
+#include "m2_encode.h"
+#include "radio.h"
+
+
+#ifndef BENCH_NAME
+#   define BENCH_NAME   "default"
+#endif
+
+#ifndef CRC_SLICE                   // as crc16.c picks it
+#   ifdef MCU_PARAM_CRCSLICE
+#       define CRC_SLICE    MCU_PARAM(CRCSLICE)
+#   else
+#       define CRC_SLICE    1
+#   endif
+#endif
+#if (defined(__PCLMUL__) && defined(__SSSE3__))
+#   define BENCH_CRC    "PCLMUL"
+#elif (CRC_SLICE == 1)
+#   define BENCH_CRC    "bytewise"
+#else
+#   define BENCH_CRC    "sliced"
+#endif
+
+#define AIR_BYTES   1024
+
+Queue   txq;
+Queue   rxq;
+ot_u8   txbuf[300];
+ot_u8   rxbuf[300];
+
+static ot_u8    bench_air[AIR_BYTES];
+static ot_int   air_put;
+static ot_int   air_get;
+static ot_int   air_end;
+static const char* air_levels;      // noisy soft levels for bench_air, or NULL
+static ot_u32   bench_rand = 1;
+
+static const ot_int frame_sizes[] = { 8, 16, 32, 64, 128, 255, 256 };
+
+
+
+
+/** Stub platform & radio
+  * ============================================================================
+  * The radio writes to and reads from "bench_air", which has room for any frame, so
+  * the codec never stalls.  putfourbytes/getfourbytes match the byte order of
+  * the real drivers on a little endian MCU.
+  */
+void otutils_null(void) { }
+
+void platform_memcpy(ot_u8* dest, ot_u8* src, ot_int length) {
+    memmove(dest, src, length);
+}
+
+void radio_putbyte(ot_u8 databyte) {
+    bench_air[air_put++] = databyte;
+}
+
+void radio_putfourbytes(ot_u8* data) {
+    bench_air[air_put++] = data[3];
+    bench_air[air_put++] = data[2];
+    bench_air[air_put++] = data[1];
+    bench_air[air_put++] = data[0];
+}
+
+ot_u8 radio_getbyte() {
+    return bench_air[air_get++];
+}
+
+void radio_getfourbytes(ot_u8* data) {
+    memcpy(data, &bench_air[air_get], 4);
+    air_get += 4;
+}
+
+void radio_getfourbytes_soft(ot_u8* soft) {
+/// From air_levels if it is set, else hard bits at full confidence
+    ot_int k, b;
+    for (k=0; k<4; k++) {
+        for (b=0; b<8; b++) {
+            if (air_levels != NULL) {
+                soft[(k<<3) + 7 - b] = (ot_u8)(air_levels[((air_get+k)<<3) + 7 - b] - '0');
+            }
+            else {
+                soft[(k<<3) + 7 - b] = ((bench_air[air_get+k] >> b) & 1) ? 7 : 0;
+            }
+        }
+    }
+    air_get += 4;
+}
+
+ot_bool radio_txopen()      { return (ot_bool)(air_put < AIR_BYTES); }
+ot_bool radio_txopen_4()    { return (ot_bool)(air_put <= (AIR_BYTES-4)); }
+ot_bool radio_rxopen()      { return (ot_bool)(air_get < air_end); }
+ot_bool radio_rxopen_4()    { return (ot_bool)(air_get <= (air_end-4)); }
+
+
+
+
+/** Codec names
+  * ============================================================================
+  * These follow the m2_encoder[] / m2_decoder[] selection in m2_encode.c
+  */
+#if ((RF_FEATURE(CRC) == ENABLED) && (RF_FEATURE(PN9) == ENABLED))
+#   define NAME_PLAIN_ENC   "HW"
+#   define NAME_PLAIN_DEC   "HW"
+#elif (RF_FEATURE(PN9) == ENABLED)
+#   define NAME_PLAIN_ENC   "HWCRC"
+#   define NAME_PLAIN_DEC   "HWCRC"
+#else
+#   define NAME_PLAIN_ENC   "PN9"
+#   define NAME_PLAIN_DEC   "PN9"
+#endif
+
+#define BENCH_FEC   ( (RF_FEATURE(FEC) != ENABLED) \
+                    && (M2_FEATURE(FECTX) == ENABLED) && (M2_FEATURE(FECRX) == ENABLED) )
+
+#if (M2_FEATURE(FECTXTABLE) == ENABLED)
+#   define NAME_FEC_ENC     "FECTBL"
+#else
+#   define NAME_FEC_ENC     "FEC"
+#endif
+#if (M2_FEATURE(FECRXACS) == ENABLED)
+#   define NAME_FEC_DEC0    "FECACS"
+#else
+#   define NAME_FEC_DEC0    "FEC"
+#endif
+#define BENCH_SOFT  ( (M2_FEATURE(FECSOFT) == ENABLED) && (RF_FEATURE(SOFTBITS) == ENABLED) )
+
+#if (BENCH_SOFT)
+#   define NAME_FEC_DEC     NAME_FEC_DEC0 "-soft"
+#else
+#   define NAME_FEC_DEC     NAME_FEC_DEC0
+#endif
+
+/// The block codec does FEC only with the table encoder and ACS decoder.  Its
+/// output matches the streaming encoder when SW does PN9 (and CRC).
+#define BLOCK_FEC   ( BENCH_FEC && (M2_FEATURE(FECTXTABLE) == ENABLED) \
+                    && (M2_FEATURE(FECRXACS) == ENABLED) )
+#define BLOCK_AIR   ( (RF_FEATURE(PN9) != ENABLED) && (RF_FEATURE(CRC) != ENABLED) )
+
+
+
+
+/** Benchmark
+  * ============================================================================
+  */
+typedef struct {
+    double  ns;
+    double  cycles;
+    long    frames;
+} result_t;
+
+
+static double sub_now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((double)ts.tv_sec * 1e9) + (double)ts.tv_nsec;
+}
+
+
+static ot_u32 sub_rand() {
+/// xorshift32, so the frames and the noise are the same on every host
+    bench_rand ^= bench_rand << 13;
+    bench_rand ^= bench_rand >> 17;
+    bench_rand ^= bench_rand << 5;
+    return bench_rand;
+}
+
+
+static void sub_load_frame(ot_int frame_bytes, ot_bool fec, unsigned seed) {
+/// frame_bytes is the whole frame, including length byte and CRC
+    ot_int i;
+
+    q_init(&txq, txbuf, sizeof(txbuf));
+    txq.options.ubyte[UPPER]    = 1;            // CRC
+    txq.options.ubyte[LOWER]    = (ot_u8)fec;
+    txq.front[0]                = (ot_u8)(frame_bytes - 1);
+
+    bench_rand = seed | 1;
+    for (i=1; i<(frame_bytes-2); i++) {
+        txq.front[i] = (ot_u8)sub_rand();
+    }
+    txq.length      = frame_bytes - 2;
+    txq.putcursor   = &txq.front[txq.length];
+}
+
+
+static void sub_encode() {
+    air_put = 0;
+    txq.getcursor   = txq.front;
+    txq.length      = txq.front[0] - 1;
+    em2_encode_newpacket();
+    em2_encode_newframe();
+    while (em2.bytes > 0) {
+        em2_encode_data();
+    }
+    air_end = air_put;
+}
+
+
+static void sub_decode(ot_bool fec) {
+    air_get = 0;
+    q_init(&rxq, rxbuf, sizeof(rxbuf));
+    rxq.options.ubyte[LOWER] = (ot_u8)fec;
+    em2_decode_newpacket();
+    em2_decode_newframe();
+    while ((em2.bytes > 0) && radio_rxopen()) {
+        em2_decode_data();
+    }
+}
+
+
+static ot_bool sub_check(ot_int frame_bytes, ot_bool fec) {
+/// With a SW CRC the receiver checks it; with a HW CRC, the data is compared
+    if (memcmp(rxq.front, txq.front, frame_bytes-2) != 0) {
+        return False;
+    }
+    if (fec || (RF_FEATURE(CRC) != ENABLED)) {
+        return (ot_bool)(em2_crc_check() != 0);
+    }
+    return True;
+}
+
+
+#if (M2_FEATURE(BLOCKCODEC) == ENABLED)
+static ot_bool sub_check_block(ot_int frame_bytes, ot_bool fec) {
+/// Round trip through em2_encode_block() and em2_decode_block().  Call it
+/// after sub_encode(), so the streaming encoder's output is in bench_air.
+    static ot_u8    blk_air[AIR_BYTES];
+    static ot_u8    blk_dec[300];
+    ot_int          enc_bytes;
+    ot_int          dec_bytes;
+    
+    if (fec && !BLOCK_FEC) {
+        return True;
+    }
+    txq.front[0]    = (ot_u8)(frame_bytes - 1);
+    enc_bytes       = em2_encode_block(blk_air, txq.front, fec);
+    if (enc_bytes < 0) {
+        return False;
+    }
+    if ((BLOCK_AIR || fec) && \
+        ((enc_bytes != air_end) || (memcmp(blk_air, bench_air, enc_bytes) != 0))) {
+        return False;
+    }
+    
+    dec_bytes = em2_decode_block(blk_dec, blk_air, enc_bytes, fec);
+    if ((dec_bytes != frame_bytes) || (memcmp(blk_dec, txq.front, frame_bytes-2) != 0)) {
+        return False;
+    }
+    
+    /// Length bytes that leave no room for the CRC must be rejected
+    for (blk_dec[0]=0; blk_dec[0]<2; blk_dec[0]++) {
+        if (em2_encode_block(blk_air, blk_dec, fec) != -1) {
+            return False;
+        }
+    }
+    return True;
+}
+#endif
+
+
+
+
+/** Noisy FEC vectors
+  * ============================================================================
+  * Each vector is an FEC frame as received over a noisy channel, as 3 bit soft
+  * levels, with what the reference decoder (em2_decode_data_FEC) made of it
+  * with hard and with soft decision.  The hard bits are the levels 4-7.  Every
+  * FEC decoder must give exactly the same bytes and CRC result, whether or not
+  * the noise was too much for it.
+  */
+typedef struct {
+    ot_int      frame_bytes;    // frame that was sent, with length byte and CRC
+    ot_int      sigma;          // channel noise, in hundredths of the signal
+    unsigned    seed;           // frame data and noise seed
+    const char* levels;         // '0'-'7', 8 per air byte, MSB first
+    const char* hard;           // hard decision output (hex), and its CRC check
+    ot_bool     hard_crc;
+    const char* soft;           // soft decision output (hex), and its CRC check
+    ot_bool     soft_crc;
+} fecvector_t;
+
+#if (BENCH_FEC)
+#include "fec_vectors.h"
+
+static const ot_int vector_sizes[]  = { 8, 32, 64, 128 };
+static const ot_int vector_sigmas[] = { 30, 50, 60, 75 };
+
+
+static void sub_slice(const char* levels) {
+/// Puts the hard bits of the levels in bench_air
+    ot_int i;
+    air_end = (ot_int)(strlen(levels) >> 3);
+    for (i=0; i<air_end; i++) {
+        ot_int b;
+        bench_air[i] = 0;
+        for (b=0; b<8; b++) {
+            bench_air[i] = (bench_air[i] << 1) | (levels[(i<<3)+b] >= '4');
+        }
+    }
+}
+
+
+static void sub_channel(char* levels, ot_int air_bytes, ot_int sigma) {
+/// Same noise model as the named_pipe radio (radio_SIM.c): each bit of
+/// bench_air is sent as +/-100, gets Gaussian noise, and is quantized to 3 bits.
+/// bench_air gets the hard bits.
+    ot_int i, n, level;
+    
+    for (i=0; i<(air_bytes<<3); i++) {
+        level = ((bench_air[i>>3] << (i&7)) & 0x80) ? 100 : -100;
+        for (n=0; n<12; n++) {
+            level += (sigma * (ot_int)((sub_rand() % 1001) - 500)) / 1000;
+        }
+        level = ((level + 100) * 7 + 100) / 200;
+        if (level < 0)      level = 0;
+        else if (level > 7) level = 7;
+        levels[i] = (char)('0' + level);
+    }
+    levels[i] = 0;
+    sub_slice(levels);
+}
+
+
+static ot_bool sub_match(const char* hex, ot_bool hex_crc, ot_u8* data, ot_int length, ot_bool crc) {
+    ot_int i;
+    if (((ot_int)strlen(hex) != (length<<1)) || (hex_crc != crc)) {
+        return False;
+    }
+    for (i=0; i<length; i++) {
+        unsigned byte;
+        sscanf(&hex[i<<1], "%2x", &byte);
+        if (byte != data[i]) {
+            return False;
+        }
+    }
+    return True;
+}
+
+
+static void sub_decode_levels(const char* levels) {
+/// Soft decoders get the levels, hard decoders get the hard bits.  With NULL,
+/// the soft decoders get the hard bits at full confidence.
+    txq.options.ubyte[LOWER] = 1;   // em2_decode_newpacket() looks at txq
+    air_levels = levels;
+    sub_decode(True);
+    air_levels = NULL;
+}
+
+
+static int sub_check_vectors() {
+    ot_int  i;
+#   if (BENCH_SOFT)
+    ot_int  recovered = 0;
+#   endif
+    
+    for (i=0; i<(ot_int)(sizeof(fec_vectors)/sizeof(fecvector_t)); i++) {
+        const fecvector_t* v = &fec_vectors[i];
+        const char* fail = NULL;
+        
+        sub_slice(v->levels);
+        sub_decode_levels(NULL);
+        if (sub_match(v->hard, v->hard_crc, rxq.front, rxq.length, em2_crc_check()) == False) {
+            fail = "hard";
+        }
+#       if (BENCH_SOFT)
+        sub_decode_levels(v->levels);
+        if ((fail == NULL) && \
+            (sub_match(v->soft, v->soft_crc, rxq.front, rxq.length, em2_crc_check()) == False)) {
+            fail = "soft";
+        }
+        recovered += (v->soft_crc && !v->hard_crc);
+#       endif
+#       if (M2_FEATURE(BLOCKCODEC) == ENABLED) && (BLOCK_FEC)
+        {   static ot_u8 blk_dec[300];
+            ot_int dec_bytes = em2_decode_block(blk_dec, bench_air, air_end, True);
+            if ((fail == NULL) && ((dec_bytes == -2) || 
+                (sub_match(v->hard, v->hard_crc, blk_dec, (ot_int)blk_dec[0]+1, (dec_bytes >= 0)) == False))) {
+                fail = "block";
+            }
+        }
+#       endif
+        if (fail != NULL) {
+            fprintf(stderr, "%s: %s decoder differs from the reference on FEC vector %d "
+                            "(%d bytes, sigma %d)\n", BENCH_NAME, fail, i, v->frame_bytes, v->sigma);
+            return -1;
+        }
+    }
+    
+    printf("%-12s %d noisy FEC vectors match the reference", BENCH_NAME, i);
+#   if (BENCH_SOFT)
+    printf(" (soft decision recovers %d that hard decision loses)", recovered);
+#   endif
+    printf("\n");
+    return 0;
+}
+
+
+#if (BENCH_SOFT)
+static int sub_check_softgain() {
+/// Sends random 64 byte frames through the noise model at sigma 0.60, where
+/// hard decision loses about half of them, and decodes each one both ways.
+/// Soft decision has to recover more of them, including every one that hard
+/// decision recovers.
+    static char levels[(AIR_BYTES<<3) + 1];
+    ot_int  i;
+    ot_int  hard_ok = 0;
+    ot_int  soft_ok = 0;
+    ot_int  soft_lost = 0;
+    
+    for (i=0; i<200; i++) {
+        ot_bool hard_crc, soft_crc;
+        sub_load_frame(64, True, (unsigned)(0x50F7 + i));
+        sub_encode();
+        sub_channel(levels, air_end, 60);
+        
+        sub_decode_levels(NULL);
+        hard_crc    = (ot_bool)(em2_crc_check() && (memcmp(rxq.front, txq.front, 62) == 0));
+        sub_decode_levels(levels);
+        soft_crc    = (ot_bool)(em2_crc_check() && (memcmp(rxq.front, txq.front, 62) == 0));
+        hard_ok    += hard_crc;
+        soft_ok    += soft_crc;
+        soft_lost  += (hard_crc && !soft_crc);
+    }
+    
+    printf("%-12s sigma 0.60: soft decision decodes %d/200 frames, hard decision %d/200\n",
+            BENCH_NAME, soft_ok, hard_ok);
+    if ((soft_ok <= hard_ok) || (soft_lost != 0)) {
+        fprintf(stderr, "%s: soft decision does no better than hard decision\n", BENCH_NAME);
+        return -1;
+    }
+    return 0;
+}
+#endif
+
+
+static int sub_write_vectors(const char* path) {
+/// Makes a vector for each size and noise level, and writes fec_vectors.h.
+/// The expected outputs come from this build's decoder, so build it with the
+/// reference decoder and soft bits (bench_softref).  Vectors whose length byte 
+/// gets lost are skipped, because the decoders don't have to agree on where
+/// a frame like that ends.
+    FILE*   out;
+    ot_int  i, j, k;
+    static char levels[(AIR_BYTES<<3) + 1];
+    static char hard[600];
+    ot_bool hard_crc;
+    
+    if ((M2_FEATURE(FECRXACS) == ENABLED) || !BENCH_SOFT) {
+        fprintf(stderr, "%s: vectors must be made with the soft reference decoder\n", BENCH_NAME);
+        return -1;
+    }
+    if ((out = fopen(path, "w")) == NULL) {
+        perror(path);
+        return -1;
+    }
+    
+    fprintf(out, "/* Noisy FEC vectors for bench.c, made by \"make vectors\" (bench_softref -g) */\n\n");
+    fprintf(out, "static const fecvector_t fec_vectors[] = {\n");
+    
+    for (i=0; i<(ot_int)(sizeof(vector_sizes)/sizeof(ot_int)); i++) {
+        for (j=0; j<(ot_int)(sizeof(vector_sigmas)/sizeof(ot_int)); j++) {
+            unsigned seed;
+            for (seed=(unsigned)((i<<8)+(j<<4)+1); ; seed++) {
+                sub_load_frame(vector_sizes[i], True, seed);
+                sub_encode();
+                sub_channel(levels, air_end, vector_sigmas[j]);
+                
+                sub_decode_levels(NULL);
+                if (rxq.front[0] != txq.front[0]) continue;
+                for (k=0; k<rxq.length; k++) {
+                    sprintf(&hard[k<<1], "%02x", rxq.front[k]);
+                }
+                hard_crc = em2_crc_check();
+                
+                sub_decode_levels(levels);
+                if (rxq.front[0] != txq.front[0]) continue;
+                break;
+            }
+            
+            fprintf(out, "    { %d, %d, %u,\n      \"", vector_sizes[i], vector_sigmas[j], seed);
+            for (k=0; levels[k] != 0; k++) {
+                if ((k != 0) && ((k & 63) == 0)) {
+                    fprintf(out, "\"\n      \"");
+                }
+                fputc(levels[k], out);
+            }
+            fprintf(out, "\",\n      \"%s\", %d,\n      \"", hard, hard_crc);
+            for (k=0; k<rxq.length; k++) {
+                fprintf(out, "%02x", rxq.front[k]);
+            }
+            fprintf(out, "\", %d },\n", (ot_bool)em2_crc_check());
+        }
+    }
+    fprintf(out, "};\n");
+    fclose(out);
+    return 0;
+}
+#endif
+
+
+static void sub_run(result_t* enc, result_t* dec, ot_int frame_bytes, ot_bool fec, double min_ns) {
+    long    i, n;
+    double  t0, c0, t1, c1;
+
+    /// Find an iteration count that takes about min_ns, then time it
+    for (n=16; ; n<<=1) {
+        t0 = sub_now_ns();
+        for (i=0; i<n; i++) {
+            sub_encode();
+        }
+        if ((sub_now_ns() - t0) >= (min_ns / 4)) break;
+    }
+    n <<= 2;
+
+    t0 = sub_now_ns();
+    c0 = BENCH_CYCLES();
+    for (i=0; i<n; i++) {
+        sub_encode();
+    }
+    c1 = BENCH_CYCLES();
+    t1 = sub_now_ns();
+    enc->ns     = t1 - t0;
+    enc->cycles = c1 - c0;
+    enc->frames = n;
+
+    t0 = sub_now_ns();
+    c0 = BENCH_CYCLES();
+    for (i=0; i<n; i++) {
+        sub_decode(fec);
+    }
+    c1 = BENCH_CYCLES();
+    t1 = sub_now_ns();
+    dec->ns     = t1 - t0;
+    dec->cycles = c1 - c0;
+    dec->frames = n;
+}
+
+
+static void sub_report(FILE* csv, const char* codec, const char* dir,
+                        ot_int frame_bytes, result_t* r) {
+    double bytes    = (double)r->frames * (double)frame_bytes;
+    double ns_byte  = r->ns / bytes;
+    double fps      = ((double)r->frames * 1e9) / r->ns;
+    double cyc_byte = r->cycles / bytes;
+
+    printf("%-12s %-10s %-3s %5d %10.2f %12.0f %10.2f\n",
+            BENCH_NAME, codec, dir, frame_bytes, ns_byte, fps, cyc_byte);
+
+    if (csv != NULL) {
+        fprintf(csv, "%s,%s,%s,%d,%ld,%.3f,%.1f,%.3f\n",
+            BENCH_NAME, codec, dir, frame_bytes, r->frames, ns_byte, fps, cyc_byte);
+    }
+}
+
+
+static ot_u16 sub_crc_bitwise(ot_u8* data, ot_int length) {
+/// The CRC16 of crc16.c, a bit at a time: 0x1021, MSB first, from 0xFFFF
+    ot_u16  crcv = 0xFFFF;
+    ot_int  i;
+
+    while (length-- > 0) {
+        crcv ^= (ot_u16)(*data++ << 8);
+        for (i=0; i<8; i++) {
+            crcv = (crcv & 0x8000) ? (ot_u16)((crcv << 1) ^ 0x1021) : (ot_u16)(crcv << 1);
+        }
+    }
+    return crcv;
+}
+
+
+static int sub_check_crc() {
+/// Lengths 0 to 300 (the folding engine starts at 32 bytes and goes 16 at a
+/// time), at every alignment of a 16 byte vector, in one block with 
+/// crc_calc_block() and split in two with crc_ctx_update().
+    static ot_u8 buf[300 + 16];
+    crc_ctx ctx;
+    ot_u16  ref;
+    ot_int  length, align, split;
+    
+    bench_rand = 0xC5C;
+    for (length=0; length<(ot_int)sizeof(buf); length++) {
+        buf[length] = (ot_u8)sub_rand();
+    }
+    
+    for (length=0; length<=300; length++) {
+        for (align=0; align<16; align++) {
+            ref     = sub_crc_bitwise(&buf[align], length);
+            split   = (ot_int)(sub_rand() % (ot_u32)(length + 1));
+            crc_ctx_init(&ctx);
+            crc_ctx_update(&ctx, &buf[align], split);
+            crc_ctx_update(&ctx, &buf[align+split], length-split);
+            
+            if ((crc_calc_block(length, &buf[align]) != ref) || (crc_ctx_final(&ctx) != ref)) {
+                fprintf(stderr, "%s: %s CRC (CRC_SLICE %d) is wrong on %d bytes at +%d\n",
+                        BENCH_NAME, BENCH_CRC, CRC_SLICE, length, align);
+                return -1;
+            }
+        }
+    }
+    printf("%-12s %s CRC (CRC_SLICE %d) matches the bitwise CRC\n", BENCH_NAME, BENCH_CRC, CRC_SLICE);
+    return 0;
+}
+
+
+static int sub_bench(FILE* csv, ot_bool fec, double min_ns) {
+    ot_int      i;
+    ot_int      frame_bytes;
+    result_t    enc, dec;
+    const char* enc_name = fec ? NAME_FEC_ENC : NAME_PLAIN_ENC;
+    const char* dec_name = fec ? NAME_FEC_DEC : NAME_PLAIN_DEC;
+
+    for (i=0; i<(ot_int)(sizeof(frame_sizes)/sizeof(ot_int)); i++) {
+        frame_bytes = frame_sizes[i];
+        sub_load_frame(frame_bytes, fec, (unsigned)frame_bytes);
+        sub_encode();
+        sub_decode(fec);
+
+        if (sub_check(frame_bytes, fec) == False) {
+            fprintf(stderr, "%s: %s/%s round trip failed on %d byte frame\n",
+                    BENCH_NAME, enc_name, dec_name, frame_bytes);
+            return -1;
+        }
+#       if (M2_FEATURE(BLOCKCODEC) == ENABLED)
+        if (sub_check_block(frame_bytes, fec) == False) {
+            fprintf(stderr, "%s: %s block round trip failed on %d byte frame\n",
+                    BENCH_NAME, (fec ? "FEC" : "PN9"), frame_bytes);
+            return -1;
+        }
+#       endif
+
+        sub_run(&enc, &dec, frame_bytes, fec, min_ns);
+        sub_report(csv, enc_name, "enc", frame_bytes, &enc);
+        sub_report(csv, dec_name, "dec", frame_bytes, &dec);
+    }
+    return 0;
+}
+
+
+int main(int argc, char** argv) {
+    int     opt;
+    int     err;
+    double  min_ns      = 200e6;
+    FILE*   csv         = NULL;
+    char*   vectors     = NULL;
+
+    while ((opt = getopt(argc, argv, "t:c:g:")) != -1) {
+        switch (opt) {
+            case 't':   min_ns = atof(optarg) * 1e6;
+                        break;
+
+            case 'c':   csv = fopen(optarg, "a+");
+                        if (csv == NULL) {
+                            perror(optarg);
+                            return 2;
+                        }
+                        fseek(csv, 0, SEEK_END);
+                        if (ftell(csv) == 0) {
+                            fprintf(csv, "config,codec,dir,frame_bytes,frames,ns_per_byte,frames_per_s,cycles_per_byte\n");
+                        }
+                        break;
+
+            case 'g':   vectors = optarg;
+                        break;
+
+            default:    fprintf(stderr, "Usage: %s [-t ms] [-c results.csv] [-g fec_vectors.h]\n", argv[0]);
+                        return 2;
+        }
+    }
+
+#   if (BENCH_FEC)
+    if (vectors != NULL) {
+        return (sub_write_vectors(vectors) != 0);
+    }
+#   else
+    if (vectors != NULL) {
+        fprintf(stderr, "%s: no SW FEC in this build\n", BENCH_NAME);
+        return 2;
+    }
+#   endif
+
+    if (sub_check_crc() != 0) {
+        return 1;
+    }
+
+    printf("%-12s %-10s %-3s %5s %10s %12s %10s\n",
+            "config", "codec", "dir", "bytes", "ns/byte", "frames/s", "cyc/byte");
+
+    err = sub_bench(csv, False, min_ns);
+#   if (BENCH_FEC)
+    if (err == 0) {
+        err = sub_check_vectors();
+    }
+#   if (BENCH_SOFT)
+    if (err == 0) {
+        err = sub_check_softgain();
+    }
+#   endif
+    if (err == 0) {
+        err = sub_bench(csv, True, min_ns);
+    }
+#   endif
+
+    if (csv != NULL) {
+        fclose(csv);
+    }
+    return (err != 0);
+}
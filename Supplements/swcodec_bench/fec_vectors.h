@@ -0,0 +1,300 @@
+/* Noisy FEC vectors for bench.c, made by "make vectors" (bench_softref -g) */
+
+static const fecvector_t fec_vectors[] = {
+    { 8, 30, 1,
+      "2000777101700007006015706777717770002177700606000676070106777000"
+      "7700156260077677001066077066776077776007516501775170700077001077"
+      "17000710007600770700067677707670",
+      "072101c54fd119a9", 1,
+      "072101c54fd119a9", 1 },
+    { 8, 50, 17,
+      "7640766077051006027026601777707717777065010424700746702065600007"
+      "7761670747750005002037656110737217725737160727370700076776627306"
+      "15020700026400100700167777727701",
+      "0710521195b42e4a", 1,
+      "0710521195b42e4a", 1 },
+    { 8, 60, 33,
+      "0741777057030236760705207775727207706005070777207727077007001700"
+      "6030065775007076777714011021730607777067370506670142706070606767"
+      "14001402027700762710070277707703",
+      "0743a76df383bcf3", 1,
+      "0743a76df383bcf3", 1 },
+    { 8, 75, 49,
+      "4101774010770404770707710777433753170002332075737247637177056507"
+      "7070771077210414477657710043762777707403705600755600070232153606"
+      "25020420007702400704070177717657",
+      "0772f4b929e68b10", 1,
+      "0772f4b929e68b10", 1 },
+    { 32, 30, 257,
+      "1067000777600007667277707077007702077712061460117001600060707702"
+      "7761670701770077775066017670577777776000727177700105610070010607"
+      "0000700077666000776077000667007707007077011772700750077101710767"
+      "2770707705170572176771757707017127070700000070670071176070647066"
+      "0776277100670070671073001670567570070777675014772711617070006711"
+      "7000170607700007106770177370570061511070706117570077607701650600"
+      "7007570776067700050000707005705770070077011500000000707606076067"
+      "0077770760057701607770000000227167611077071770677160610770006700"
+      "06100701007710772700077777706760",
+      "1f3110e6cc2469f0ecea0df23ff9c9b83f6fa3a2865b86e9d623ded1977846e5", 1,
+      "1f3110e6cc2469f0ecea0df23ff9c9b83f6fa3a2865b86e9d623ded1977846e5", 1 },
+    { 32, 50, 273,
+      "7707000701050006777077611077104766520610460060617050071111770407"
+      "7700057117077527467007707703706517021701001651077700376660000777"
+      "0072000603776020776265717717501176170750007776072707367037367064"
+      "0600047070007377776740010313051021007773003405100027501055070706"
+      "7274307702006607070501756717770171156037617707077107060707607502"
+      "0617644674040716156020710557707467004707070700171364077517006071"
+      "7300066700750720704070705077770770112770007277012507550700127767"
+      "5377601700576770075007037501616777122077117374005212004527512677"
+      "07100700025710400702170074716600",
+      "1f00433216416d765fda29814e906aca17f7c267bbb6c2d2e9c16568c5bedf40", 1,
+      "1f00433216416d765fda29814e906aca17f7c267bbb6c2d2e9c16568c5bedf40", 1 },
+    { 32, 60, 289,
+      "1747033700014017100477407277007776770773402710401171607270040010"
+      "5370670200700777011637072717520020606000775674026007035100175707"
+      "1756101067373646500627070730016014075561776017000600750031436070"
+      "1500075172714407572772727777002405077722000765577560240100356725"
+      "3077507077300036270712707605247302630000170010260036000777776570"
+      "0007040701004370776661077717773700317765707572523017205006217076"
+      "7057436001250105774677006171037137140745171702177075015060167016"
+      "0107707061706070177070034470600702700075227070065537606710740077"
+      "07001712207700000710160076606640",
+      "1f53b64e7076f08d23a1e442be505feaa7f4ed7d842d6e1a068a10df40d88678", 1,
+      "1f53b64e7076f08d23a1e442be505feaa7f4ed7d842d6e1a068a10df40d88678", 1 },
+    { 32, 75, 305,
+      "7357010777750007204477720347007710207740002000600201075030007306"
+      "7030377707027007043772474671770060170500070050520701270744073577"
+      "0746230705075717504347745543730677301777770005770657630077720410"
+      "0670701727767300030740033345177407120370140141027317707016063514"
+      "7777166777726740770060060770050001705561010730364404477004077374"
+      "5701536650405050707001700300724406710110071137000704750100750117"
+      "7760031277743107006505005400070077000470064043177570070267027707"
+      "7017777000025004727566161072003104040066270623707707000774076100"
+      "07000700007413460720037766504350",
+      "1f62e59aaa13f40b90f49c31cf3cfc988f6c8cb8b9c02a213968ab66121e1fdd", 0,
+      "1f62e59aaa13f40b9111c031cf39fc988f6c8cb8b9c02a213968ab66121e1fdd", 0 },
+    { 64, 30, 513,
+      "0106000100070070677110700067777700770770010070777067710070000600"
+      "0700027060107277771015710077206170070760706067077000777770760307"
+      "0101267662707011007777065017007177777106007117711067070777067715"
+      "0760170066076767170710677022001700100611717677006010601777717007"
+      "0006700777161770500677567767077701021061700077607000021767010650"
+      "7701027007010666771070000076077760106077110707117600110070000767"
+      "0070160007756056010757006672007176761710666000106705767270111717"
+      "7170007072650770700070070677706075770007607771070077774707601716"
+      "7717007570260005077010777777757700116006007706711000070701067617"
+      "6107057071050770001706770077770100011006060706000677607107760767"
+      "0057760027711726761006765761077700760607007600006110717771700070"
+      "0670707000077777617777707760777026700006106177077077007777211750"
+      "0617707002170106712770677700757070117207177462777000710776072607"
+      "5707010770000707771760767000700670777777776700701007727001670701"
+      "6650056701667007077607720711061612407721062070771027000777000776"
+      "7707007771710770070756107707777000602017110000160776170006067050"
+      "07001700006700770700067775717607",
+      "3f0123834182515b6d2f3d78726ccc062294ddd45109acdc60fc5573430bbf0c70be7cdffc0a1b49d799df9ff625684a2a2f7bdaba25524e39e9daac77faa6ba", 1,
+      "3f0123834182515b6d2f3d78726ccc062294ddd45109acdc60fc5573430bbf0c70be7cdffc0a1b49d799df9ff625684a2a2f7bdaba25524e39e9daac77faa6ba", 1 },
+    { 64, 50, 529,
+      "7677301056723071777000627077757665316770330650165015274002077707"
+      "0771412667702507473247001001076100704051221770710727111160670277"
+      "3172777007605500027477664074712707600701011300060402070370702007"
+      "1700600600002252570400000605076707175670703003777067077571010777"
+      "7715170077406006000007100701070010107700770767101616756120700770"
+      "1205761066610177600701777770022775713720777000734002660077777007"
+      "4675677160272077544707306620270077730107671677105000713077070207"
+      "1070076040051710272707177177107702175214707575717605740750071070"
+      "6777000260550270017371110705057301706270071630004137001760467701"
+      "1707076511010000007375007000014541077055707707577007403315507702"
+      "0760177557607007770107700101076041071007700017762677207721505766"
+      "7070677637706005760771570627007507071017007770100070667040075177"
+      "1517070737500501037367700061710477370107741007560204606071100506"
+      "0076127070107757507071707734106067350760770676770077160105700775"
+      "5077767170077710070641774561700707207760773072101202470000477047"
+      "7171707010706673324057000407105517317776600170767700000100751770"
+      "07010700127700742750260367707605",
+      "3f3070579be755ddde1f190b03056f740a0cbc116ce4e8e75f1eeeca11cd29ad69473523805e28aa54bed1aa18b8ad93f72178646f1db1bcd60e7a0b51e4cb84", 1,
+      "3f3070579be755ddde1f190b03056f740a0cbc116ce4e8e75f1eeeca11cd29ad69473523805e28aa54bed1aa18b8ad93f72178646f1db1bcd60e7a0b51e4cb84", 1 },
+    { 64, 60, 545,
+      "0657000365760072000501702027777767167710770101770015427050574000"
+      "0020017770275756405652772001071527200573237747701002171710707005"
+      "0676677660004707170107207020406655727110551750003114277507570001"
+      "1710407700607534777700704070015017007502707020001621704505707477"
+      "0627030740530627000016050711677770773607006070217707607070672720"
+      "0506377000404001201061120701374232700650015070363564500757762010"
+      "2102177470562760501020704727706470470300423007070740163117001775"
+      "5130072761012000070760016116411507306760040371007101630147375107"
+      "2044770027707720177017750777370277300237777317772767572777742000"
+      "7016057775501504677020412070370503054200300745047670075500650007"
+      "0700700172702757773762077602437570702777106770442374377170003672"
+      "7463760106602071007272660003077330745660277711720777747770130247"
+      "2257041230276373777766711717560172775204706711726764700600007727"
+      "5777504407556727665135070000507775660770735260000317004366547310"
+      "1356706732577332770737205770510025720647007750377005006201700177"
+      "0107761400172437776037670166717077427203350070273706437577700700"
+      "07201630007705020701070367603712",
+      "3f63852bfdd0c826a264d4c8f3c55a54ba0f930b537f444fb0559b7d94abfe16388f16d7850f6ff5101b2ab50d2a793d87b12e533c157415f871a9a24af7800b", 0,
+      "3f63852bfdd0c826a264d4c8f3c55a54ba0f930b537f442fb0559b7d94abfe16388f16d7850f6ff5101b2ab50d2a793d87b12e533c152d45f871a9a24af7800b", 1 },
+    { 64, 75, 561,
+      "5005000002003070000501127105777702700703070670160077367020700003"
+      "0071600074663107003727176074001577574031142025077517604000607057"
+      "4306677007007707270027702020400034733777677777631372737505044550"
+      "6772076077353025044715071747374000012570507406642756051600200037"
+      "2005622203065440507555417766761073575076277740202000070352075500"
+      "5000610662047500040514767017103203107000577436676071063660030171"
+      "0707650707177420067050737767750770650703703554472037000700070254"
+      "2100000701601070603017003704702070730770366277772751437005307520"
+      "0117777722007577056746406747000762400002420550075570714607040403"
+      "3727171307370270050772755257637570030740657647500302077002727151"
+      "0507637400713076711760001361626042002360720077707502672223503067"
+      "0070713500043602055674757477703702007671677065775671037377300650"
+      "1616707477724767070064777047705045710507110134632674147205067716"
+      "2007702707760747702747000772054270014757777007570560774750576754"
+      "0767407050057726764410077700172010001777717551537010766777023607"
+      "0571051171675007401707276177065370071473070001577520446772027100"
+      "41200620054601101700172557716531",
+      "3f52d6ff27b5fca011553b3b82acf926903d32ce6e9200148fb70ec4c66d68b72173c8bcc0bb5c16933e9480e3b7bce45abf2aede92dceb7179609056ce9eb35", 0,
+      "3f52d6ff27b5cca01155f0bb82acf9269297f2ce6e9200148fb720c4c66d68b721765f2bf95b5c16933c2480e3b7bce45abf2dede92dceb7179609056ce9ed35", 0 },
+    { 128, 30, 769,
+      "0070007677070177017001071677007761617007770117741700071107061011"
+      "0760701600702677007006760771006700102777700167703007600707170600"
+      "7001007757020007727070264050070777077000217006761700007071001702"
+      "7767500077760000077007105600670067770060000507171056707177777066"
+      "0567775015760070701517077767707071700710712176067000700006700700"
+      "0270707172077677065677167770777057001017757076767700700070060077"
+      "7616050071706110760107710710707001600070076727500170007677170167"
+      "0000707617000700270772707071771607000766707767607700607000701700"
+      "7770776705177167617010107001070617170067671767000712166071067607"
+      "7071076167607607570067770067107077701707060160151070507777777070"
+      "7200000610100702170162077657072007100717607170007707707077640620"
+      "0167750771017756627002075770607060750077276757107017770067760777"
+      "5750706257070110707600207770701770170127677670700751457707072701"
+      "1007151757177601026707601670071060007077701600126660771176070700"
+      "2700077177161166602101770767701170716767701060707076517706600060"
+      "7071071607776000070600101070672770016101007761776560770015670017"
+      "7170001177001711570706076702700767007777160007071770076071150506"
+      "5777000700700706717171000700507201770707704606700121777717150700"
+      "0750077310077006607700007607007007010607770000761077030700766007"
+      "7070771617070260777227000777706737100700710677075771700177170700"
+      "7667705770757770002000760761670707175777070726706600077007601700"
+      "6770762027012707010677707600776007700767677517707707107057707000"
+      "6760076000000071060170300750767600007177607770160161677707677700"
+      "6707700000710075170007677176757056517766010007000775270007707020"
+      "0720160070777707770071761060270160706717077567070770007700710717"
+      "7770660670706207167777777777160711000617776770000721017677165760"
+      "1660101777200010770777777756671501320027710001766111777577007677"
+      "7131677076770001007667060026560060027761770107706170705070067117"
+      "1100277170701270005751007071766707770067005777705766050107270070"
+      "6016066007110070060070101170767670700772677007100570660170716007"
+      "7700006004070717177770070677700271107006757002755076007006706007"
+      "0007007760572270775070076052070070700017076777700670700701707717"
+      "16100700107700761701070177715716",
+      "7f1132a0c277e8b133e044417a1fab4bacf376e7ce6193def92da20730a8111f24ae1aa4f08fd9b136d64a41e4c208ae73acb16f7de1990bd58a033615b8d9106353d3508a1a6e0712565b1ec03d70c2e9aacb9b72a20a65d894254455627834c3aeb8c03d9bf40365cc5acf8b24718a4b37ab788867f21c0f35145e403e066e", 1,
+      "7f1132a0c277e8b133e044417a1fab4bacf376e7ce6193def92da20730a8111f24ae1aa4f08fd9b136d64a41e4c208ae73acb16f7de1990bd58a033615b8d9106353d3508a1a6e0712565b1ec03d70c2e9aacb9b72a20a65d894254455627834c3aeb8c03d9bf40365cc5acf8b24718a4b37ab788867f21c0f35145e403e066e", 1 },
+    { 128, 50, 785,
+      "7720027202720055007012057767517714250007030705150571510077027107"
+      "0720007206107007007067040726056770566175007430067410077117051751"
+      "6061507024210006507060770000776007012714010201110567126277775400"
+      "7607072503737607777027671046717062717000003250400011270073270627"
+      "7046005707515727000064702400500770704170770777760717077572000500"
+      "7477150000457057106117700356721041716752110652167130172077707605"
+      "7200776137303012103077702761550000753777072050700755070740000577"
+      "5000775676700770400007700670070440507777707740032140701177172157"
+      "6723670007677200777770671070772207470000706622707717036200777502"
+      "0740265707777165456607126001711716767777717170507712605635700006"
+      "5717607150227010371070200037260607604006000567760372115016776017"
+      "4765511257677104470107002407077770100055167260062000012770606060"
+      "7072171740300706000007050212576754007014050007705777770003000620"
+      "7775151477070750043057750130665776600072336757075710107070000457"
+      "0137767707770570707007500706071073016707010050177171077053077700"
+      "7617760077670000107130007070004060021732707701076721463720700150"
+      "0001717711453071110077061060707470077207277610007737220771276077"
+      "3774522107772700160752771161770167767071057047527477672077420000"
+      "0007701700404104040000727003102272570275177757555705777702770707"
+      "7763010070711200065522126700107710007707000737630007726274371607"
+      "7001760750060075462777007770770067017746077677017747775500170701"
+      "7077707767711406501607750720344710705770600007710437030041003277"
+      "2066500770737770012607777020706705700404000360013077117260720725"
+      "7071707667774570076770070767370073410075707612000242727667707077"
+      "0400275307530760721707221077762022717000300127770672006100770676"
+      "7777070560207110006370173700050277407070705754777747050060560777"
+      "7076720760007776760777102007476712570001706010500263020470777675"
+      "1771277007767721070537771005076250615047502507570056716300077775"
+      "0714710077570007060475000706701447157020776063717770077441720772"
+      "0077060506601706070707070777771070707110677364275730627710770456"
+      "0765601614770100065070227700035507375476475775660744760407702470"
+      "7707070216647760007472770225037042070760607110677000201070567067"
+      "06111602027703760701341277707707",
+      "7f2061741812ec3780d060320b760839846b1722f38cd7e5c6cf19be626e87be3d5753588cdbea52b5f144740a5fcd77aea2b2d1b0d97af93a6da39133a614852cf0bd7bf96c7a569344f998b8a696c58b7807e8fcdcb96bc979f6e385207caaf6675fc3f7e2e93e66e8ba161189037673d9bd880d949f85d9e3b6bfc26fddbe", 0,
+      "7f2061741812ec3780d060320b760839846b1722f38cd7e5c6cf19be626e87be3d5753588cdbea52b5f144740a5fcd77aea2b2d1a8d97af93a6da39133a614852cf0bd7bf96c7a569344f998b8a696c58b7807e8fcdcb96bc979f6e385207caaf6675fc3f7e2e93e66e8ba161189037673d9bd880d949f85d9e3b6bfc26fddbe", 1 },
+    { 128, 60, 801,
+      "0702007700671276271732450745047734100277010077577760075007747400"
+      "2060700001750457770257615504274077070577773557373007004577327700"
+      "7777716767510720671722004065172055007205670770050741601002707007"
+      "7707265330102055770105162470777770767170010110377777612017677705"
+      "1077615270013004020057771503017000170067014230775507007700070770"
+      "7077656355776200707445075017776524407703737600602750000477504610"
+      "7737055703701527174770000656005707500771007700437003707021241327"
+      "1072750217772070512270350605267077577320170377760755702670767000"
+      "2013100270720770707007000010077160277006001574071175755004720431"
+      "6060173770077656105570011063707027773020030310246075367760634500"
+      "4777160467004741070707537707640071070676717030070650066767150102"
+      "3077705675551271003007000210057166717710307000771707000040601270"
+      "7070070005077277770747251367717570610003007720570010774574007602"
+      "0076672202603700100070007770077477200060706170407170177600007700"
+      "7031706077375070107110155752070776720770774570200077500071001771"
+      "0770736667007567756060777600612710610705065507356275470525016600"
+      "5777001773007700114201040600400077070607074774770077570174737477"
+      "0407075007007167777360017177067777203067070707670600200017024606"
+      "5761167222020700006060525575760700767076000057070204027311067737"
+      "6077606570024115056607776067030307720147760006310757760704512070"
+      "0507170067702101140144146277061706707540706010077027777770742350"
+      "1707517707517601773040670747702057176000123720577337262001057727"
+      "0717070750037776000406607743167074077770000727702500707170704073"
+      "4750377017010001707474150626577570035103040500710077560007427070"
+      "7700106321727176005005174510001706066475360521600720020162154602"
+      "7004002176701022641661171570712700654100176453412757063757370374"
+      "7537777476500170160200111227777106370074535711077706407700777400"
+      "0072077607707716537070607303057370000720070614720000707070130030"
+      "2767027220770657100420772030260070155027071757070707070074007006"
+      "0107370000027001267107013777707053071377506006712227720100067714"
+      "0377765757076075064600000237070717727500750076541657670327047505"
+      "3707775175074756757201072000770672770716502717476200367710000167"
+      "17002700127700670723075545537772",
+      "7f7394087e2571ccfcabadf1fbb63d1934683838cc177b2d29846c09e70850056c9f70ac898aad0df154bf6b1fcd19d9de32e4e6fbd1e6001412703828b531bf4fe42ce9c8750f4ffb99aa9cf2d4ae3e38c57712ac71d726088b9ea9fe27367f34688814d0154c4f04263a44f1db42461ce398857df18001e721f63f3d69c18c", 0,
+      "7f7394087e2571ccfcabadf1fbb63d1934683838cc177b2d29846c09e70850056c9f70ac898aad0df154bf6b1fcd19d9de32e4e6fbd1e6001412703828b531bf4fe42ce9c8750f4ffb99aa9cf2d4ae3e38c57712ac71d726088b9ea9fe27367f34688814d0158c4f04263a44f1db42461ce398857df18001e721f63f3d69c18c", 1 },
+    { 128, 75, 817,
+      "7070407577010076452720064766102760747047713777357400437277670607"
+      "0200207747077704730605504772242115507477172050711300573077027470"
+      "7724007011703400470530710034734407071721657757613717700004070506"
+      "6774717064077770360013201076700737700220002673707720253000071357"
+      "7777377770627170710725004577110500467305073771572540570477721771"
+      "0770100207270500777304702520701600201272500304007060770770070050"
+      "3153761770107607726310411706060367574177000077477730470037005617"
+      "7066000077270001070707667011773601243501050242106002422607027777"
+      "0170007750010407677777674040777764747170066560237053705137021004"
+      "2742447100013307031002767030070702642032577010747716074770720777"
+      "7070737314040041550713500077600776772077020507707301657717157703"
+      "1757472072220413170000167277677737177310317707506501720673777770"
+      "7752707550417760174025107037670773777006600077773206760773357730"
+      "7737720700607474267771076040750170721077271004767100601704276772"
+      "7767035567670737020307205727503763113720075650771271171703757002"
+      "0007007001320777702776472700151040737027547475777107740020275765"
+      "0707367213763050743563177370707270100073053370404000706767330017"
+      "7520677700057262000560227727000730342603610077777077237774560107"
+      "7027711017770700440670007570677771002707703704027777770720440046"
+      "7377076047630174274013770137705010737076072067107515677707701277"
+      "0073407036107705700603720067021055457743420062776075237157670371"
+      "0000750076027700171310724453270760242025022002772737277276601771"
+      "7000737004302077170532140610007073670307717005711627076407774077"
+      "7227740471057717710023457007375674071400407405700770307627707014"
+      "7704003047770521077740605707704776027124107174300710063650265177"
+      "6754700366200107700727273106700176070767006757070720002013765777"
+      "2070027740627717070020377727570013001075120400100765552707304310"
+      "5600647247200077470401107527761070700007020107777027731424111560"
+      "5072770217523702553776775763027770750024700371072600071770773707"
+      "1077077730707743077570200370700717077707724077567075717770005275"
+      "6040020160767720056000164134147320577173751730707060003202031770"
+      "7217430400007175005003076356277476300160370060730372662070061347"
+      "07000730007700573300157777714741",
+      "7f42c7dca440754a4f9b89828adf9e6b1f3a599df1fa3f161666d7b0b5cec6a4756615e24ade9ec57273b15ef150dc00033ce75f2ee905f1fbf5d09f0eabfc2a004742c2bb031b1e7a8b0b1a8a4848395a17bb61220f642819664d0e2e6532e101a178171a7491720702da9f19b630ba240dce75f802ed9966c7e748bf38da5c", 0,
+      "7f42c7dca440754a4f9b89828adf9e6b1cf059fdf1fa3f161666d7b0b5cec6a475663950e1de9eee7273b15ef150dc00033ce7582ee905f2fbf5d09f0eabfc2a004742c2bb031b1e7a8b081a8a4f48395a17bb61220f642819664d0e2e6532e101a173171a7491720702da9d6b7630ba240d8e75f802ed9831f754debf381a5c", 0 },
+};
@@ -0,0 +1,740 @@
+/*  Copyright 2026 OpenTag contributors
+  *
+  * Licensed under the OpenTag License, Version 1.0 (the "License");
+  * you may not use this file except in compliance with the License.
+  * You may obtain a copy of the License at
+  *
+  * http://www.indigresso.com/wiki/doku.php?id=opentag:license_1_0
+  *
+  * Unless required by applicable law or agreed to in writing, software
+  * distributed under the License is distributed on an "AS IS" BASIS,
+  * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  * See the License for the specific language governing permissions and
+  * limitations under the License.
+  */
+/**
+  * @file       /Supplements/vl_heap/vl_heap_test.c
+  * @author     OpenTag contributors
+  * @version    V1.0
+  * @date       16 October 2026
+  * @brief      Randomized model test of the Veelite heap allocator
+  *
+  * otlib/veelite.c is built without changes, on a VWORM that is a RAM array.
+  * Random operations are run on the user ISF heap, and after each one the
+  * result is checked against a model that knows only the files (base, alloc
+  * and data):
+  * - vl_new():         the file goes where best fit over the gaps between
+  *                     files puts it (smallest gap, then lowest address), or
+  *                     it fails if there is no gap or header for it.
+  *                     This checks sub_heap_alloc() and the free list.
+  * - vl_delete():      the space is free for the next vl_new().  This checks
+  *                     sub_heap_free() and its merging.
+  * - vl_defrag_step(): the file just above the lowest gap moves down into it,
+  *                     or to the best fit gap when it is bigger than that gap,
+  *                     unless the gap is at the end, the file is open, or it
+  *                     fits nowhere.  This checks sub_defragment_heap().
+  * - vl_init():        the free list is built again from the headers.  This
+  *                     checks sub_heap_build().
+  * - vl_write_block(), vl_read_block(): a span at any offset and length, odd
+  *                     or even, some of it past the end, is written to a user
+  *                     ISF, and another span is read back.  Nothing around the
+  *                     span may change.
+  * Every so often, the base and data of every file is checked, and the header
+  * that file open finds for each user ISF and ISFS ID must be the one that
+  * sub_header_search() finds.  With OT_FEATURE_VLINDEX (vl_heap_index), this
+  * checks the ID index.  vl_heap_contig reads VWORM through vworm_get().
+  *
+  * Two stock ISFs are mirrored in VSRAM, and the same block writes are done on
+  * them.  A model of each mirror word (VSRAM value, VWORM value and dirty bit)
+  * checks the dirty count, and that ISF_syncmirror_step() writes back the dirty
+  * words in order, no more than its limit, with the values in VSRAM.
+  *
+  * Usage: vl_heap_test [-s seed] [-n operations]
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "OT_types.h"
+#include "OT_config.h"
+#include "OT_platform.h"
+#include "auth.h"
+#include "veelite.h"
+#include "veelite_core.h"
+
+
+#define TEST_VWORM_BYTES    (ISF_START_VADDR + ISF_TOTAL_BYTES - VWORM_BASE_VADDR)
+#define TEST_HEAP_START     ISF_HEAP_USER_START
+#define TEST_HEAP_END       ISF_HEAP_END
+#define TEST_ID_FIRST       (ISF_NUM_M1_FILES + ISF_NUM_M2_FILES)
+#define TEST_IDS            ISF_NUM_USER_FILES
+#define TEST_CHECK_EVERY    64
+#define TEST_ISF_ID_END     (256 - ISF_NUM_EXT_FILES)
+#define TEST_MIRROR_WORDS   (ISF_MIRROR_HEAP_BYTES / 2)
+#define TEST_MIRROR_WORD(VADDR)     (((VADDR) - VSRAM_BASE_VADDR) >> 1)
+
+
+/// Not in veelite.h: the header search, and the search by ID that file open
+/// uses (through the index, if OT_FEATURE_VLINDEX)
+vaddr sub_header_search(vaddr header, ot_u8 search_id, ot_int num_headers);
+vaddr sub_isfs_search(ot_u8 id);
+vaddr sub_isf_search(ot_u8 id);
+
+
+/** Stub VWORM, VSRAM & platform
+  * ============================================================================
+  * VWORM starts erased (0xFF), so every header is empty but the mirrored stock
+  * ISFs' (see sub_stock_init()).  The user ISF heap is the only one that can
+  * get new files.
+  */
+static ot_u16   vworm[TEST_VWORM_BYTES/2];
+static ot_u16   vsram[TEST_MIRROR_WORDS];
+
+ot_u16 vworm_read(vaddr addr) {
+    return vworm[(addr - VWORM_BASE_VADDR) >> 1];
+}
+
+ot_u8 vworm_write(vaddr addr, ot_u16 data) {
+    vworm[(addr - VWORM_BASE_VADDR) >> 1] = data;
+    return 0;
+}
+
+ot_u8 vworm_mark(vaddr addr, ot_u16 value) {
+    return vworm_write(addr, value);
+}
+
+ot_u8 vworm_wipeblock(vaddr addr, ot_uint wipe_span) {
+    memset(&vworm[(addr - VWORM_BASE_VADDR) >> 1], 0xFF, wipe_span);
+    return 0;
+}
+
+ot_u8* vworm_get(vaddr addr) {
+    return (ot_u8*)vworm + (addr - VWORM_BASE_VADDR);
+}
+
+ot_u16 vsram_read(vaddr addr) {
+    return vsram[TEST_MIRROR_WORD(addr)];
+}
+
+ot_u8 vsram_mark(vaddr addr, ot_u16 value) {
+    vsram[TEST_MIRROR_WORD(addr)] = value;
+    return 0;
+}
+
+ot_u8* vsram_get(vaddr addr) {
+    return (ot_u8*)vsram + (addr - VSRAM_BASE_VADDR);
+}
+
+void platform_memcpy(ot_u8* dest, ot_u8* src, ot_int length) {
+    memmove(dest, src, length);
+}
+
+ot_u8 auth_check(ot_u8 data_mod, ot_u8 req_mod, id_tmpl* user_id) {
+    return 1;
+}
+
+void auth_invalidate_key(ot_u8 key_id) { }
+
+
+
+
+/** Model
+  * ============================================================================
+  * One entry per user ISF ID.  alloc is 0 if the file does not exist.
+  */
+typedef struct {
+    vaddr   base;
+    ot_uint alloc;
+    ot_u8   data[256];
+} model_file;
+
+static model_file   model[TEST_IDS];
+static ot_int       model_files;
+static ot_u32       ops_new, ops_full, ops_delete, ops_moved, ops_still, ops_init;
+static ot_u32       ops_block, ops_mirror, ops_sync;
+
+
+/// The file that starts at addr, or -1
+static ot_int sub_model_at(vaddr addr) {
+    ot_int i;
+    for (i=0; i<TEST_IDS; i++) {
+        if ((model[i].alloc != 0) && (model[i].base == addr)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+
+/// The gap that starts at or above addr: its base is returned, and its size
+/// is put in *size (0 if there is no gap above addr).
+static vaddr sub_model_gap(vaddr addr, ot_uint* size) {
+    ot_int  i;
+    vaddr   end;
+
+    /// Skip over the files, from addr up
+    while ((addr < TEST_HEAP_END) && ((i = sub_model_at(addr)) >= 0)) {
+        addr += model[i].alloc;
+    }
+
+    /// The gap ends at the next file above it
+    end = TEST_HEAP_END;
+    for (i=0; i<TEST_IDS; i++) {
+        if ((model[i].alloc != 0) && (model[i].base > addr) && (model[i].base < end)) {
+            end = model[i].base;
+        }
+    }
+    *size = (ot_uint)(end - addr);
+    return addr;
+}
+
+
+/// Best fit: the smallest gap that is big enough, and the lowest one if there
+/// are several.  NULL_vaddr if there is none.
+static vaddr sub_model_bestfit(ot_uint alloc) {
+    vaddr   gap, best;
+    ot_uint size, best_size;
+
+    best        = NULL_vaddr;
+    best_size   = 0;
+    for (gap=TEST_HEAP_START; gap<TEST_HEAP_END; gap+=size) {
+        gap = sub_model_gap(gap, &size);
+        if ((size >= alloc) && ((best == NULL_vaddr) || (size < best_size))) {
+            best        = gap;
+            best_size   = size;
+        }
+    }
+    return best;
+}
+
+
+
+
+/** Mirror Model
+  * ============================================================================
+  * The mirrored stock ISFs.  A mirror is the length word and then the data,
+  * so mirror word 0 of a file syncs to header+0, and word n to base+2(n-1).
+  * Each word has the VWORM address it syncs to (NULL_vaddr if none), the
+  * value it should have in VSRAM and in VWORM, and a dirty flag.  Sync writes
+  * dirty words back in mirror order.
+  */
+typedef struct {
+    ot_u8   id;
+    vaddr   base;
+    vaddr   mirror;
+    ot_uint alloc;
+} stock_file;
+
+#if (ISF_ENMIRROR(network_settings) == 0)
+#   error "vl_heap_test needs the network_settings mirror"
+#endif
+static const stock_file stock[] = {
+    { ISF_ID(network_settings), ISF_BASE_network_settings,
+      ISF_MIRROR_network_settings, ISF_ALLOC(network_settings) },
+#if (ISF_ENMIRROR(channel_configuration) != 0)
+    { ISF_ID(channel_configuration), ISF_BASE_channel_configuration,
+      ISF_MIRROR_channel_configuration, ISF_ALLOC(channel_configuration) },
+#endif
+};
+#define TEST_STOCK_FILES    (sizeof(stock) / sizeof(stock_file))
+
+static vaddr    mirror_to[TEST_MIRROR_WORDS];
+static ot_u16   mirror_sram[TEST_MIRROR_WORDS];
+static ot_u16   mirror_worm[TEST_MIRROR_WORDS];
+static ot_bool  mirror_dirty[TEST_MIRROR_WORDS];
+
+
+/// What ISF_loadmirror() does: VSRAM gets the length word and the data up to
+/// the length from VWORM (the rest of the mirror is left), and nothing is dirty
+static void sub_model_loadmirror() {
+    ot_uint i, w, end;
+
+    for (i=0; i<TEST_STOCK_FILES; i++) {
+        w   = TEST_MIRROR_WORD(stock[i].mirror);
+        end = w + 1 + ((mirror_worm[w] + 1) >> 1);
+        for (; w<end; w++) {
+            mirror_sram[w] = mirror_worm[w];
+        }
+    }
+    for (w=0; w<TEST_MIRROR_WORDS; w++) {
+        mirror_dirty[w] = False;
+    }
+}
+
+
+/// Puts a header and random data (and length) in VWORM for each stock file
+static void sub_stock_init() {
+    Twobytes    idmod;
+    vaddr       header;
+    ot_uint     i, n, w;
+
+    for (w=0; w<TEST_MIRROR_WORDS; w++) {
+        mirror_to[w] = NULL_vaddr;
+    }
+    for (i=0; i<TEST_STOCK_FILES; i++) {
+        header          = ISF_Header_START + (stock[i].id * sizeof(vl_header));
+        idmod.ubyte[0]  = stock[i].id;
+        idmod.ubyte[1]  = ISF_MOD_file_standard;
+        w               = TEST_MIRROR_WORD(stock[i].mirror);
+        mirror_to[w]    = header;
+        mirror_worm[w]  = (ot_u16)(rand() % (stock[i].alloc + 1));
+        vworm_write(header+0, mirror_worm[w]);
+        vworm_write(header+2, stock[i].alloc);
+        vworm_write(header+4, idmod.ushort);
+        vworm_write(header+6, stock[i].base);
+        vworm_write(header+8, stock[i].mirror);
+
+        for (n=0; n<stock[i].alloc; n+=2) {
+            w++;
+            mirror_to[w]    = stock[i].base + n;
+            mirror_worm[w]  = (ot_u16)rand();
+            vworm_write(mirror_to[w], mirror_worm[w]);
+        }
+    }
+    sub_model_loadmirror();
+}
+
+
+
+
+/** Checks
+  * ============================================================================
+  */
+static ot_u32 step;
+
+static int sub_fail(const char* what, ot_int id) {
+    fprintf(stderr, "op %u: %s (ISF %d)\n", step, what, id + TEST_ID_FIRST);
+    return 1;
+}
+
+
+static int sub_fail_mirror(const char* what, ot_uint word) {
+    fprintf(stderr, "op %u: %s (mirror word %u)\n", step, what, word);
+    return 1;
+}
+
+
+static vaddr sub_base(ot_int id) {
+    vaddr header;
+    if (vl_getheader_vaddr(&header, VL_ISF_BLOCKID, (ot_u8)(id + TEST_ID_FIRST),
+                           VL_ACCESS_R, NULL) != 0) {
+        return NULL_vaddr;
+    }
+    return vworm_read(header + 6);
+}
+
+
+static int sub_check_file(ot_int id) {
+    vlFILE* fp;
+    ot_u8   data[256];
+    ot_uint length;
+
+    if (sub_base(id) != model[id].base) {
+        return sub_fail("base is not the model's", id);
+    }
+    fp = vl_open(VL_ISF_BLOCKID, (ot_u8)(id + TEST_ID_FIRST), VL_ACCESS_R, NULL);
+    if (fp == NULL) {
+        return sub_fail("file does not open", id);
+    }
+    length = vl_load(fp, model[id].alloc, data);
+    vl_close(fp);
+    if ((length != model[id].alloc) || (memcmp(data, model[id].data, length) != 0)) {
+        return sub_fail("data is not the model's", id);
+    }
+    return 0;
+}
+
+
+static int sub_check_search() {
+    ot_int id;
+    for (id=TEST_ID_FIRST; id<TEST_ISF_ID_END; id++) {
+        if (sub_isf_search((ot_u8)id) != \
+            sub_header_search(ISF_Header_START_USER, (ot_u8)id, ISF_NUM_USER_FILES)) {
+            return sub_fail("ISF search is not the header search", id - TEST_ID_FIRST);
+        }
+    }
+    for (id=0; id<256; id++) {
+        if (sub_isfs_search((ot_u8)id) != \
+            sub_header_search(ISFS_Header_START, (ot_u8)id, ISFS_NUM_LISTS)) {
+            fprintf(stderr, "op %u: ISFS search is not the header search (ISFS %d)\n", step, id);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+
+static int sub_check_mirror() {
+    ot_uint w;
+    ot_uint pending = 0;
+
+    for (w=0; w<TEST_MIRROR_WORDS; w++) {
+        if (mirror_to[w] == NULL_vaddr) {
+            continue;
+        }
+        if (vsram[w] != mirror_sram[w]) {
+            return sub_fail_mirror("VSRAM is not the model's", w);
+        }
+        if (vworm_read(mirror_to[w]) != mirror_worm[w]) {
+            return sub_fail_mirror("VWORM is not the model's", w);
+        }
+        if (mirror_dirty[w]) {
+            pending++;
+        }
+    }
+
+    /// With no limit, the sync stops at the first dirty word
+    if (ISF_syncmirror_step(0) != pending) {
+        fprintf(stderr, "op %u: dirty count is not the model's %u\n", step, pending);
+        return 1;
+    }
+    return 0;
+}
+
+
+static int sub_check_all() {
+    ot_int i;
+    for (i=0; i<TEST_IDS; i++) {
+        if (model[i].alloc != 0) {
+            if (sub_check_file(i) != 0) {
+                return 1;
+            }
+        }
+        else if (sub_base(i) != NULL_vaddr) {
+            return sub_fail("deleted file is still there", i);
+        }
+    }
+    if (sub_check_mirror() != 0) {
+        return 1;
+    }
+    return sub_check_search();
+}
+
+
+
+
+/** Operations
+  * ============================================================================
+  */
+static int sub_op_new() {
+    vlFILE* fp;
+    ot_int  id;
+    ot_uint max_length, alloc, i;
+    vaddr   expected;
+    ot_u8   result;
+
+    id          = rand() % TEST_IDS;
+    max_length  = 1 + (rand() % 255);
+    alloc       = (max_length + 1) & ~1;
+    result      = vl_new(&fp, VL_ISF_BLOCKID, (ot_u8)(id + TEST_ID_FIRST),
+                         VL_ACCESS_SU, max_length, NULL);
+
+    if (model[id].alloc != 0) {
+        return (result != 0x02) ? sub_fail("vl_new() of an existing file", id) : 0;
+    }
+    expected = sub_model_bestfit(alloc);
+    if (expected == NULL_vaddr) {
+        ops_full++;
+        return (result != 0x06) ? sub_fail("vl_new() with no gap for it", id) : 0;
+    }
+    if (result != 0) {
+        return sub_fail("vl_new() failed with a gap for it", id);
+    }
+
+    ops_new++;
+    model_files++;
+    model[id].base  = expected;
+    model[id].alloc = alloc;
+    for (i=0; i<alloc; i++) {
+        model[id].data[i] = (ot_u8)rand();
+    }
+    vl_store(fp, alloc, model[id].data);
+    vl_close(fp);
+    return sub_check_file(id);
+}
+
+
+static int sub_op_delete() {
+    ot_int  id;
+    ot_u8   result;
+
+    id      = rand() % TEST_IDS;
+    result  = vl_delete(VL_ISF_BLOCKID, (ot_u8)(id + TEST_ID_FIRST), NULL);
+
+    if (model[id].alloc == 0) {
+        return (result != 0x01) ? sub_fail("vl_delete() of a missing file", id) : 0;
+    }
+    if (result != 0) {
+        return sub_fail("vl_delete() failed", id);
+    }
+    ops_delete++;
+    model_files--;
+    model[id].alloc = 0;
+    return 0;
+}
+
+
+static int sub_op_defrag() {
+/// One time in four, the file that would be moved is kept open
+    vlFILE* fp = NULL;
+    vaddr   gap;
+    vaddr   dest = NULL_vaddr;
+    ot_uint size;
+    ot_int  id;
+    ot_bool moved;
+
+    /// The file must not be copied over itself: when it is bigger than the
+    /// gap below it, it goes to the best fit gap (always above) instead.
+    gap = sub_model_gap(TEST_HEAP_START, &size);
+    id  = sub_model_at(gap + size);
+    if (id >= 0) {
+        dest = (size >= model[id].alloc) ? gap : sub_model_bestfit(model[id].alloc);
+    }
+    if ((dest != NULL_vaddr) && ((rand() & 3) == 0)) {
+        fp = vl_open(VL_ISF_BLOCKID, (ot_u8)(id + TEST_ID_FIRST), VL_ACCESS_R, NULL);
+    }
+    moved = vl_defrag_step();
+    if (fp != NULL) {
+        vl_close(fp);
+    }
+
+    if ((dest == NULL_vaddr) || (fp != NULL)) {
+        ops_still++;
+        return moved ? sub_fail("vl_defrag_step() moved a file it should not", id) : 0;
+    }
+    if (moved == False) {
+        return sub_fail("vl_defrag_step() did not move the file above the gap", id);
+    }
+    ops_moved++;
+    model[id].base = dest;
+    return sub_check_file(id);
+}
+
+
+/// Writes a span of the open file, at any offset and of any length (odd or
+/// even, and some of them past the end), and then reads another one back.  The
+/// image is the model of the file data, and it gets the write.  The span that
+/// was written is put in *offset and *length (0 if the write was refused).
+static const char* sub_block_io(vlFILE* fp, ot_u8* image, ot_uint alloc,
+                                ot_uint* offset, ot_uint* length) {
+    ot_u8   data[512];
+    ot_uint i, span, expected;
+    ot_u8   result;
+
+    *offset = rand() % (alloc + 1);
+    *length = rand() % (alloc - *offset + 3);
+    for (i=0; i<*length; i++) {
+        data[i] = (ot_u8)rand();
+    }
+    result = vl_write_block(fp, *offset, *length, data);
+    if ((*offset + *length) > alloc) {
+        *length = 0;
+        if (result != 255) {
+            return "vl_write_block() past the end";
+        }
+    }
+    else if (result != 0) {
+        return "vl_write_block() failed";
+    }
+    else {
+        memcpy(&image[*offset], data, *length);
+    }
+
+    /// The read is clipped to the allocation, and must not go past its length
+    i           = rand() % (alloc + 2);
+    span        = rand() % (alloc + 3);
+    expected    = (i >= alloc) ? 0 : ((span < (alloc - i)) ? span : (alloc - i));
+    memset(data, 0xA5, sizeof(data));
+    if (vl_read_block(fp, i, span, data) != expected) {
+        return "vl_read_block() length";
+    }
+    if (memcmp(data, &image[i], expected) != 0) {
+        return "vl_read_block() data is not the model's";
+    }
+    if (data[expected] != 0xA5) {
+        return "vl_read_block() wrote past its length";
+    }
+    return NULL;
+}
+
+
+static int sub_op_block() {
+    vlFILE*     fp;
+    const char* what;
+    ot_uint     offset, length;
+    ot_int      id;
+
+    id = rand() % TEST_IDS;
+    if (model[id].alloc == 0) {
+        return 0;
+    }
+    fp = vl_open(VL_ISF_BLOCKID, (ot_u8)(id + TEST_ID_FIRST), VL_ACCESS_SU, NULL);
+    if (fp == NULL) {
+        return sub_fail("vl_open() failed", id);
+    }
+    what = sub_block_io(fp, model[id].data, model[id].alloc, &offset, &length);
+    vl_close(fp);
+    if (what != NULL) {
+        return sub_fail(what, id);
+    }
+    ops_block++;
+    return sub_check_file(id);
+}
+
+
+/// A block write and read on a mirrored stock file.  The words it writes get
+/// dirty, and so does the length word if vl_close() changes it.
+static int sub_op_mirror() {
+    const stock_file*   file;
+    vlFILE*     fp;
+    const char* what;
+    ot_uint     offset, length, w, first, end;
+    ot_u16      flen;
+
+    file    = &stock[rand() % TEST_STOCK_FILES];
+    first   = TEST_MIRROR_WORD(file->mirror);
+    fp      = vl_open(VL_ISF_BLOCKID, file->id, VL_ACCESS_SU, NULL);
+    if (fp == NULL) {
+        return sub_fail_mirror("vl_open() of a stock file failed", first);
+    }
+    what = sub_block_io(fp, (ot_u8*)&mirror_sram[first+1], file->alloc, &offset, &length);
+    vl_close(fp);
+    if (what != NULL) {
+        return sub_fail_mirror(what, first);
+    }
+
+    ops_mirror++;
+    if (length != 0) {
+        end = first + 1 + ((offset + length - 1) >> 1);
+        for (w=first+1+(offset >> 1); w<=end; w++) {
+            mirror_dirty[w] = True;
+        }
+        flen = (ot_u16)(offset + length);
+        if (flen > mirror_sram[first]) {
+            mirror_sram[first]  = flen;
+            mirror_dirty[first] = True;
+        }
+    }
+    return sub_check_mirror();
+}
+
+
+/// Sync with a limit: the first dirty words, up to the limit, go to VWORM
+static int sub_op_sync() {
+    ot_bool synced[TEST_MIRROR_WORDS];
+    ot_uint limit, left, pending, w;
+
+    limit   = rand() % (2 * ISF_MIRROR_STEP_WORDS);
+    left    = limit;
+    pending = 0;
+    for (w=0; w<TEST_MIRROR_WORDS; w++) {
+        synced[w] = False;
+        if (mirror_dirty[w]) {
+            if (left != 0) {
+                left--;
+                synced[w]       = True;
+                mirror_worm[w]  = mirror_sram[w];
+                mirror_dirty[w] = False;
+            }
+            else {
+                pending++;
+            }
+        }
+    }
+    ops_sync++;
+    if (ISF_syncmirror_step(limit) != pending) {
+        fprintf(stderr, "op %u: ISF_syncmirror_step(%u) pending is not the model's %u\n",
+                step, limit, pending);
+        return 1;
+    }
+    for (w=0; w<TEST_MIRROR_WORDS; w++) {
+        if (synced[w] && (vworm_read(mirror_to[w]) != vsram[w])) {
+            return sub_fail_mirror("written back word is not the one in VSRAM", w);
+        }
+    }
+    return sub_check_mirror();
+}
+
+
+/// vl_init() loads the mirror again, so unsynced writes to it are lost
+static int sub_op_init() {
+    ops_init++;
+    vl_init();
+    sub_model_loadmirror();
+    return sub_check_mirror();
+}
+
+
+
+
+int main(int argc, char** argv) {
+    int     opt;
+    ot_u32  seed    = 1;
+    ot_u32  ops     = 20000;
+    int     pick;
+    int     fails;
+
+    while ((opt = getopt(argc, argv, "s:n:")) != -1) {
+        switch (opt) {
+            case 's':   seed    = (ot_u32)strtoul(optarg, NULL, 0);    break;
+            case 'n':   ops     = (ot_u32)strtoul(optarg, NULL, 0);    break;
+            default:    fprintf(stderr, "Usage: %s [-s seed] [-n operations]\n", argv[0]);
+                        return 1;
+        }
+    }
+    srand(seed);
+    memset(vworm, 0xFF, sizeof(vworm));
+    sub_stock_init();
+    vl_init();
+
+    printf("user ISF heap: %d bytes, %d headers\n",
+            (int)(TEST_HEAP_END - TEST_HEAP_START), TEST_IDS);
+
+    /// Mostly creates and deletes, so the heap fills up and fragments, with
+    /// some defragmenting, block I/O, mirror syncing and a few restarts
+    for (step=0; step<ops; step++) {
+        pick = rand() % 100;
+        if (pick < 35)          fails = sub_op_new();
+        else if (pick < 65)     fails = sub_op_delete();
+        else if (pick < 75)     fails = sub_op_defrag();
+        else if (pick < 84)     fails = sub_op_block();
+        else if (pick < 92)     fails = sub_op_mirror();
+        else if (pick < 98)     fails = sub_op_sync();
+        else                    fails = sub_op_init();
+
+        if ((fails == 0) && ((step % TEST_CHECK_EVERY) == 0)) {
+            fails = sub_check_all();
+        }
+        if (fails != 0) {
+            printf("FAILED\n");
+            return 1;
+        }
+    }
+    if (sub_check_all() != 0) {
+        printf("FAILED\n");
+        return 1;
+    }
+
+    /// A full sync must leave nothing dirty, and VWORM the same as VSRAM
+    ISF_syncmirror();
+    for (pick=0; pick<TEST_MIRROR_WORDS; pick++) {
+        if (mirror_dirty[pick]) {
+            mirror_worm[pick]   = mirror_sram[pick];
+            mirror_dirty[pick]  = False;
+        }
+    }
+    if (sub_check_mirror() != 0) {
+        printf("FAILED\n");
+        return 1;
+    }
+
+    printf("%u operations: %u new, %u full, %u deleted, %u moved, %u not moved, %u init\n",
+            ops, ops_new, ops_full, ops_delete, ops_moved, ops_still, ops_init);
+    printf("%u block, %u mirror, %u sync operations, over %d mirror words\n",
+            ops_block, ops_mirror, ops_sync, (int)TEST_MIRROR_WORDS);
+    printf("PASS\n");
+    return 0;
+}
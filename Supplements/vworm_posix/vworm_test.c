@@ -0,0 +1,277 @@
+/*  Copyright 2026 OpenTag contributors
+  *
+  * Licensed under the OpenTag License, Version 1.0 (the "License");
+  * you may not use this file except in compliance with the License.
+  * You may obtain a copy of the License at
+  *
+  * http://www.indigresso.com/wiki/doku.php?id=opentag:license_1_0
+  *
+  * Unless required by applicable law or agreed to in writing, software
+  * distributed under the License is distributed on an "AS IS" BASIS,
+  * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  * See the License for the specific language governing permissions and
+  * limitations under the License.
+  */
+/**
+  * @file       /Supplements/vworm_posix/vworm_test.c
+  * @author     OpenTag contributors
+  * @version    V1.0
+  * @date       16 October 2026
+  * @brief      Test of the POSIX Veelite Core on a real image file
+  *
+  * The core maps its image once per process, so each step that needs a fresh
+  * mapping runs in a child process, like a gateway that is restarted:
+  * 1. A new image is created: it has the stock ISF data and is erased (0xFF)
+  *    everywhere else.  Random words are written to all of it, and saved.
+  * 2. Another process maps it and reads back every word.
+  * 3. The image is cut to half its size.  It is grown again, and the first
+  *    half keeps its data (and the stock data is not loaded over it).
+  * 4. Processes that create a new image are killed at random points.  After
+  *    each one, the image is either not there or complete.
+  *
+  * Usage: vworm_test [-s seed] [-k kills]
+  ******************************************************************************
+  */
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "OT_types.h"
+#include "OT_config.h"
+#include "OT_platform.h"
+#include "veelite_core.h"
+#include "veelite_core_posix.h"
+
+
+#define TEST_BYTES      (VWORM_PRIMARY_PAGES * VWORM_PAGESIZE)
+#define TEST_WORDS      (TEST_BYTES / 2)
+#define TEST_ISF_WORD   ((ISF_START_VADDR - VWORM_BASE_VADDR) / 2)
+
+
+static ot_u16   model[TEST_WORDS];
+
+/// Stock ISF data for a new image (ISF_STOCK_BYTES is set in the Makefile)
+const ot_u8 isf_stock_files[ISF_STOCK_BYTES] = {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+    0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17,
+    0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27,
+    0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37
+};
+
+/// Platform stubs for the core
+platform_struct platform;
+
+void otapi_log_code(ot_u8 label_len, ot_u8* label, ot_u16 code) { }
+
+
+
+
+/** Checks
+  * ============================================================================
+  */
+
+/// Runs one step in a child process, which exits with the step's result.
+/// The child's mapping goes away with it, as it would on a restart.
+static int sub_child(int (*step)(void)) {
+    pid_t   pid;
+    int     status;
+
+    fflush(stdout);
+    pid = fork();
+    if (pid == 0) {
+        _exit(step());
+    }
+    if ((pid < 0) || (waitpid(pid, &status, 0) != pid) || !WIFEXITED(status)) {
+        return 1;
+    }
+    return WEXITSTATUS(status);
+}
+
+
+/// The stock ISF data, as words in the byte order of the image
+static void sub_model_stock() {
+    ot_int i;
+    for (i=0; i<TEST_WORDS; i++) {
+        model[i] = 0xFFFF;
+    }
+    memcpy(&model[TEST_ISF_WORD], isf_stock_files, ISF_STOCK_BYTES);
+}
+
+
+/// Compares words first to limit-1 with the model
+static int sub_check(ot_int first, ot_int limit, const char* what) {
+    ot_int i;
+    ot_u16 value;
+
+    for (i=first; i<limit; i++) {
+        value = vworm_read((vaddr)(VWORM_BASE_VADDR + (i*2)));
+        if (value != model[i]) {
+            fprintf(stderr, "%s: word %d is %04X, not %04X\n", what, i, value, model[i]);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+
+static int sub_image_size() {
+    struct stat st;
+    if (stat(VWORM_IMAGE_FILE, &st) != 0) {
+        return -1;
+    }
+    return (int)st.st_size;
+}
+
+
+static void sub_remove_temps() {
+    char    cmd[64];
+    sprintf(cmd, "rm -f %s.??????", VWORM_IMAGE_FILE);
+    if (system(cmd) != 0) {
+        fprintf(stderr, "could not remove temporary images\n");
+    }
+}
+
+
+
+
+/** Steps
+  * ============================================================================
+  */
+
+static int sub_step_new() {
+    ot_int i;
+
+    if (vworm_init() != 0) {
+        fprintf(stderr, "new image: vworm_init() failed\n");
+        return 1;
+    }
+    if (sub_check(0, TEST_WORDS, "new image") != 0) {
+        return 1;
+    }
+    for (i=0; i<TEST_WORDS; i++) {
+        model[i] = (ot_u16)rand();
+        vworm_write((vaddr)(VWORM_BASE_VADDR + (i*2)), model[i]);
+    }
+    return (vworm_save() != 0);
+}
+
+
+static int sub_step_remap() {
+    if (vworm_init() != 0) {
+        fprintf(stderr, "remap: vworm_init() failed\n");
+        return 1;
+    }
+    return sub_check(0, TEST_WORDS, "remap");
+}
+
+
+static int sub_step_grow() {
+    if (vworm_init() != 0) {
+        fprintf(stderr, "grow: vworm_init() failed\n");
+        return 1;
+    }
+    return sub_check(0, TEST_WORDS, "grow");
+}
+
+
+static int sub_step_create() {
+    return (vworm_init() != 0);
+}
+
+
+
+
+int main(int argc, char** argv) {
+    int     opt;
+    ot_int  i;
+    ot_u32  seed    = 1;
+    ot_int  kills   = 200;
+    ot_int  missing = 0;
+
+    while ((opt = getopt(argc, argv, "s:k:")) != -1) {
+        switch (opt) {
+            case 's':   seed    = (ot_u32)strtoul(optarg, NULL, 0);    break;
+            case 'k':   kills   = atoi(optarg);                         break;
+            default:    fprintf(stderr, "Usage: %s [-s seed] [-k kills]\n", argv[0]);
+                        return 1;
+        }
+    }
+    srand(seed);
+    unlink(VWORM_IMAGE_FILE);
+    sub_remove_temps();
+
+    /// 1 & 2.  The model has to be made in the parent, so the child that
+    /// writes the image uses the same random words as the parent expects.
+    sub_model_stock();
+    if (sub_child(&sub_step_new) != 0) {
+        return 1;
+    }
+    srand(seed);
+    for (i=0; i<TEST_WORDS; i++) {
+        model[i] = (ot_u16)rand();
+    }
+    if ((sub_image_size() != TEST_BYTES) || (sub_child(&sub_step_remap) != 0)) {
+        fprintf(stderr, "remap failed\n");
+        return 1;
+    }
+    printf("new image: %d bytes written, saved and read back in a new mapping\n", TEST_BYTES);
+
+    /// 3.  Half an image
+    if (truncate(VWORM_IMAGE_FILE, TEST_BYTES/2) != 0) {
+        return 1;
+    }
+    for (i=TEST_WORDS/2; i<TEST_WORDS; i++) {
+        model[i] = 0xFFFF;
+    }
+    if ((sub_child(&sub_step_grow) != 0) || (sub_image_size() != TEST_BYTES)) {
+        fprintf(stderr, "grow failed\n");
+        return 1;
+    }
+    printf("short image: grown to %d bytes, old data kept\n", TEST_BYTES);
+
+    /// 4.  Kill image creation at random points.  A killed process can leave
+    ///     its temporary file, but never a partial image.
+    for (i=0; i<kills; i++) {
+        pid_t   pid;
+        int     size;
+
+        unlink(VWORM_IMAGE_FILE);
+        fflush(stdout);
+        pid = fork();
+        if (pid == 0) {
+            _exit(sub_step_create());
+        }
+        usleep(rand() % 400);
+        kill(pid, SIGKILL);
+        waitpid(pid, NULL, 0);
+
+        size = sub_image_size();
+        if (size < 0) {
+            missing++;
+        }
+        else if (size != TEST_BYTES) {
+            fprintf(stderr, "kill %d: image is %d bytes\n", i, size);
+            return 1;
+        }
+        else {
+            sub_model_stock();
+            if (sub_child(&sub_step_remap) != 0) {
+                fprintf(stderr, "kill %d: image is not complete\n", i);
+                return 1;
+            }
+        }
+    }
+    sub_remove_temps();
+    printf("killed creation %d times: %d left no image, %d a complete one\n",
+            kills, missing, kills-missing);
+
+    unlink(VWORM_IMAGE_FILE);
+    printf("PASS\n");
+    return 0;
+}
@@ -72,6 +72,9 @@
 #define OT_PARAM_BUFFER_SIZE            1024                                // Typically, must be at least 512 bytes    
 #define OT_PARAM_WATCHDOG_PERIOD        16                                  // Number of ticks before exception, following expected event return time
 #define OT_PARAM_KERNEL_LIMIT           -1                                  // Maximum ticks between kernel calls (if<=0, no limit)
+#define OT_PARAM_AUTH_KEYCACHE_SIZE     2                                   // Expanded AES keys cached in RAM (DLL security)
+#define OT_PARAM_M2SEC_PEERS            4                                   // Senders kept for replay rejection, at least 2 (DLL/NL security)
+#define OT_PARAM_M2SEC_SAVE_FRAMES      256                                 // Frames between saves of the frame counter (DLL/NL security)
 
 #define OT_FEATURE(VAL)                 OT_FEATURE_##VAL
 #define OT_FEATURE_SERVER               ENABLED                             // "Server" is a build containing the OpenTag stack
@@ -89,6 +92,10 @@
 #define OT_FEATURE_VLNVWRITE            ENABLED                             // File writes in Veelite
 #define OT_FEATURE_VLNEW                ENABLED                            // File create/delete in Veelite
 #define OT_FEATURE_VLRESTORE            DISABLED                            // File restore in Veelite
+#define OT_FEATURE_VLINDEX              DISABLED                            // RAM index of file IDs for open (up to 768 bytes)
+#define OT_FEATURE_VLDEFRAG             DISABLED                            // Move files in idle time to defragment Veelite heaps
+#define OT_FEATURE_VLJOURNAL            DISABLED                            // Journal Flash writes, merge them in idle time (X2 cores)
+#define OT_FEATURE_VLSYNC               DISABLED                            // Sync written ISF mirror words to Flash in idle time
 #define OT_FEATURE_VL_SECURITY          NOT_AVAILABLE                       // AES128 on pre-shared key, for stored files
 #define OT_FEATURE_DLL_SECURITY         DISABLED                            // AES128 on pre-shared key, for data-link
 #define OT_FEATURE_NL_SECURITY          NOT_AVAILABLE                       // Network Layer Security & key exchange
@@ -152,6 +159,12 @@
 #define M2_FEATURE_DATASTREAM           M2_FEATURE_M2DP
 #define M2_FEATURE_FECTX                ENABLED   /* test */                          // FEC support for transmissions
 #define M2_FEATURE_FECRX                ENABLED  /* test */                          // FEC support for receptions
+#define M2_FEATURE_FECTXTABLE           ENABLED                             // Byte-wise table FEC encoder (1KB const data)
+#define M2_FEATURE_FECRXACS             ENABLED                             // Packed add-compare-select Viterbi decoder
+#define M2_FEATURE_FECSOFT              ENABLED                             // Soft-decision FEC RX, if radio has RF_FEATURE(SOFTBITS)
+#define M2_FEATURE_PN9TABLE             DISABLED                            // PN9 keystream table (511 bytes const data, for parts with Flash to spare)
+#define M2_FEATURE_BLOCKCODEC           DISABLED                            // Whole-buffer encode/decode API (for gateways)
+#define M2_FEATURE_QCACHE               DISABLED                            // Cache query results for repeated multicast queries
 #define M2_FEATURE_BASE                 ENABLED                             // Base channels (ch 07, 87)
 #define M2_FEATURE_NORMAL               ENABLED                             // Low-speed channels (ch 1x, 9x)
 #define M2_FEATURE_TURBO                ENABLED                             // High-speed channels (ch 2x, Ax)
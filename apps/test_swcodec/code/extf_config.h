@@ -98,6 +98,7 @@
 //#define EXTF_em2_decode_newframe
 //#define EXTF_em2_remaining_frames
 //#define EXTF_em2_remaining_bytes
+//#define EXTF_em2_crc_check
 //#define EXTF_em2_complete
 
 
@@ -350,6 +351,7 @@
 //#define EXTF_vworm_get
 //#define EXTF_vworm_print_table
 //#define EXTF_vworm_wipeblock
+//#define EXTF_vworm_journal_step
 //#define EXTF_vsram_read
 //#define EXTF_vsram_mark
 //#define EXTF_vsram_mark_physical
@@ -379,11 +381,20 @@
 //#define EXTF_ISF_chmod_su
 //#define EXTF_vl_read
 //#define EXTF_vl_write
+//#define EXTF_vl_read_block
+//#define EXTF_vl_write_block
 //#define EXTF_vl_close
 //#define EXTF_vl_checklength
 //#define EXTF_vl_checkalloc
+//#define EXTF_vl_genmask
+//#define EXTF_vl_gensum
+//#define EXTF_vl_series_open
+//#define EXTF_vl_series_next
+//#define EXTF_vl_series_close
+//#define EXTF_vl_defrag_step
 //#define EXTF_ISF_syncmirror
 //#define EXTF_ISF_loadmirror
+//#define EXTF_ISF_syncmirror_step
 
 
 
@@ -191,6 +191,7 @@
 #define MCU_PARAM_XTALtol               0.0001                  // Uncomment (and change) if using XTAL
 //#define MCU_PARAM_OSCHz                 8000000                 // OSC can do 8 MHz
 //#define MCU_PARAM_OSCtol                0.02                    // STM32 Osc typ +/- 1%
+#define MCU_PARAM_CRCSLICE              4                       // SW CRC block engine: bytes per step (1, 4, 8)
   
 #if defined(MCU_PARAM_LFXTALHz)
 #   define PLATFORM_LSCLOCK_HZ      MCU_PARAM_LFXTALHz
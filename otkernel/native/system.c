@@ -808,6 +808,20 @@ ot_uint sys_event_manager(ot_uint elapsed) {
                 if (event_eta <= 0) {
                     break;
                 }
+                
+#               if (OT_FEATURE(VLDEFRAG) == ENABLED)
+                    // Use idle time to move one Veelite file, and then come
+                    // back around, since the move takes time.
+                    if (vl_defrag_step()) break;
+#               endif
+#               if (OT_FEATURE(VLJOURNAL) == ENABLED)
+                    // Use idle time to merge one journaled Veelite block.
+                    if (vworm_journal_step()) break;
+#               endif
+#               if (OT_FEATURE(VLSYNC) == ENABLED)
+                    // Use idle time to sync some written ISF mirror words.
+                    if (ISF_syncmirror_step(ISF_MIRROR_STEP_WORDS) != 0) break;
+#               endif
                 return (ot_uint)event_eta;
             } 
         
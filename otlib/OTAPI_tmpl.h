@@ -190,6 +190,7 @@ typedef struct {
 
 typedef enum {
     CMDEXT_none             = 0,
+    CMDEXT_ack_sorted       = 0x01,
     CMDEXT_no_response      = 0x02,
     CMDEXT_no_csma          = 0x04,
     CMDEXT_ca_raind         = (1<<3),
@@ -98,17 +98,28 @@ typedef unsigned short      ot_uint;
 typedef unsigned short      ot_u16;
     
 /** @typedef ot_long
-  * equivalent to @c signed @c long.  A word in OpenTag is ALWAYS 32 bits.
+  * equivalent to @c signed @c long.  A word in OpenTag is ALWAYS 32 bits, so
+  * on LP64 hosts (e.g. POSIX simulator builds) @c int is used instead.
   */
+#if defined(__LP64__) || defined(_LP64)
+typedef signed int          ot_long;
+typedef signed int          ot_s32;
+#else
 typedef signed long         ot_long;
 typedef signed long         ot_s32;
+#endif
     
     
 /** @typedef ot_ulong
   * equivalent to @c unsigned @c long.  A word in OpenTag is ALWAYS 32 bits.
   */
+#if defined(__LP64__) || defined(_LP64)
+typedef unsigned int        ot_ulong;
+typedef unsigned int        ot_u32;
+#else
 typedef unsigned long       ot_ulong;
 typedef unsigned long       ot_u32;
+#endif
     
         
 /** @typedef Twobytes
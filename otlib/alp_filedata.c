@@ -195,6 +195,14 @@ ot_bool sub_qnotfull(ot_bool write, ot_u8 write_size, Queue* q) {
 
 
 
+/// File data goes in and out of the queue in whole words (so with an odd span,
+/// the last byte is padding), as it did when it was copied word-by-word
+ot_int sub_chunklength(ot_u16 offset, ot_u16 limit) {
+    return (offset < limit) ? (ot_int)((limit - offset + 1) & ~1) : 0;
+}
+
+
+
 
 ot_int sub_fileperms(ot_bool respond, alp_record* in_rec,
                         Queue* in_q, Queue* out_q, id_tmpl* user_id ) {
@@ -336,13 +344,30 @@ ot_int sub_filedata(ot_bool respond, alp_record* in_rec,
         // Write to file
         // 1. Process error on bad ALP parameters, but still do partial write
         // 2. offset, span are adjusted to convey leftover data
-        // 3. miscellaneous write error occurs when vl_write fails
+        // 3. miscellaneous write error occurs when vl_write_block fails
+        // 4. data is moved as one block: as many words as there are in in_q
         if (file_mod) {
-            for (; offset<limit; offset+=2, span-=2, data_in-=2) {
-                if (in_q->getcursor >= in_q->back) {
-                    goto sub_filedata_overrun;
-                }
-                err_code |= vl_write(fp, offset, q_readshort_be(in_q));
+            ot_int  chunk   = sub_chunklength(offset, limit);
+            ot_int  avail   = (ot_int)(in_q->back - in_q->getcursor);
+            ot_bool overrun = False;
+            
+            avail = (avail > 0) ? ((avail + 1) & ~1) : 0;
+            if (chunk > avail) {
+                chunk   = avail;
+                overrun = True;
+            }
+            if (chunk > 0) {
+                ot_int write_len;
+                write_len       = (ot_int)(limit - offset);
+                write_len       = (write_len < chunk) ? write_len : chunk;
+                err_code       |= vl_write_block(fp, offset, write_len, in_q->getcursor);
+                in_q->getcursor+= chunk;
+                offset         += chunk;
+                span           -= chunk;
+                data_in        -= chunk;
+            }
+            if (overrun) {
+                goto sub_filedata_overrun;
             }
         }
         
@@ -370,11 +395,26 @@ ot_int sub_filedata(ot_bool respond, alp_record* in_rec,
             q_writeshort(out_q, span);
             data_out += 6;
             
-            for (; offset<limit; offset+=2, span-=2, data_out+=2) {
-                if ((out_q->putcursor+2) >= out_q->back) {
+            {   ot_int  chunk   = sub_chunklength(offset, limit);
+                ot_int  room    = (ot_int)(out_q->back - out_q->putcursor) - 1;
+                ot_bool overrun = False;
+                
+                room = (room > 0) ? (room & ~1) : 0;
+                if (chunk > room) {
+                    chunk   = room;
+                    overrun = True;
+                }
+                if (chunk > 0) {
+                    vl_read_block(fp, offset, chunk, out_q->putcursor);
+                    out_q->putcursor   += chunk;
+                    out_q->length      += chunk;
+                    offset             += chunk;
+                    span               -= chunk;
+                    data_out           += chunk;
+                }
+                if (overrun) {
                     goto sub_filedata_overrun;
                 }
-                q_writeshort_be(out_q, vl_read(fp, offset));
             }
         }
         
@@ -79,6 +79,34 @@ typedef struct {
 
 
 
+/** @typedef auth_keycache_item
+  * Expanded AES128 key, cached in RAM.  Expanding the key costs more than 
+  * encrypting a block, so it is done once per key, not once per frame.  Only
+  * encryption schedules are cached: DLL security is CCM, which uses the block
+  * cipher in the forward direction to decrypt as well as to encrypt.
+  *
+  * ot_u8   key_id:     ISF ID of the key file
+  * ot_u8   valid:      0 if the item is empty
+  * ot_u32  expkey[]:   encryption key schedule
+  */
+#ifndef OT_PARAM_AUTH_KEYCACHE_SIZE
+#   define OT_PARAM_AUTH_KEYCACHE_SIZE  2
+#endif
+#define _SEC_KEYCACHESIZE   OT_PARAM(AUTH_KEYCACHE_SIZE)
+
+#if (AES_NEEDED)
+typedef struct {
+    ot_u8   key_id;
+    ot_u8   valid;
+    ot_u32  expkey[AES_EXPKEY_SIZE];
+} auth_keycache_item;
+
+    auth_keycache_item  auth_keycache[_SEC_KEYCACHESIZE];
+    ot_u8               auth_keycache_next;
+#endif
+
+
+
 
 
 
@@ -114,6 +142,13 @@ void crypto_clean();
 
 
 void auth_init() { 
+#if (AES_NEEDED)
+    ot_int i;
+    for (i=0; i<_SEC_KEYCACHESIZE; i++) {
+        auth_keycache[i].valid = 0;
+    }
+    auth_keycache_next = 0;
+#endif
 #if (_SEC_NLS)
 ///@todo
 #endif
@@ -200,6 +235,48 @@ auth_entry* auth_search_user(id_tmpl* user_id, ot_u8 mod_flags) {
 }
 
 
+ot_u32* auth_get_expkey(ot_u8 key_id) {
+#if (AES_NEEDED)
+    ot_int  i;
+    ot_u32  key[AES_KEY_SIZE];
+    auth_keycache_item* item;
+    
+    for (i=0; i<_SEC_KEYCACHESIZE; i++) {
+        if ((auth_keycache[i].valid != 0) && (auth_keycache[i].key_id == key_id)) {
+            return auth_keycache[i].expkey;
+        }
+    }
+    
+    /// Miss: expand the key into the next slot (round-robin replacement)
+    item                = &auth_keycache[auth_keycache_next];
+    auth_keycache_next  = (auth_keycache_next + 1) % _SEC_KEYCACHESIZE;
+    item->key_id        = key_id;
+    item->valid         = 1;
+    
+    AES_load_static_key(key_id, key);
+    AES_keyschedule_enc(key, item->expkey);
+    return item->expkey;
+    
+#else
+    return NULL;
+#endif
+}
+
+
+
+void auth_invalidate_key(ot_u8 key_id) {
+#if (AES_NEEDED)
+    ot_int i;
+    for (i=0; i<_SEC_KEYCACHESIZE; i++) {
+        if (auth_keycache[i].key_id == key_id) {
+            auth_keycache[i].valid = 0;
+        }
+    }
+#endif
+}
+
+
+
 ot_u8* auth_get_dllskey(ot_u8 protocol, ot_u8* header) {
 #if (_SEC_DLL)
     ot_u8 offset;
@@ -129,6 +129,36 @@ auth_entry* auth_search_user(id_tmpl* user_id, ot_u8 mod_flags);
 
 
 
+/** @brief Returns the AES128 encryption key schedule of a key file, from a
+  *        RAM cache
+  * @param key_id   (ot_u8) ISF ID of the key file
+  * @retval ot_u32* Expanded key (AES_EXPKEY_SIZE words), for AES_encrypt() and
+  *                 the AES_ccm functions.  NULL if AES is not built.
+  * @ingroup Authentication
+  *
+  * The key is loaded and expanded only on a cache miss, so the block cipher
+  * is the only per-frame cost of DLL security.  The cache is in its own RAM,
+  * not in the TX or RX queue, and it has OT_PARAM(AUTH_KEYCACHE_SIZE) keys.
+  */
+ot_u32* auth_get_expkey(ot_u8 key_id);
+
+
+
+/** @brief Drops any cached key schedule of a key file
+  * @param key_id   (ot_u8) ISF ID of the key file
+  * @retval None
+  * @ingroup Authentication
+  *
+  * Veelite calls this on every write to an ISF (vl_write(), vl_write_block()
+  * and vl_store()) and when an ISF is deleted, with the ID of that ISF, so a 
+  * key that has been rewritten is expanded again the next time it is used.
+  * IDs that are not in the cache are ignored, so the cost of a write to any 
+  * other ISF is one pass over the small key cache.
+  */
+void auth_invalidate_key(ot_u8 key_id);
+
+
+
 /** @brief Returns the stored User or Root key that matches the protocol ID
   * @param protocol (ot_u8) Protocol ID of the DLLS method
   * @param header   (ot_u8*) optional header data (defined by protocol ID) 
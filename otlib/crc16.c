@@ -32,9 +32,40 @@
 
 
 
-#if (MCU_FEATURE(CRC) == DISABLED)
-//#   error Warning: Comment this line if you want to enable the CRC Table
-#   include "crc16_table.h"
+/** @note CRC_SLICE, CRC_PCLMUL
+  * These select the engine crc_calc_block() uses when there is no HW CRC.  
+  * CRC_SLICE is the number of bytes done per step: 1 uses only crc_table, and
+  * 4 or 8 also use the slice tables from crc16_slice.h, which is a good deal
+  * for 32 bit MCUs.  Set it in the board header with MCU_PARAM_CRCSLICE.
+  * CRC_PCLMUL folds 16 bytes per step with the x86 carry-less multiply, and it
+  * is used on hosts when the compiler targets it (e.g. -mpclmul -mssse3).
+  */
+#ifndef CRC_SLICE
+#   ifdef MCU_PARAM_CRCSLICE
+#       define CRC_SLICE    MCU_PARAM(CRCSLICE)
+#   else
+#       define CRC_SLICE    1
+#   endif
+#endif
+
+#if ((CRC_SLICE != 1) && (CRC_SLICE != 4) && (CRC_SLICE != 8))
+#   error "CRC_SLICE must be 1, 4, or 8"
+#endif
+
+#if (defined(__PCLMUL__) && defined(__SSSE3__))
+#   define CRC_PCLMUL   1
+#   include <wmmintrin.h>
+#   include <tmmintrin.h>
+#else
+#   define CRC_PCLMUL   0
+#endif
+
+
+
+/// The tables are used by the SW CRC, and by the crc_ctx functions even when
+/// there is a HW CRC (a HW CRC can only do one thing at once).
+#include "crc16_table.h"
+#include "crc16_slice.h"
 
 
     /** @var crc_table
@@ -77,7 +108,6 @@
             CRCxF0, CRCxF1, CRCxF2, CRCxF3, CRCxF4, CRCxF5, CRCxF6, CRCxF7, 
             CRCxF8, CRCxF9, CRCxFA, CRCxFB, CRCxFC, CRCxFD, CRCxFE, CRCxFF
         }; 
-#endif
 
 
 
@@ -175,6 +205,107 @@ void sub_calc_byte() {
 
 
 
+
+/**
+  * @brief Internal function that computes the CRC of a block, CRC_SLICE bytes
+  *        at a time, and then the remaining bytes one at a time.
+  * @param crcv : (ot_u16) CRC value to start from
+  * @param data : (ot_u8*) the data block
+  * @param length : (ot_int) number of bytes in the block
+  * @retval ot_u16 : the CRC16 value after the block
+  * @ingroup CRC16
+*/
+static ot_u16 sub_calc_slice(ot_u16 crcv, ot_u8* data, ot_int length) {
+#   if (CRC_SLICE == 8)
+    while (length >= 8) {
+        crcv    = crc_slice_table[6][data[0] ^ (ot_u8)(crcv >> 8)]
+                ^ crc_slice_table[5][data[1] ^ (ot_u8)crcv]
+                ^ crc_slice_table[4][data[2]]
+                ^ crc_slice_table[3][data[3]]
+                ^ crc_slice_table[2][data[4]]
+                ^ crc_slice_table[1][data[5]]
+                ^ crc_slice_table[0][data[6]]
+                ^ crc_table[data[7]];
+        data   += 8;
+        length -= 8;
+    }
+#   elif (CRC_SLICE == 4)
+    while (length >= 4) {
+        crcv    = crc_slice_table[2][data[0] ^ (ot_u8)(crcv >> 8)]
+                ^ crc_slice_table[1][data[1] ^ (ot_u8)crcv]
+                ^ crc_slice_table[0][data[2]]
+                ^ crc_table[data[3]];
+        data   += 4;
+        length -= 4;
+    }
+#   endif
+
+    while (length > 0) {
+        crcv = (crcv << 8) ^ crc_table[(crcv >> 8) ^ *data++];
+        length--;
+    }
+    
+    return crcv;
+}
+
+
+
+#if (CRC_PCLMUL)
+/**
+  * @brief Internal function that computes the CRC of a block by folding it
+  *        16 bytes at a time, with carry-less multiplies.
+  * @param crcv : (ot_u16) CRC value to start from
+  * @param data : (ot_u8*) the data block
+  * @param length : (ot_int) number of bytes in the block
+  * @retval ot_u16 : the CRC16 value after the block
+  * @ingroup CRC16
+  *
+  * The first 16 bytes (with the CRC value XORed into the first two) are held 
+  * as a 128 bit polynomial A.  For each next 16 byte block B, A = A*x^128 + B,
+  * which stays the same mod the CRC polynomial P when A*x^128 is replaced by
+  * A.hi*(x^192 mod P) + A.lo*(x^128 mod P).  At the end, A has the same CRC as 
+  * the bytes that were folded into it, so it gets finished with the tables.
+*/
+static ot_u16 sub_calc_clmul(ot_u16 crcv, ot_u8* data, ot_int length) {
+    ot_u8   fold[16];
+    __m128i swap;
+    __m128i k;
+    __m128i a;
+
+    if (length < 32) {
+        return sub_calc_slice(crcv, data, length);
+    }
+
+    swap    = _mm_set_epi8(0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15);
+    k       = _mm_set_epi32(0, 0x650B, 0, 0xAEFC);  // x^192 mod P, x^128 mod P
+    
+    platform_memcpy(fold, data, 16);
+    fold[0] ^= (ot_u8)(crcv >> 8);
+    fold[1] ^= (ot_u8)crcv;
+    a        = _mm_shuffle_epi8(_mm_loadu_si128((__m128i*)fold), swap);
+    data    += 16;
+    length  -= 16;
+    
+    while (length >= 16) {
+        a       = _mm_xor_si128(_mm_clmulepi64_si128(a, k, 0x11), 
+                                _mm_clmulepi64_si128(a, k, 0x00));
+        a       = _mm_xor_si128(a, _mm_shuffle_epi8(_mm_loadu_si128((__m128i*)data), swap));
+        data   += 16;
+        length -= 16;
+    }
+    
+    _mm_storeu_si128((__m128i*)fold, _mm_shuffle_epi8(a, swap));
+    crcv = sub_calc_slice(0, fold, 16);
+    return sub_calc_slice(crcv, data, length);
+}
+
+#   define sub_calc_fast    sub_calc_clmul
+#else
+#   define sub_calc_fast    sub_calc_slice
+#endif
+
+
+
 void sub_stream2() {
     *crc.end 	= (ot_u8)crc.val;
     crc.stream 	= &otutils_null;
@@ -208,9 +339,8 @@ void sub_stream0() {
 
 
 ot_u16 crc_calc_block(ot_int block_size, ot_u8* block_addr) {
-/// In this function, you can see the difference between the table-based and
-/// optimized, non-table-based computation methods.  By my estimation, the
-/// table-based method is about twice as fast.
+/// Without HW CRC, the block is done by the fastest SW engine that is built
+/// (see CRC_SLICE and CRC_PCLMUL).  All of them give the same result.
 
 #if (MCU_FEATURE(CRC) == ENABLED)
     platform_crc_init();
@@ -219,14 +349,8 @@ ot_u16 crc_calc_block(ot_int block_size, ot_u8* block_addr) {
     crc.val    = platform_crc_block(block_addr, block_size);
     
 #else
-    crc.cursor = block_addr;
-    //crc.end    = block_addr + block_size;
-    crc.val    = CRCBASE;
-
-    while (block_size > 0) {
-        sub_calc_byte();
-        block_size--;
-    }
+    crc.val    = sub_calc_fast(CRCBASE, block_addr, block_size);
+    crc.cursor = block_addr + block_size;
     
 #endif
 
@@ -236,6 +360,27 @@ ot_u16 crc_calc_block(ot_int block_size, ot_u8* block_addr) {
 
 
 
+void crc_ctx_init(crc_ctx* ctx) {
+    ctx->val = CRCBASE;
+}
+
+
+
+void crc_ctx_update(crc_ctx* ctx, ot_u8* data, ot_int length) {
+    if (length > 0) {
+        ctx->val = sub_calc_fast(ctx->val, data, length);
+    }
+}
+
+
+
+ot_u16 crc_ctx_final(crc_ctx* ctx) {
+    return ctx->val;
+}
+
+
+
+
 void crc_init_stream(ot_int stream_size, ot_u8* stream_addr) {
 #if (MCU_FEATURE(CRC) == ENABLED)
     crc.cursor  = stream_addr;
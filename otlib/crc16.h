@@ -48,6 +48,17 @@ typedef struct {
 extern crc_struct crc;
 
 
+/** @typedef crc_ctx
+  * @ingroup CRC16
+  * CRC16 state that belongs to the caller, for use with the crc_ctx functions.
+  * Unlike the streaming CRC, which uses the global "crc", any number of these
+  * can be in use at the same time (e.g. one for RX and one for TX).
+  */
+typedef struct {
+    ot_u16      val;
+} crc_ctx;
+
+
 extern const ot_u16 crc_table[256];
 
 
@@ -57,6 +68,10 @@ extern const ot_u16 crc_table[256];
   * @param block_addr : (ot_u8*) address of the data block
   * @retval ot_u16 : CRC16 value
   * @ingroup CRC16
+  *
+  * Uses the HW CRC if there is one.  Otherwise, it uses a multi-byte SW engine
+  * if one is configured (MCU_PARAM_CRCSLICE = 4 or 8, or PCLMUL on x86 hosts),
+  * which is much faster than the streaming CRC and gives the same result.
   */
 ot_u16 crc_calc_block(ot_int block_size, ot_u8 *block_addr);
 
@@ -64,6 +79,59 @@ ot_u16 crc_calc_block(ot_int block_size, ot_u8 *block_addr);
 
 
 
+/** @brief Initializes a CRC16 context
+  * @param ctx : (crc_ctx*) the context
+  * @retval None
+  * @ingroup CRC16
+  */
+void crc_ctx_init(crc_ctx* ctx);
+
+
+
+/** @brief Adds a chunk of data to a CRC16 context
+  * @param ctx : (crc_ctx*) the context
+  * @param data : (ot_u8*) the chunk of data
+  * @param length : (ot_int) number of bytes in the chunk (may be 0)
+  * @retval None
+  * @ingroup CRC16
+  *
+  * Data may be added in chunks of any size, and the result is the same as if
+  * it was all in one block.  The chunk is done by the fastest SW engine that is
+  * built (see crc_calc_block()).
+  */
+void crc_ctx_update(crc_ctx* ctx, ot_u8* data, ot_int length);
+
+
+
+/** @brief Adds one byte to a CRC16 context (macro)
+  * @param CTX : (crc_ctx) the context, not a pointer to it
+  * @param DATA : (ot_u8) the byte
+  * @retval None
+  * @ingroup CRC16
+  *
+  * Same result as crc_ctx_update() with one byte, but it is a table step in 
+  * line, for loops that do other work on each byte while it is in a register
+  * (e.g. the Mode 2 codec).
+  */
+#define crc_ctx_byte(CTX, DATA) \
+    ((CTX).val = (ot_u16)(((CTX).val << 8) ^ crc_table[(ot_u8)((CTX).val >> 8) ^ (ot_u8)(DATA)]))
+
+
+
+/** @brief Returns the CRC16 value of a context
+  * @param ctx : (crc_ctx*) the context
+  * @retval ot_u16 : CRC16 of the data added so far
+  * @ingroup CRC16
+  *
+  * If the data ends with its own CRC16 (big endian), the value is 0.  The 
+  * context is not changed, so more data can be added afterwards.
+  */
+ot_u16 crc_ctx_final(crc_ctx* ctx);
+
+
+
+
+
 /** @brief Initializes streaming CRC16 engine
   * @param stream_size  (ot_int) length of datastream
   * @param stream_addr  (ot_u8*) pointer to start of datastream
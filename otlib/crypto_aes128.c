@@ -29,19 +29,20 @@
 
 
 // These operations extract a byte from an ot_u32 data:
-#define byte3(x) (x & 0xff)         /* first byte from right  */       
-#define byte2(x) ((x >> 8) & 0xff)  /* second byte from right */    
-#define byte1(x) ((x >> 16) & 0xff) /* second byte from left  */    
-#define byte0(x) (x >> 24)          /* first byte from left   */           
+#define byte3(x) ((x) & 0xff)           /* first byte from right  */       
+#define byte2(x) (((x) >> 8) & 0xff)    /* second byte from right */    
+#define byte1(x) (((x) >> 16) & 0xff)   /* second byte from left  */    
+#define byte0(x) ((x) >> 24)            /* first byte from left   */           
                                                                 
 // Return an ot_u32 from 4 ot_u8
-#define WORD8_TO_WORD32(b0, b1, b2, b3) ((ot_u32)(b0) < 24 | (ot_u32)(b1) < 16 | (ot_u32)(b2) < 8 | (b3))
+#define WORD8_TO_WORD32(b0, b1, b2, b3) \
+    (((ot_u32)(b0) << 24) | ((ot_u32)(b1) << 16) | ((ot_u32)(b2) << 8) | (ot_u32)(b3))
 
 // Multiply for 2 each byte of a WORD32 working in parallel mode on each one
-#define Xtime(x)  ((((x) & 0x7f7f7f7f) < 1) ^ ((((x) & 0x80808080) >> 7) * 0x0000001b))   
+#define Xtime(x)  ((((x) & 0x7f7f7f7f) << 1) ^ ((((x) & 0x80808080) >> 7) * 0x0000001b))   
 
-// Right shift x of n bytes
-#define upr(x,n) (x >> 8*n) | (x < (32 - 8*n))    
+// Right rotate x by n bytes
+#define upr(x,n) (((x) >> (8*(n))) | ((x) << (32 - 8*(n))))
 
 // Develop of the matrix necessary for the MixColomn procedure
 #define fwd_mcol(x)  (Xtime(x)^(upr((x^Xtime(x)),3)) ^ (upr(x,2)) ^ (upr(x,1)))   
@@ -50,9 +51,9 @@
 #define inv_mcol(x)  (f2=Xtime(x),f4=Xtime(f2),f8=Xtime(f4),(x)^=f8, f2^=f4^f8^(upr((f2^(x)),3))^(upr((f4^(x)),2))^(upr((x),1)))   
 
 // Rotation macro 
-#define rot3(x) ((x < 8 ) | (x >> 24)) /* rotate right by 24 bit */   
-#define rot2(x) ((x < 16) | (x >> 16)) /* rotate right by 16 bit */   
-#define rot1(x) ((x < 24) | (x >> 8 )) /* rotate right by 8 bit  */   
+#define rot3(x) (((x) << 8 ) | ((x) >> 24))   /* rotate right by 24 bit */   
+#define rot2(x) (((x) << 16) | ((x) >> 16))   /* rotate right by 16 bit */   
+#define rot1(x) (((x) << 24) | ((x) >> 8 ))   /* rotate right by 8 bit  */   
 
 
 
@@ -282,6 +283,78 @@ static const ot_u32 dec_table[256] = {
 
 
 
+
+#if (AES_USENI == ENABLED)
+/*******************************************************************************  
+* AES-NI (x86 hosts)
+* The round keys are the same as the T-table ones, so the key schedules just
+* append a copy of them in the byte order AES-NI uses (expkey[44..87]).  The
+* decryption keys are already the "equivalent inverse cipher" keys that 
+* AESDEC wants.  Blocks are words with the first byte on top, so each word is
+* byte-swapped on the way in and out.
+*******************************************************************************/
+#include <immintrin.h>
+
+#define AES_NI_OFFSET   44
+
+static ot_int aes_ni = -1;      // -1 = not checked yet, 0 = off, 1 = on
+
+static ot_bool sub_ni_on() {
+    if (aes_ni < 0) {
+        aes_ni = (__builtin_cpu_supports("aes") && __builtin_cpu_supports("ssse3"));
+    }
+    return (ot_bool)aes_ni;
+}
+
+ot_bool AES_use_ni(ot_bool enable) {
+    aes_ni = -1;
+    aes_ni = (enable && sub_ni_on());
+    return (ot_bool)aes_ni;
+}
+
+static void sub_ni_keycopy(ot_u32* expkey) {
+    ot_int i;
+    for (i=0; i<AES_NI_OFFSET; i++) {
+        expkey[AES_NI_OFFSET+i] = __builtin_bswap32(expkey[i]);
+    }
+}
+
+__attribute__((target("aes,ssse3")))
+static void sub_ni_encrypt(ot_u32* input_pointer, ot_u32* output_pointer, ot_u32* expkey) {
+    const __m128i swap  = _mm_set_epi8(12,13,14,15, 8,9,10,11, 4,5,6,7, 0,1,2,3);
+    const __m128i* rk   = (const __m128i*)(expkey + AES_NI_OFFSET);
+    __m128i s;
+    ot_int  r;
+    
+    s = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)input_pointer), swap);
+    s = _mm_xor_si128(s, _mm_loadu_si128(&rk[0]));
+    for (r=1; r<10; r++) {
+        s = _mm_aesenc_si128(s, _mm_loadu_si128(&rk[r]));
+    }
+    s = _mm_aesenclast_si128(s, _mm_loadu_si128(&rk[10]));
+    _mm_storeu_si128((__m128i*)output_pointer, _mm_shuffle_epi8(s, swap));
+}
+
+__attribute__((target("aes,ssse3")))
+static void sub_ni_decrypt(ot_u32* input_pointer, ot_u32* output_pointer, ot_u32* expkey) {
+    const __m128i swap  = _mm_set_epi8(12,13,14,15, 8,9,10,11, 4,5,6,7, 0,1,2,3);
+    const __m128i* rk   = (const __m128i*)(expkey + AES_NI_OFFSET);
+    __m128i s;
+    ot_int  r;
+    
+    s = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)input_pointer), swap);
+    s = _mm_xor_si128(s, _mm_loadu_si128(&rk[10]));
+    for (r=9; r>0; r--) {
+        s = _mm_aesdec_si128(s, _mm_loadu_si128(&rk[r]));
+    }
+    s = _mm_aesdeclast_si128(s, _mm_loadu_si128(&rk[0]));
+    _mm_storeu_si128((__m128i*)output_pointer, _mm_shuffle_epi8(s, swap));
+}
+
+#endif
+
+
+
    
 
    
@@ -292,14 +365,22 @@ static const ot_u32 dec_table[256] = {
 
 
 void AES_load_static_key(ot_u8 key_id, ot_u32* key) {
-    ot_int i;
+/// The key is a byte string in the file, and it is packed big-endian into 
+/// words so that the cipher is standard AES (see crypto_aes128.h)
+    ot_int  i;
+    ot_u8   keybytes[16];
     vlFILE* fp;
     
     fp = ISF_open_su(key_id);
     for (i=0; i<16; i+=2) {
-        *(ot_u16*)((ot_u8*)key+i) = vl_read(fp, i);
+        *(ot_u16*)&keybytes[i] = vl_read(fp, i);
     }
     vl_close(fp);
+    
+    for (i=0; i<4; i++) {
+        key[i] = WORD8_TO_WORD32(keybytes[(i<<2)+0], keybytes[(i<<2)+1], 
+                                 keybytes[(i<<2)+2], keybytes[(i<<2)+3]);
+    }
 }
 
 
@@ -310,7 +391,7 @@ void AES_load_static_key(ot_u8 key_id, ot_u32* key) {
 * Description    : According to key computes the expanded key exp for AES128   
 *                  encryption.  
 * Input          : key: user key (128 bits / 16 bytes)
-* Output         : expkey: expanded key (352 bits / 44 bytes)
+* Output         : expkey: expanded key (AES_EXPKEY_SIZE words)
 * Return         : None  
 *******************************************************************************/   
 void AES_keyschedule_enc(ot_u32* key, ot_u32* expkey) {
@@ -347,6 +428,10 @@ void AES_keyschedule_enc(ot_u32* key, ot_u32* expkey) {
         local_pointer[2] = copy2;   
         local_pointer[3] = copy3;   
     }
+    
+#   if (AES_USENI == ENABLED)
+    sub_ni_keycopy(expkey);
+#   endif
 #endif
 }      
 
@@ -358,7 +443,7 @@ void AES_keyschedule_enc(ot_u32* key, ot_u32* expkey) {
 * Description    : According to key computes the expanded key (expkey) for AES128   
 *                  decryption.  
 * Input          : key: user key (128 bits / 16 bytes)
-* Output         : expkey: expanded key (320 bits / 40 bytes)
+* Output         : expkey: expanded key (AES_EXPKEY_SIZE words)
 * Return         : None  
 *******************************************************************************/   
 void AES_keyschedule_dec(ot_u32* key, ot_u32* expkey) {
@@ -408,8 +493,12 @@ void AES_keyschedule_dec(ot_u32* key, ot_u32* expkey) {
                            rot3(dec_table[Sbox[byte3(copy3)]]);   
   }
   
+#   if (AES_USENI == ENABLED)
+    sub_ni_keycopy(expkey);
+#   endif
+  
 #elif (AES_USELITE == ENABLED)
-    AES_keyschedule_enc(key, exp);
+    AES_keyschedule_enc(key, expkey);
 #endif
 }   
 
@@ -428,6 +517,12 @@ void AES_encrypt(ot_u32* input_pointer, ot_u32* output_pointer, ot_u32* expkey)
 #if (AES_USEHW == ENABLED)
 
 #elif (AES_USEFAST == ENABLED)
+#   if (AES_USENI == ENABLED)
+    if (sub_ni_on()) {
+        sub_ni_encrypt(input_pointer, output_pointer, expkey);
+        return;
+    }
+#   endif
   register ot_u32 s0;   
   register ot_u32 s1;   
   register ot_u32 s2;   
@@ -609,6 +704,12 @@ void AES_decrypt(ot_u32* input_pointer, ot_u32* output_pointer, ot_u32* expkey)
 #if (AES_USEHW == ENABLED)
 
 #elif (AES_USEFAST == ENABLED)   
+#   if (AES_USENI == ENABLED)
+    if (sub_ni_on()) {
+        sub_ni_decrypt(input_pointer, output_pointer, expkey);
+        return;
+    }
+#   endif
   register ot_u32 s0;   
   register ot_u32 s1;   
   register ot_u32 s2;   
@@ -772,10 +873,167 @@ void AES_decrypt(ot_u32* input_pointer, ot_u32* output_pointer, ot_u32* expkey)
   output_pointer[2] = t2;   
   output_pointer[3] = t3;
 #endif
-}   
+}
 
 
-   
-   
-   
-   
+
+
+#if (AES_NEEDED)
+/*******************************************************************************  
+* AES-CCM (counter mode + CBC-MAC)
+* The CCM blocks are byte strings, and this AES works on 32 bit words with the
+* first byte in the top bits, so blocks are packed big-endian for the cipher.
+* For each 16 bytes of message, there is one block cipher call for the MAC and
+* one for the keystream, and each byte is read and written once.
+*******************************************************************************/
+static void sub_ccm_cipher(ot_u8* block, ot_u32* expkey) {
+/// Encrypts a 16 byte block in place
+    ot_u32  word[4];
+    ot_int  i;
+    
+    for (i=0; i<4; i++) {
+        word[i] = ((ot_u32)block[(i<<2)+0] << 24) | ((ot_u32)block[(i<<2)+1] << 16) | 
+                  ((ot_u32)block[(i<<2)+2] << 8)  |  (ot_u32)block[(i<<2)+3];
+    }
+    AES_encrypt(word, word, expkey);
+    for (i=0; i<4; i++) {
+        block[(i<<2)+0] = (ot_u8)(word[i] >> 24);
+        block[(i<<2)+1] = (ot_u8)(word[i] >> 16);
+        block[(i<<2)+2] = (ot_u8)(word[i] >> 8);
+        block[(i<<2)+3] = (ot_u8)word[i];
+    }
+}
+
+
+static void sub_ccm_macbyte(aes_ccm_ctx* ccm, ot_u8 data) {
+    ccm->mac[ccm->mac_pos++] ^= data;
+    if (ccm->mac_pos == 16) {
+        sub_ccm_cipher(ccm->mac, ccm->expkey);
+        ccm->mac_pos = 0;
+    }
+}
+
+
+static void sub_ccm_macflush(aes_ccm_ctx* ccm) {
+/// Zero pads and closes the current CBC-MAC block, if it is partly used
+    if (ccm->mac_pos != 0) {
+        sub_ccm_cipher(ccm->mac, ccm->expkey);
+        ccm->mac_pos = 0;
+    }
+}
+
+
+static ot_u8 sub_ccm_padbyte(aes_ccm_ctx* ccm) {
+/// Returns the next keystream byte.  The counter is in the last 2 bytes of A_i.
+    if (ccm->pad_pos == 16) {
+        if (++ccm->ctr[15] == 0) {
+            ccm->ctr[14]++;
+        }
+        platform_memcpy(ccm->pad, ccm->ctr, 16);
+        sub_ccm_cipher(ccm->pad, ccm->expkey);
+        ccm->pad_pos = 0;
+    }
+    return ccm->pad[ccm->pad_pos++];
+}
+
+
+static void sub_ccm_startmsg(aes_ccm_ctx* ccm) {
+/// The AAD ends with a zero padded block before the message starts
+    if (ccm->aad_open) {
+        sub_ccm_macflush(ccm);
+        ccm->aad_open = 0;
+    }
+}
+
+
+
+void AES_ccm_init(aes_ccm_ctx* ccm, ot_u32* expkey, ot_u8* nonce, 
+                    ot_int aad_len, ot_int msg_len, ot_u8 mac_len) {
+    ccm->expkey     = expkey;
+    ccm->mac_len    = mac_len;
+    ccm->aad_open   = (aad_len > 0);
+    
+    /// B_0 = Flags | Nonce | message length.  The flags give the AAD bit, the
+    /// MIC length and the length field size (2 bytes, stored as 2-1).
+    ccm->mac[0]     = (ccm->aad_open << 6) | (((mac_len - 2) >> 1) << 3) | 1;
+    platform_memcpy(&ccm->mac[1], nonce, AES_CCM_NONCE_SIZE);
+    ccm->mac[14]    = (ot_u8)(msg_len >> 8);
+    ccm->mac[15]    = (ot_u8)msg_len;
+    sub_ccm_cipher(ccm->mac, expkey);
+    ccm->mac_pos    = 0;
+    
+    /// The AAD is preceded by its 2 byte length
+    if (ccm->aad_open) {
+        sub_ccm_macbyte(ccm, (ot_u8)(aad_len >> 8));
+        sub_ccm_macbyte(ccm, (ot_u8)aad_len);
+    }
+    
+    /// A_0 = Flags | Nonce | 0.  A_0 is for the MIC, so the message starts
+    /// with A_1: pad_pos = 16 makes the first keystream byte advance to it.
+    ccm->ctr[0]     = 1;
+    platform_memcpy(&ccm->ctr[1], nonce, AES_CCM_NONCE_SIZE);
+    ccm->ctr[14]    = 0;
+    ccm->ctr[15]    = 0;
+    ccm->pad_pos    = 16;
+}
+
+
+
+void AES_ccm_aad(aes_ccm_ctx* ccm, ot_u8* data, ot_int length) {
+    while (--length >= 0) {
+        sub_ccm_macbyte(ccm, *data++);
+    }
+}
+
+
+
+void AES_ccm_encrypt(aes_ccm_ctx* ccm, ot_u8* data, ot_int length) {
+    sub_ccm_startmsg(ccm);
+    while (--length >= 0) {
+        sub_ccm_macbyte(ccm, *data);
+        *data++ ^= sub_ccm_padbyte(ccm);
+    }
+}
+
+
+
+void AES_ccm_decrypt(aes_ccm_ctx* ccm, ot_u8* data, ot_int length) {
+    sub_ccm_startmsg(ccm);
+    while (--length >= 0) {
+        *data ^= sub_ccm_padbyte(ccm);
+        sub_ccm_macbyte(ccm, *data++);
+    }
+}
+
+
+
+void AES_ccm_final(aes_ccm_ctx* ccm, ot_u8* mic) {
+    ot_int i;
+    
+    /// T = first mac_len bytes of the CBC-MAC, which is encrypted with S_0
+    sub_ccm_startmsg(ccm);
+    sub_ccm_macflush(ccm);
+    ccm->ctr[14] = 0;
+    ccm->ctr[15] = 0;
+    sub_ccm_cipher(ccm->ctr, ccm->expkey);
+    
+    for (i=0; i<ccm->mac_len; i++) {
+        mic[i] = ccm->mac[i] ^ ccm->ctr[i];
+    }
+}
+
+
+
+ot_bool AES_ccm_verify(aes_ccm_ctx* ccm, ot_u8* mic) {
+    ot_u8   check[16];
+    ot_u8   diff = 0;
+    ot_int  i;
+    
+    AES_ccm_final(ccm, check);
+    for (i=0; i<ccm->mac_len; i++) {
+        diff |= check[i] ^ mic[i];
+    }
+    return (ot_bool)(diff == 0);
+}
+#endif
+
@@ -43,12 +43,30 @@
   *      
   * fast - version with different key-schedule for encryption/decryption using: 
   *        256 + 256 + 10*4 + 256*4*2 bytes data = 2058 bytes of look-up table.
+  *        Each round is 16 lookups in one 32 bit "T-table" per direction, and
+  *        the other three columns are rotations of it, which are free on ARM
+  *        (STM32).  This is the default when there is no HW AES.
+  *
+  * "lite" is selected with MCU_FEATURE_AES128_LITE.  On x86 host builds (the
+  * POSIX gateway) with GCC or Clang, "fast" also gets an AES-NI path, which is
+  * used when the CPU has AES-NI (checked at run-time).  AES-NI keeps a copy of
+  * the key schedule in its own byte order, so the expanded key is larger.
+  *
+  * Blocks and keys are 32 bit words with the first byte in the top bits, so
+  * byte strings must be packed big-endian (AES_load_static_key() does this for
+  * keys, and the CCM functions for their blocks).
   */
 
-#define AES_NEEDED      (OT_FEATURE(DLL_SECURITY) || OT_FEATURE(VL_SECURITY))
+#define AES_NEEDED      (OT_FEATURE(DLL_SECURITY) || OT_FEATURE(NL_SECURITY) || OT_FEATURE(VL_SECURITY))
 #define AES_USEHW       (AES_NEEDED && MCU_FEATURE(AES128))
-#define AES_USEFAST     (AES_NEEDED && (MCU_FEATURE(AES128)==DISABLED))
 #define AES_USELITE     (AES_NEEDED && (MCU_FEATURE(AES128)==DISABLED) && MCU_FEATURE(AES128_LITE))
+#define AES_USEFAST     (AES_NEEDED && (MCU_FEATURE(AES128)==DISABLED) && (MCU_FEATURE(AES128_LITE)!=ENABLED))
+
+#if (AES_USEFAST && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)))
+#   define AES_USENI    ENABLED
+#else
+#   define AES_USENI    DISABLED
+#endif
 
 
 // Number of 32 bit words to store an AES128 block
@@ -59,13 +77,68 @@
 
 // Number of 32bits words to store in an AES128 expanded key ...
 // The expanded key is the key after the keyschedule.
-#define AES_EXPKEY_SIZE 44 
+#if (AES_USENI == ENABLED)
+#   define AES_EXPKEY_SIZE  88
+#else
+#   define AES_EXPKEY_SIZE  44 
+#endif
+
+// Number of bytes in an AES-CCM nonce.  The 13 byte nonce leaves a 2 byte
+// message length field in the CCM blocks, which is plenty for a frame.
+#define AES_CCM_NONCE_SIZE  13
                            
 
 
+/** @typedef aes_ccm_ctx
+  * State of a streaming AES-CCM (counter mode + CBC-MAC) operation, per NIST
+  * SP 800-38C and RFC 3610.  The header (AAD) and the message can be fed in
+  * as many pieces as needed, and each message byte is encrypted (or 
+  * decrypted) and authenticated in the same pass.  CCM only uses the forward
+  * cipher, so expkey is always an encryption key schedule.
+  *
+  * expkey      (ot_u32*)   expanded key, from AES_keyschedule_enc()
+  * ctr[]       (ot_u8)     counter block, A_i
+  * mac[]       (ot_u8)     CBC-MAC block, X_i
+  * pad[]       (ot_u8)     keystream block, S_i
+  * mac_pos     (ot_u8)     bytes of the current CBC-MAC block that are used
+  * pad_pos     (ot_u8)     bytes of the current keystream block that are used
+  * mac_len     (ot_u8)     length of the MIC, 4 to 16 bytes (even)
+  * aad_open    (ot_u8)     non-zero while AAD is still being added
+  */
+typedef struct {
+    ot_u32* expkey;
+    ot_u8   ctr[16];
+    ot_u8   mac[16];
+    ot_u8   pad[16];
+    ot_u8   mac_pos;
+    ot_u8   pad_pos;
+    ot_u8   mac_len;
+    ot_u8   aad_open;
+} aes_ccm_ctx;
+
+
 
+
+/** @brief Loads a 16 byte key from an ISF into AES_KEY_SIZE words
+  * @ingroup AES128
+  */
 void AES_load_static_key(ot_u8 key_id, ot_u32* key);
 
+
+
+#if (AES_USENI == ENABLED)
+/** @brief Turns the AES-NI path on or off
+  * @param enable   (ot_bool) True to use AES-NI when the CPU has it
+  * @retval ot_bool True if AES-NI is now in use
+  * @ingroup AES128
+  *
+  * AES-NI is on by default when the CPU has it.  Turning it off is mostly for
+  * testing the T-table path on the same host.  Key schedules made either way
+  * work with both paths.
+  */
+ot_bool AES_use_ni(ot_bool enable);
+#endif
+
  
 /** @brief According to key computes the expanded key exp for AES128 encryption. 
   * @ingroup AES128
@@ -98,6 +171,67 @@ void AES_encrypt(ot_u32* input_pointer, ot_u32* output_pointer, ot_u32* expkey);
 void AES_decrypt(ot_u32* input_pointer, ot_u32* output_pointer, ot_u32* expkey); 
  
  
+ 
+/** @brief Starts an AES-CCM operation
+  * @param ccm      (aes_ccm_ctx*) CCM state to initialize
+  * @param expkey   (ot_u32*) encryption key schedule
+  * @param nonce    (ot_u8*) AES_CCM_NONCE_SIZE bytes, never reused with a key
+  * @param aad_len  (ot_int) total bytes of header that will be authenticated
+  * @param msg_len  (ot_int) total bytes of message that will be encrypted
+  * @param mac_len  (ot_u8) MIC length: 4, 6, 8, 10, 12, 14 or 16 bytes
+  * @retval None
+  * @ingroup AES128
+  */
+void AES_ccm_init(aes_ccm_ctx* ccm, ot_u32* expkey, ot_u8* nonce, 
+                    ot_int aad_len, ot_int msg_len, ot_u8 mac_len);
+
+
+
+/** @brief Authenticates (without encrypting) a piece of the header
+  * @ingroup AES128
+  *
+  * All of the AAD must be added before the first call to AES_ccm_encrypt() or
+  * AES_ccm_decrypt().
+  */
+void AES_ccm_aad(aes_ccm_ctx* ccm, ot_u8* data, ot_int length);
+
+
+
+/** @brief Authenticates and encrypts a piece of the message, in place
+  * @ingroup AES128
+  */
+void AES_ccm_encrypt(aes_ccm_ctx* ccm, ot_u8* data, ot_int length);
+
+
+
+/** @brief Decrypts and authenticates a piece of the message, in place
+  * @ingroup AES128
+  */
+void AES_ccm_decrypt(aes_ccm_ctx* ccm, ot_u8* data, ot_int length);
+
+
+
+/** @brief Finishes an AES-CCM operation and writes the MIC
+  * @param ccm      (aes_ccm_ctx*) CCM state
+  * @param mic      (ot_u8*) output, mac_len bytes
+  * @retval None
+  * @ingroup AES128
+  */
+void AES_ccm_final(aes_ccm_ctx* ccm, ot_u8* mic);
+
+
+
+/** @brief Finishes an AES-CCM operation and checks a received MIC
+  * @param ccm      (aes_ccm_ctx*) CCM state
+  * @param mic      (ot_u8*) received MIC, mac_len bytes
+  * @retval ot_bool True if the MIC matches
+  * @ingroup AES128
+  *
+  * The comparison takes the same time wherever a mismatch is.
+  */
+ot_bool AES_ccm_verify(aes_ccm_ctx* ccm, ot_u8* mic);
+ 
+ 
 
 #endif
  
@@ -38,10 +38,58 @@ fn_codec    em2_encode_data;
 fn_codec    em2_decode_data;
 
 
+/// Soft-decision FEC decoding, when the app wants it and the radio can give
+/// soft bits.  Soft costs are up to 14 per symbol instead of 2, so the start
+/// cost of the non-zero states is lower to keep the metrics in range.
+#define FEC_SOFTBITS    ((M2_FEATURE(FECSOFT) == ENABLED) && (RF_FEATURE(SOFTBITS) == ENABLED))
 
-#if ( (RF_FEATURE_CRC == ENABLED) && \
-      (RF_FEATURE_PN9 == ENABLED) && \
-      ((RF_FEATURE_FEC == ENABLED) || (M2_FEATURE(FEC) != ENABLED)) )
+#if (FEC_SOFTBITS)
+#   define FEC_STARTCOST    0x40404040
+#else
+#   define FEC_STARTCOST    0x64646464
+#endif
+
+
+
+/// The SW CRC is done in the same pass as the rest of the coding: the 
+/// encoders add each frame byte as they read it from txq, and write the CRC
+/// into txq just before it is read itself.  The decoders add each byte as 
+/// they put it into rxq, and keep em2.crc_cursor up to date, so sub_crc_rx()
+/// (which adds any bytes that are in rxq but not yet in the CRC) has nothing
+/// left to do for them.
+static ot_u8 sub_txq_readbyte() {
+    if (txq.getcursor < em2.crc_end) {
+        crc_ctx_byte(em2.crc, *txq.getcursor);
+    }
+    else if (txq.getcursor == em2.crc_end) {
+        ot_u16 crcval   = crc_ctx_final(&em2.crc);
+        em2.crc_end[0]  = (ot_u8)(crcval >> 8);
+        em2.crc_end[1]  = (ot_u8)crcval;
+    }
+    return q_readbyte(&txq);
+}
+
+#if ( (RF_FEATURE(PN9) != ENABLED) || (RF_FEATURE(CRC) != ENABLED) || \
+      ((M2_FEATURE(FECRX) == ENABLED) && (RF_FEATURE(FEC) != ENABLED) && \
+       (M2_FEATURE(FECRXACS) != ENABLED)) )
+static void sub_rxq_putbyte(ot_u8 data) {
+    crc_ctx_byte(em2.crc, data);
+    q_writebyte(&rxq, data);
+}
+#endif
+
+static void sub_crc_rx() {
+    ot_u8* end = (rxq.putcursor < em2.crc_end) ? rxq.putcursor : em2.crc_end;
+    
+    if (end > em2.crc_cursor) {
+        crc_ctx_update(&em2.crc, em2.crc_cursor, (ot_int)(end - em2.crc_cursor));
+        em2.crc_cursor = end;
+    }
+}
+
+
+
+#if ((RF_FEATURE(CRC) == ENABLED) && (RF_FEATURE(PN9) == ENABLED))
     
 #   ifndef EXTF_em2_encode_data_HW
     void em2_encode_data_HW() {
@@ -75,8 +123,7 @@ fn_codec    em2_decode_data;
 #   ifndef EXTF_em2_encode_data_HWCRC
     void em2_encode_data_HWCRC() {
         while ( (em2.bytes > 0) && (radio_txopen() == True) ) {
-            crc_calc_stream();
-            radio_putbyte( q_readbyte(&txq) );
+            radio_putbyte( sub_txq_readbyte() );
             em2.bytes--;
         }
     }
@@ -86,17 +133,15 @@ fn_codec    em2_decode_data;
     void em2_decode_data_HWCRC() {
         if (em2.state == 0) {
             em2.state--;
-            rxq.length++;
-            *rxq.putcursor  = radio_getbyte();
-            em2.bytes       = (ot_int)*rxq.putcursor /* - 1 */;		//new spec is non-inclusive length byte
-            crc_init_stream(1+em2.bytes, rxq.putcursor++);		//new spec adds +1, as it is non-inclusive
-            crc_calc_stream();
+            sub_rxq_putbyte( radio_getbyte() );
+            em2.bytes       = (ot_int)rxq.putcursor[-1] /* - 1 */;		//new spec is non-inclusive length byte
+            em2.crc_end     = rxq.putcursor + em2.bytes;	//new spec adds +1, as it is non-inclusive
         }
         while ( (em2.bytes > 0) && (radio_rxopen() == True) ) {
-            q_writebyte(&rxq, radio_getbyte() );
-            crc_calc_stream();
+            sub_rxq_putbyte( radio_getbyte() );
             em2.bytes--;
         }
+        em2.crc_cursor = rxq.putcursor;
     }
 #   endif
 #endif
@@ -104,19 +149,91 @@ fn_codec    em2_decode_data;
 
 
 #if ( (RF_FEATURE(PN9) != ENABLED) || \
-         ((M2_FEATURE(FEC) == ENABLED) && (RF_FEATURE_FEC != ENABLED)) )
+         ((M2_FEATURE(FEC) == ENABLED) && (RF_FEATURE_FEC != ENABLED)) || \
+         (M2_FEATURE(BLOCKCODEC) == ENABLED) )
 /// Only compile these functions if the RF core does not have a built-in PN9
-/// encoder/decoder.  Some radios have PN9, although it is not to the spec of
-/// Mode 2.  The CC430/CC11xx have suitable HW.  There is one other chip I know
-/// of that has suitable HW, but it is not yet public knowledge.
-
-    void init_PN9() { em2.PN9_lfsr.ushort = 0x01FF; }
-    ot_u8 get_PN9() { return em2.PN9_lfsr.ubyte[LOWER]; }
+/// encoder/decoder (or for the block codec).  Some radios have PN9, although 
+/// it is not to the spec of Mode 2.  The CC430/CC11xx have suitable HW.  There 
+/// is one other chip I know of that has suitable HW, but it is not yet public
+/// knowledge.
 
+#   if (M2_FEATURE(PN9TABLE) == ENABLED)
+    /// Keystream version: the PN9 sequence repeats every 511 bits, which is
+    /// also every 511 bytes, so the whole byte sequence from the 0x1FF seed is
+    /// a const table, and the LFSR state is just a cursor into it.
+    static const ot_u8 PN9_keystream[511] = {
+        0xFF, 0xE1, 0x1D, 0x9A, 0xED, 0x85, 0x33, 0x24, 0xEA, 0x7A, 0xD2, 0x39, 0x70, 0x97, 0x57, 0x0A,
+        0x54, 0x7D, 0x2D, 0xD8, 0x6D, 0x0D, 0xBA, 0x8F, 0x67, 0x59, 0xC7, 0xA2, 0xBF, 0x34, 0xCA, 0x18,
+        0x30, 0x53, 0x93, 0xDF, 0x92, 0xEC, 0xA7, 0x15, 0x8A, 0xDC, 0xF4, 0x86, 0x55, 0x4E, 0x18, 0x21,
+        0x40, 0xC4, 0xC4, 0xD5, 0xC6, 0x91, 0x8A, 0xCD, 0xE7, 0xD1, 0x4E, 0x09, 0x32, 0x17, 0xDF, 0x83,
+        0xFF, 0xF0, 0x0E, 0xCD, 0xF6, 0xC2, 0x19, 0x12, 0x75, 0x3D, 0xE9, 0x1C, 0xB8, 0xCB, 0x2B, 0x05,
+        0xAA, 0xBE, 0x16, 0xEC, 0xB6, 0x06, 0xDD, 0xC7, 0xB3, 0xAC, 0x63, 0xD1, 0x5F, 0x1A, 0x65, 0x0C,
+        0x98, 0xA9, 0xC9, 0x6F, 0x49, 0xF6, 0xD3, 0x0A, 0x45, 0x6E, 0x7A, 0xC3, 0x2A, 0x27, 0x8C, 0x10,
+        0x20, 0x62, 0xE2, 0x6A, 0xE3, 0x48, 0xC5, 0xE6, 0xF3, 0x68, 0xA7, 0x04, 0x99, 0x8B, 0xEF, 0xC1,
+        0x7F, 0x78, 0x87, 0x66, 0x7B, 0xE1, 0x0C, 0x89, 0xBA, 0x9E, 0x74, 0x0E, 0xDC, 0xE5, 0x95, 0x02,
+        0x55, 0x5F, 0x0B, 0x76, 0x5B, 0x83, 0xEE, 0xE3, 0x59, 0xD6, 0xB1, 0xE8, 0x2F, 0x8D, 0x32, 0x06,
+        0xCC, 0xD4, 0xE4, 0xB7, 0x24, 0xFB, 0x69, 0x85, 0x22, 0x37, 0xBD, 0x61, 0x95, 0x13, 0x46, 0x08,
+        0x10, 0x31, 0x71, 0xB5, 0x71, 0xA4, 0x62, 0xF3, 0x79, 0xB4, 0x53, 0x82, 0xCC, 0xC5, 0xF7, 0xE0,
+        0x3F, 0xBC, 0x43, 0xB3, 0xBD, 0x70, 0x86, 0x44, 0x5D, 0x4F, 0x3A, 0x07, 0xEE, 0xF2, 0x4A, 0x81,
+        0xAA, 0xAF, 0x05, 0xBB, 0xAD, 0x41, 0xF7, 0xF1, 0x2C, 0xEB, 0x58, 0xF4, 0x97, 0x46, 0x19, 0x03,
+        0x66, 0x6A, 0xF2, 0x5B, 0x92, 0xFD, 0xB4, 0x42, 0x91, 0x9B, 0xDE, 0xB0, 0xCA, 0x09, 0x23, 0x04,
+        0x88, 0x98, 0xB8, 0xDA, 0x38, 0x52, 0xB1, 0xF9, 0x3C, 0xDA, 0x29, 0x41, 0xE6, 0xE2, 0x7B, 0xF0,
+        0x1F, 0xDE, 0xA1, 0xD9, 0x5E, 0x38, 0x43, 0xA2, 0xAE, 0x27, 0x9D, 0x03, 0x77, 0x79, 0xA5, 0x40,
+        0xD5, 0xD7, 0x82, 0xDD, 0xD6, 0xA0, 0xFB, 0x78, 0x96, 0x75, 0x2C, 0xFA, 0x4B, 0xA3, 0x8C, 0x01,
+        0x33, 0x35, 0xF9, 0x2D, 0xC9, 0x7E, 0x5A, 0xA1, 0xC8, 0x4D, 0x6F, 0x58, 0xE5, 0x84, 0x11, 0x02,
+        0x44, 0x4C, 0x5C, 0x6D, 0x1C, 0xA9, 0xD8, 0x7C, 0x1E, 0xED, 0x94, 0x20, 0x73, 0xF1, 0x3D, 0xF8,
+        0x0F, 0xEF, 0xD0, 0x6C, 0x2F, 0x9C, 0x21, 0x51, 0xD7, 0x93, 0xCE, 0x81, 0xBB, 0xBC, 0x52, 0xA0,
+        0xEA, 0x6B, 0xC1, 0x6E, 0x6B, 0xD0, 0x7D, 0x3C, 0xCB, 0x3A, 0x16, 0xFD, 0xA5, 0x51, 0xC6, 0x80,
+        0x99, 0x9A, 0xFC, 0x96, 0x64, 0x3F, 0xAD, 0x50, 0xE4, 0xA6, 0x37, 0xAC, 0x72, 0xC2, 0x08, 0x01,
+        0x22, 0x26, 0xAE, 0x36, 0x8E, 0x54, 0x6C, 0x3E, 0x8F, 0x76, 0x4A, 0x90, 0xB9, 0xF8, 0x1E, 0xFC,
+        0x87, 0x77, 0x68, 0xB6, 0x17, 0xCE, 0x90, 0xA8, 0xEB, 0x49, 0xE7, 0xC0, 0x5D, 0x5E, 0x29, 0x50,
+        0xF5, 0xB5, 0x60, 0xB7, 0x35, 0xE8, 0x3E, 0x9E, 0x65, 0x1D, 0x8B, 0xFE, 0xD2, 0x28, 0x63, 0xC0,
+        0x4C, 0x4D, 0x7E, 0x4B, 0xB2, 0x9F, 0x56, 0x28, 0x72, 0xD3, 0x1B, 0x56, 0x39, 0x61, 0x84, 0x00,
+        0x11, 0x13, 0x57, 0x1B, 0x47, 0x2A, 0x36, 0x9F, 0x47, 0x3B, 0x25, 0xC8, 0x5C, 0x7C, 0x0F, 0xFE,
+        0xC3, 0x3B, 0x34, 0xDB, 0x0B, 0x67, 0x48, 0xD4, 0xF5, 0xA4, 0x73, 0xE0, 0x2E, 0xAF, 0x14, 0xA8,
+        0xFA, 0x5A, 0xB0, 0xDB, 0x1A, 0x74, 0x1F, 0xCF, 0xB2, 0x8E, 0x45, 0x7F, 0x69, 0x94, 0x31, 0x60,
+        0xA6, 0x26, 0xBF, 0x25, 0xD9, 0x4F, 0x2B, 0x14, 0xB9, 0xE9, 0x0D, 0xAB, 0x9C, 0x30, 0x42, 0x80,
+        0x88, 0x89, 0xAB, 0x8D, 0x23, 0x15, 0x9B, 0xCF, 0xA3, 0x9D, 0x12, 0x64, 0x2E, 0xBE, 0x07
+    };
+    
+#   define PN9_SEED     0
+    
+    static ot_u16 sub_PN9_block(ot_u8* data, ot_int length, ot_u16 pn9) {
+    /// XORs the keystream into data and returns the advanced cursor.  There is
+    /// no dependency between bytes in the inner loop, so compilers turn it into
+    /// word (or vector) XORs.
+        while (length > 0) {
+            ot_int i, span;
+            span = 511 - pn9;
+            if (span > length) {
+                span = length;
+            }
+            for (i=0; i<span; i++) {
+                data[i] ^= PN9_keystream[pn9+i];
+            }
+            data   += span;
+            length -= span;
+            pn9    += span;
+            if (pn9 == 511) {
+                pn9 = 0;
+            }
+        }
+        return pn9;
+    }
+    
+    ot_u8 get_PN9() { return PN9_keystream[em2.PN9_state]; }
+    
     void rotate_PN9() {
-    /// Nibble-wise PN9 implementation.  Runs pretty fast, no table.
-#       define PN9reg       em2.PN9_lfsr.ushort
+        if (++em2.PN9_state == 511) {
+            em2.PN9_state = 0;
+        }
+    }
 
+#   else
+#   define PN9_SEED     0x01FF
+
+    static ot_u16 sub_PN9_rotate(ot_u16 PN9reg) {
+    /// Nibble-wise PN9 implementation.  Runs pretty fast, no table.
         ot_u16 x;
         x           = (PN9reg << 5) ^ PN9reg;
         x          &= 0x01E0;
@@ -126,15 +243,49 @@ fn_codec    em2_decode_data;
         x          &= 0x01E0;
         PN9reg    >>= 4;
         PN9reg     |= x;
+        return PN9reg;
     }
+    
+    static ot_u16 sub_PN9_block(ot_u8* data, ot_int length, ot_u16 pn9) {
+    /// XORs the PN9 sequence into data and returns the advanced LFSR
+        for (; length > 0; length--) {
+            *data++ ^= (ot_u8)pn9;
+            pn9      = sub_PN9_rotate(pn9);
+        }
+        return pn9;
+    }
+    
+    ot_u8 get_PN9() { return (ot_u8)em2.PN9_state; }
+    void rotate_PN9() { em2.PN9_state = sub_PN9_rotate(em2.PN9_state); }
+#   endif
+
+    void init_PN9() { em2.PN9_state = PN9_SEED; }
 #endif
     
 #if (RF_FEATURE(PN9) != ENABLED)
 #   ifndef EXTF_em2_encode_data_PN9
     void em2_encode_data_PN9() {
+        // Fused kernel: four frame bytes at a time are added to the CRC, 
+        // whitened, and put to the radio as one group (MSB first, which is 
+        // how radio_putfourbytes() sends a 32 bit word).  The group that has
+        // the CRC, and any bytes after, go one at a time.
+        while ( ((em2.crc_end - txq.getcursor) >= 4) && (radio_txopen_4() == True) ) {
+            ot_u8       data[4];
+            Fourbytes   group;
+            ot_int      i;
+            for (i=0; i<4; i++) {
+                data[i] = txq.getcursor[i];
+                crc_ctx_byte(em2.crc, data[i]);
+            }
+            txq.getcursor  += 4;
+            em2.bytes      -= 4;
+            em2.PN9_state   = sub_PN9_block(data, 4, em2.PN9_state);
+            group.ulong     = ((ot_u32)data[0] << 24) | ((ot_u32)data[1] << 16) | \
+                              ((ot_u32)data[2] << 8)  | (ot_u32)data[3];
+            radio_putfourbytes(&group.ubyte[0]);
+        }
         while ( (em2.bytes > 0) && (radio_txopen() == True) ) {
-            crc_calc_stream();
-            radio_putbyte( q_readbyte(&txq) ^ get_PN9() );
+            radio_putbyte( sub_txq_readbyte() ^ get_PN9() );
             rotate_PN9();
             em2.bytes--;
         }
@@ -147,19 +298,34 @@ fn_codec    em2_decode_data;
     void em2_decode_data_PN9() {
         if (em2.state == 0) {
             em2.state--;
-            rxq.length++;
-            *rxq.putcursor  = (radio_getbyte() ^ get_PN9());
-            em2.bytes       = (ot_int)*rxq.putcursor/* - 1*/;
-            crc_init_stream(em2.bytes+1 /*rxq.front[0]*/, rxq.putcursor++);
-            crc_calc_stream();
+            sub_rxq_putbyte( radio_getbyte() ^ get_PN9() );
+            em2.bytes       = (ot_int)rxq.putcursor[-1]/* - 1*/;
+            em2.crc_end     = rxq.putcursor + em2.bytes;
             rotate_PN9();
         }
+        
+        // Fused kernel: the inverse of em2_encode_data_PN9().  Each group of
+        // four bytes from the radio is de-whitened, added to the CRC and put
+        // into rxq in one pass.
+        while ( (em2.bytes >= 4) && (radio_rxopen_4() == True) ) {
+            ot_u8   data[4];
+            ot_int  i;
+            radio_getfourbytes(data);
+            em2.PN9_state = sub_PN9_block(data, 4, em2.PN9_state);
+            for (i=0; i<4; i++) {
+                crc_ctx_byte(em2.crc, data[i]);
+                rxq.putcursor[i] = data[i];
+            }
+            rxq.putcursor  += 4;
+            rxq.length     += 4;
+            em2.bytes      -= 4;
+        }
         while ( (em2.bytes > 0) && (radio_rxopen() == True) ) {
-            q_writebyte(&rxq, (radio_getbyte() ^ get_PN9()) );
-            crc_calc_stream();         
+            sub_rxq_putbyte( radio_getbyte() ^ get_PN9() );
             rotate_PN9();
             em2.bytes--;
         }
+        em2.crc_cursor = rxq.putcursor;
     }
 #   endif
 #endif
@@ -180,90 +346,201 @@ fn_codec    em2_decode_data;
 
 static const ot_u8 FECtable[16] = { 0, 3, 1, 2, 3, 0, 2, 1, 3, 0, 2, 1, 0, 3, 1, 2 }; 
     
+    static ot_u8 sub_fec_input() {
+    /// Pulls the next byte to encode: the whitened frame and its CRC, then
+    /// the trellis terminator(s).  em2.bytes counts both, and em2.state is the
+    /// number of terminators, so the frame is done exactly when em2.bytes is 0.
+        ot_u8 input;
+        
+        em2.bytes--;
+        if (em2.bytes < em2.state) {
+            return 0x0B;                    //trellis terminator
+        }
+        input   = sub_txq_readbyte();
+        input  ^= get_PN9();
+        rotate_PN9();
+        return input;
+    }
+    
 #   ifndef EXTF_em2_encode_data_FEC
     void em2_encode_data_FEC() {
-        ot_int      i, j, k;
+        ot_int      i, j;
         ot_u8       scratch;
-        ot_u8       input;
-        ot_u8       data_buffer[RADIO_BUFFER_TXMAX];
+        ot_u8       data_buffer[4];
         Twobytes    FECoutput;
-        Twobytes    FECreg;       //@todo adjust to allow multiframe packets
+        Twobytes    FECreg;
         Fourbytes   INToutput;
         
-        k               = 0;
-        FECreg.ushort   = 0;      //@todo adjust to allow multiframe packets
+        // The trellis state is carried between calls in em2.fec_state, so the
+        // frame can be encoded in as many pieces as the radio buffer needs.
+        FECreg.ushort       = 0;
+        FECreg.ubyte[UPPER] = em2.fec_state;
         
-        // Encode each input byte into two output bytes, and add the trellis
-        // terminator to the end of the message (0x0B).  The number of
-        // pre-encoded bytes plus the trellis terminator must be even, so one 
-        // or two trellis terminators are added (odd or even).  The number of 
-        // post-encoded bytes is always a multiple of 4
-        while ( (em2.state != 0) && (radio_txopen_4() == True) ) {
-            
-            if (em2.bytes == 0) {
-                em2.state--;
-                input = 0x0B;                   //trellis terminator
-            }
-            else {
-                em2.bytes--;
-                crc_calc_stream();
-                input   = q_readbyte(&txq);
-                input  ^= get_PN9();
-                rotate_PN9();
+        // Encode each input byte into two output bytes.  The number of input
+        // bytes (with trellis terminators, see em2_encode_newframe()) is even,
+        // so each pass encodes two of them and interleaves the four bytes.
+        while ( (em2.bytes > 0) && (radio_txopen_4() == True) ) {
+            for (i=0; i<4; i+=2) {
+                FECoutput.ushort     = 0;
+                FECreg.ubyte[UPPER] &= 0x07;
+                FECreg.ubyte[LOWER]  = sub_fec_input();
+                
+                for (j=8; j>0; j--) {
+                    FECoutput.ushort = (FECoutput.ushort << 2) | FECtable[ (FECreg.ushort >> 7) ];
+                    FECreg.ushort    = (FECreg.ushort << 1) & 0x7FF;
+                }
+                data_buffer[i]   = FECoutput.ubyte[UPPER];
+                data_buffer[i+1] = FECoutput.ubyte[LOWER];
             }
-
-            FECoutput.ushort     = 0;
-            FECreg.ubyte[UPPER] &= 0x07;
-            FECreg.ubyte[LOWER]  = input;
             
-            for (j=8; j>0; j--) {
-                FECoutput.ushort = (FECoutput.ushort << 2) | FECtable[ (FECreg.ushort >> 7) ];
-                FECreg.ushort    = (FECreg.ushort << 1) & 0x7FF;
-            }
-            data_buffer[k++] = FECoutput.ubyte[UPPER];
-            data_buffer[k++] = FECoutput.ubyte[LOWER];
-        }
-        
-        // Interleave the buffer after it is encoded
-        // The interleaver operates on four bytes at a time
-        for (i=0; i<k; i+=4) {
+            // Interleave the four bytes
             INToutput.ulong = 0;
-            
             for (j=0; j<16; j++) {
-                scratch         = data_buffer[i + (~j & 0x03)];
-                //INToutput.ulong = (INToutput.ulong << 2) | ((scratch >> (2 * ((j & 0x0C) >> 2))) & 0x03);
+                scratch         = data_buffer[(~j & 0x03)];
                 INToutput.ulong = (INToutput.ulong << 2) | ((scratch >> (((j & 0x0C) >> 2) << 1)) & 0x03);
             }
-            /*
-            INToutput.ubyte[B3]  = (data_buffer[i+3] & 0x03) << 6;
-            INToutput.ubyte[B3] |= (data_buffer[i+2] & 0x03) << 4;
-            INToutput.ubyte[B3] |= (data_buffer[i+1] & 0x03) << 2;
-            INToutput.ubyte[B3] |= (data_buffer[i+0] & 0x03);
-            
-            INToutput.ubyte[B2]  = (data_buffer[i+3] & 0x0C) << 4;
-            INToutput.ubyte[B2] |= (data_buffer[i+2] & 0x0C) << 2;
-            INToutput.ubyte[B2] |= (data_buffer[i+1] & 0x0C);
-            INToutput.ubyte[B2] |= (data_buffer[i+0] & 0x0C) >> 2;
-            
-            INToutput.ubyte[B1]  = (data_buffer[i+3] & 0x30) << 2;
-            INToutput.ubyte[B1] |= (data_buffer[i+2] & 0x30);
-            INToutput.ubyte[B1] |= (data_buffer[i+1] & 0x30) >> 2;
-            INToutput.ubyte[B1] |= (data_buffer[i+0] & 0x30) >> 4;
-            
-            INToutput.ubyte[B0]  = (data_buffer[i+3] & 0xC0);
-            INToutput.ubyte[B0] |= (data_buffer[i+2] & 0xC0) >> 2;
-            INToutput.ubyte[B0] |= (data_buffer[i+1] & 0xC0) >> 4;
-            INToutput.ubyte[B0] |= (data_buffer[i+0] & 0xC0) >> 6;
-            */
             radio_putfourbytes(&INToutput.ubyte[0]);
         }
         
+        em2.fec_state = FECreg.ubyte[UPPER] & 0x07;
+    }
+#   endif
+#endif
+
+
+
+#if ((M2_FEATURE(FECTX) == ENABLED) && (RF_FEATURE(FEC) != ENABLED) && \
+     (M2_FEATURE(FECTXTABLE) == ENABLED))
+/// Byte-wise, table-driven version of the FEC encoder.  The Mode 2 
+/// convolutional code is linear, and so is the interleaver, so the interleaved
+/// output of each input byte can be split into a part that depends only on the
+/// byte (FECbyte_table) and a part that depends only on the trellis state it
+/// starts from (FECstate_table).  Each entry is already interleaved into the
+/// lower nibbles of the 32 bit interleaver word, so a pair of input bytes goes
+/// out as one 32 bit word with four lookups and no bit loops.  The trellis 
+/// state after each byte is just its lowest 3 bits.
+///
+/// Output is bit-identical to em2_encode_data_FEC().  It costs 1 KB of const
+/// data, which is why it is compiled-in only with M2_FEATURE_FECTXTABLE.
+
+static const ot_u32 FECstate_table[8] = {
+        0x00000000, 0x00030301, 0x00000303, 0x00030002, 
+        0x00000003, 0x00030302, 0x00000300, 0x00030001
+};
+
+static const ot_u32 FECbyte_table[256] = {
+        0x00000000, 0x0C000000, 0x040C0000, 0x080C0000, 0x0C040C00, 0x00040C00, 0x08080C00, 0x04080C00,
+        0x0C0C040C, 0x000C040C, 0x0800040C, 0x0400040C, 0x0008080C, 0x0C08080C, 0x0404080C, 0x0804080C,
+        0x030C0C04, 0x0F0C0C04, 0x07000C04, 0x0B000C04, 0x0F080004, 0x03080004, 0x0B040004, 0x07040004,
+        0x0F000808, 0x03000808, 0x0B0C0808, 0x070C0808, 0x03040408, 0x0F040408, 0x07080408, 0x0B080408,
+        0x01030C0C, 0x0D030C0C, 0x050F0C0C, 0x090F0C0C, 0x0D07000C, 0x0107000C, 0x090B000C, 0x050B000C,
+        0x0D0F0800, 0x010F0800, 0x09030800, 0x05030800, 0x010B0400, 0x0D0B0400, 0x05070400, 0x09070400,
+        0x020F0008, 0x0E0F0008, 0x06030008, 0x0A030008, 0x0E0B0C08, 0x020B0C08, 0x0A070C08, 0x06070C08,
+        0x0E030404, 0x02030404, 0x0A0F0404, 0x060F0404, 0x02070804, 0x0E070804, 0x060B0804, 0x0A0B0804,
+        0x0301030C, 0x0F01030C, 0x070D030C, 0x0B0D030C, 0x0F050F0C, 0x03050F0C, 0x0B090F0C, 0x07090F0C,
+        0x0F0D0700, 0x030D0700, 0x0B010700, 0x07010700, 0x03090B00, 0x0F090B00, 0x07050B00, 0x0B050B00,
+        0x000D0F08, 0x0C0D0F08, 0x04010F08, 0x08010F08, 0x0C090308, 0x00090308, 0x08050308, 0x04050308,
+        0x0C010B04, 0x00010B04, 0x080D0B04, 0x040D0B04, 0x00050704, 0x0C050704, 0x04090704, 0x08090704,
+        0x02020F00, 0x0E020F00, 0x060E0F00, 0x0A0E0F00, 0x0E060300, 0x02060300, 0x0A0A0300, 0x060A0300,
+        0x0E0E0B0C, 0x020E0B0C, 0x0A020B0C, 0x06020B0C, 0x020A070C, 0x0E0A070C, 0x0606070C, 0x0A06070C,
+        0x010E0304, 0x0D0E0304, 0x05020304, 0x09020304, 0x0D0A0F04, 0x010A0F04, 0x09060F04, 0x05060F04,
+        0x0D020708, 0x01020708, 0x090E0708, 0x050E0708, 0x01060B08, 0x0D060B08, 0x050A0B08, 0x090A0B08,
+        0x03030103, 0x0F030103, 0x070F0103, 0x0B0F0103, 0x0F070D03, 0x03070D03, 0x0B0B0D03, 0x070B0D03,
+        0x0F0F050F, 0x030F050F, 0x0B03050F, 0x0703050F, 0x030B090F, 0x0F0B090F, 0x0707090F, 0x0B07090F,
+        0x000F0D07, 0x0C0F0D07, 0x04030D07, 0x08030D07, 0x0C0B0107, 0x000B0107, 0x08070107, 0x04070107,
+        0x0C03090B, 0x0003090B, 0x080F090B, 0x040F090B, 0x0007050B, 0x0C07050B, 0x040B050B, 0x080B050B,
+        0x02000D0F, 0x0E000D0F, 0x060C0D0F, 0x0A0C0D0F, 0x0E04010F, 0x0204010F, 0x0A08010F, 0x0608010F,
+        0x0E0C0903, 0x020C0903, 0x0A000903, 0x06000903, 0x02080503, 0x0E080503, 0x06040503, 0x0A040503,
+        0x010C010B, 0x0D0C010B, 0x0500010B, 0x0900010B, 0x0D080D0B, 0x01080D0B, 0x09040D0B, 0x05040D0B,
+        0x0D000507, 0x01000507, 0x090C0507, 0x050C0507, 0x01040907, 0x0D040907, 0x05080907, 0x09080907,
+        0x0002020F, 0x0C02020F, 0x040E020F, 0x080E020F, 0x0C060E0F, 0x00060E0F, 0x080A0E0F, 0x040A0E0F,
+        0x0C0E0603, 0x000E0603, 0x08020603, 0x04020603, 0x000A0A03, 0x0C0A0A03, 0x04060A03, 0x08060A03,
+        0x030E0E0B, 0x0F0E0E0B, 0x07020E0B, 0x0B020E0B, 0x0F0A020B, 0x030A020B, 0x0B06020B, 0x0706020B,
+        0x0F020A07, 0x03020A07, 0x0B0E0A07, 0x070E0A07, 0x03060607, 0x0F060607, 0x070A0607, 0x0B0A0607,
+        0x01010E03, 0x0D010E03, 0x050D0E03, 0x090D0E03, 0x0D050203, 0x01050203, 0x09090203, 0x05090203,
+        0x0D0D0A0F, 0x010D0A0F, 0x09010A0F, 0x05010A0F, 0x0109060F, 0x0D09060F, 0x0505060F, 0x0905060F,
+        0x020D0207, 0x0E0D0207, 0x06010207, 0x0A010207, 0x0E090E07, 0x02090E07, 0x0A050E07, 0x06050E07,
+        0x0E01060B, 0x0201060B, 0x0A0D060B, 0x060D060B, 0x02050A0B, 0x0E050A0B, 0x06090A0B, 0x0A090A0B
+};
+
+    static ot_u32 sub_fectbl_byte(ot_u8 input, ot_u8* fec_state) {
+    /// Interleaved codeword contribution of one input byte, starting from the
+    /// given trellis state, which is then advanced
+        ot_u32 output;
+        output      = FECbyte_table[input] ^ FECstate_table[*fec_state];
+        *fec_state  = input & 0x07;
+        return output;
+    }
+
+    static ot_u32 sub_fectbl_encode() {
+    /// Encodes the next input byte (or trellis terminator) and returns its 
+    /// interleaved codeword contribution
+        return sub_fectbl_byte(sub_fec_input(), &em2.fec_state);
+    }
+
+#   ifndef EXTF_em2_encode_data_FECTBL
+    void em2_encode_data_FECTBL() {
+        Fourbytes   INToutput;
+        ot_u8       fec_state;
+        ot_u8       data[2];
+        
+        // Fused kernel: while two or more frame bytes are left ahead of the 
+        // CRC, each pass reads them straight from txq, adds them to the CRC,
+        // whitens them, and encodes/interleaves them into one 4 byte radio 
+        // group.  This is the only pass over the data.
+        fec_state = em2.fec_state;
+        while ( ((em2.crc_end - txq.getcursor) >= 2) && (radio_txopen_4() == True) ) {
+            data[0]             = txq.getcursor[0];
+            data[1]             = txq.getcursor[1];
+            txq.getcursor      += 2;
+            em2.bytes          -= 2;
+            crc_ctx_byte(em2.crc, data[0]);
+            crc_ctx_byte(em2.crc, data[1]);
+            em2.PN9_state       = sub_PN9_block(data, 2, em2.PN9_state);
+            INToutput.ulong     = sub_fectbl_byte(data[0], &fec_state);
+            INToutput.ulong    |= sub_fectbl_byte(data[1], &fec_state) << 4;
+            radio_putfourbytes(&INToutput.ubyte[0]);
+        }
+        em2.fec_state = fec_state;
+        
+        // The last passes have the CRC and the trellis terminator(s).  They 
+        // keep the input count even (see em2_encode_newframe()), so it is
+        // still two bytes per pass.
+        while ( (em2.bytes > 0) && (radio_txopen_4() == True) ) {
+            INToutput.ulong     = sub_fectbl_encode();
+            INToutput.ulong    |= sub_fectbl_encode() << 4;
+            radio_putfourbytes(&INToutput.ubyte[0]);
+        }
     }
 #   endif
 #endif
 
 
-#if ((M2_FEATURE(FECRX) == ENABLED) && (RF_FEATURE(FEC) != ENABLED))
+#if ((M2_FEATURE(FECRX) == ENABLED) && (RF_FEATURE(FEC) != ENABLED) && FEC_SOFTBITS)
+/// Soft-decision input for the Viterbi decoders.  The radio gives a 0-7 value
+/// for each bit, and the cost of a transition expecting a "0" on that bit is
+/// the value, or 7 minus it for a "1".  When the values are only 0 and 7 this
+/// is 7x the Hamming cost, so the decoded bits are the same as hard decoding.
+
+    static void sub_fec_getsoft(ot_u8* soft) {
+    /// Gets a 4 byte block from the radio and de-interleaves it into 16 symbols
+    /// of soft bits: {hi, lo} for symbol 0, {hi, lo} for symbol 1, etc.
+        ot_u8   raw[32];
+        ot_int  i, j;
+
+        radio_getfourbytes_soft(raw);
+        for (i=0; i<8; i+=2) {
+            for (j=24; j>=0; j-=8) {
+                *soft++ = raw[j+6-i];
+                *soft++ = raw[j+7-i];
+            }
+        }
+    }
+#endif
+
+
+#if ((M2_FEATURE(FECRX) == ENABLED) && (RF_FEATURE(FEC) != ENABLED) && \
+     (M2_FEATURE(FECRXACS) != ENABLED))
     /// @note I am not aware if CC430 has the computational ability to decode FEC in
     ///       real time.  Thus packets might be limited to the size of the radio
     ///       buffer.  I am going to test it soon!
@@ -313,9 +590,6 @@ static const ot_u8 FECtable[16] = { 0, 3, 1, 2, 3, 0, 2, 1, 3, 0, 2, 1, 0, 3, 1,
     
 #   ifndef EXTF_em2_decode_data_FEC
     void em2_decode_data_FEC() {
-
-        // Two sets of buffers (last, current) for each destination state for holding: 
-        ot_u32  path_matrix[2][8];      // Encoder input data (32b window)
     
         // Decoding
         ot_u8   input;
@@ -323,16 +597,27 @@ static const ot_u8 FECtable[16] = { 0, 3, 1, 2, 3, 0, 2, 1, 3, 0, 2, 1, 0, 3, 1,
     
         // Deinterleaving
         ot_u8*  data_in;
+#   if (FEC_SOFTBITS)
+        ot_u8   deint_data[32];     // 16 symbols of {hi, lo} soft bits
+#   else
         ot_u8   deint_data[4];
+#   endif
     
         // Variables used to hold # Viterbi iterations to run, # bytes output,
         // minimum cost for any destination state, bit index of input symbol
         ot_int  i, j;
+#   if (FEC_SOFTBITS == 0)
         ot_int  bit_shift = 6;
+#   endif
         
         while ( (em2.bytes > 0) && (radio_rxopen_4() == True) ) {
             
             /// De-interleave a 4 byte block
+#           if (FEC_SOFTBITS)
+                sub_fec_getsoft(deint_data);
+                em2.bytes  -= 4;
+                data_in     = deint_data;
+#           else
             {
                 ot_u8   int_data[4];
                 radio_getfourbytes(int_data);
@@ -348,22 +633,37 @@ static const ot_u8 FECtable[16] = { 0, 3, 1, 2, 3, 0, 2, 1, 3, 0, 2, 1, 0, 3, 1,
                 }
                 data_in = deint_data;
             }
+#           endif
             
             
             // DECODE the deinterleaved data
             // Process up to 4 bytes of de-interleaved input data, 
             // processing one encoder symbol (2b) at a time
             for (i=16; i>0; i--) {
-                ot_u8   symbol;
+                ot_u8   symcost[4];     // cost of each expected symbol
                 
                 min_cost    = 0xFF;
-                symbol      = ((*data_in) >> bit_shift) & 0x03;
-                bit_shift  -= 2;
+#               if (FEC_SOFTBITS)
+                    symcost[0]  = data_in[0] + data_in[1];
+                    symcost[1]  = data_in[0] + 7 - data_in[1];
+                    symcost[2]  = 14 - symcost[1];
+                    symcost[3]  = 14 - symcost[0];
+                    data_in    += 2;
+#               else
+                {
+                    ot_u8 symbol;
+                    symbol      = ((*data_in) >> bit_shift) & 0x03;
+                    bit_shift  -= 2;
                 
-                if (bit_shift < 0) {       // if bit shifting is all done (byte finished)
-                    bit_shift = 6;              // reset bit_shift
-                    data_in++;                  // Update pointer to the next byte of received data
+                    if (bit_shift < 0) {       // if bit shifting is all done (byte finished)
+                        bit_shift = 6;              // reset bit_shift
+                        data_in++;                  // Update pointer to the next byte of received data
+                    }
+                    for (j=0; j<4; j++) {
+                        symcost[j] = hamming_weight(symbol ^ j);
+                    }
                 }
+#               endif
                 
                 
                 // For each destination state in the trellis, 
@@ -382,24 +682,24 @@ static const ot_u8 FECtable[16] = { 0, 3, 1, 2, 3, 0, 2, 1, 3, 0, 2, 1, 0, 3, 1,
                     //     and expected symbol for transition) 
                     state0  = TrellisSourceState[j][0];
                     cost0   = em2.cost_matrix[em2.last_buffer][state0];
-                    cost0  += hamming_weight(symbol ^ TrellisTransitionOutput[j][0]);
+                    cost0  += symcost[TrellisTransitionOutput[j][0]];
                     
                     state1  = TrellisSourceState[j][1];
                     cost1   = em2.cost_matrix[em2.last_buffer][state1];
-                    cost1  += hamming_weight(symbol ^ TrellisTransitionOutput[j][1]);
+                    cost1  += symcost[TrellisTransitionOutput[j][1]];
                     
                     // Select transition that gives lowest cost in destination state, 
                     // copy that source state's path and add new decoded bit 
                     if (cost0 <= cost1) {
                         em2.cost_matrix[em2.current_buffer][j]  = cost0;
-                        path_matrix[em2.current_buffer][j]      = path_matrix[em2.last_buffer][state0] << 1; 
-                        path_matrix[em2.current_buffer][j]     |= input;
+                        em2.path_matrix[em2.current_buffer][j]      = em2.path_matrix[em2.last_buffer][state0] << 1; 
+                        em2.path_matrix[em2.current_buffer][j]     |= input;
                         min_cost                                = min(min_cost, cost0);
                     }
                     else {
                         em2.cost_matrix[em2.current_buffer][j]  = cost1;
-                        path_matrix[em2.current_buffer][j]      = path_matrix[em2.last_buffer][state1] << 1;
-                        path_matrix[em2.current_buffer][j]     |= input;
+                        em2.path_matrix[em2.current_buffer][j]      = em2.path_matrix[em2.last_buffer][state1] << 1;
+                        em2.path_matrix[em2.current_buffer][j]     |= input;
                         min_cost                                = min(min_cost, cost1);
                     }
                 }
@@ -408,26 +708,25 @@ static const ot_u8 FECtable[16] = { 0, 3, 1, 2, 3, 0, 2, 1, 3, 0, 2, 1, 0, 3, 1,
                 // If trellis history is sufficiently long, 
                 // output a byte of decoded data
                 if (em2.path_bits == 32) {
-                    ot_u8 new_byte;
+                    ot_int new_byte;
                     
                     em2.path_bits  -= 8;
                     //em2.path_bits   = 24;
-                    new_byte        = (ot_u8)(path_matrix[em2.current_buffer][0] >> 24);
+                    new_byte        = (ot_u8)(em2.path_matrix[em2.current_buffer][0] >> 24);
                     new_byte       ^= get_PN9();
                     rotate_PN9();
-                    q_writebyte(&rxq, new_byte);
+                    sub_rxq_putbyte(new_byte);
                     
                     if (em2.state == 0) {
                     	//otapi_led2_off();
                     	new_byte++;            			// added to meet new spec
                         em2.databytes   = new_byte;		// frame length is the first byte... always.
                         em2.bytes       = ((em2.databytes >> 1) + 1) << 2;
-                        em2.bytes      -= 4;
+                        em2.bytes      -= 8;
                         em2.state--;
-                        crc_init_stream(new_byte, rxq.front);
+                        em2.crc_end = em2.crc_cursor + new_byte;
                     }
                     em2.databytes--;
-                    crc_calc_stream();
                 }
                 
                 // After having processed 3-symbol trellis terminator, 
@@ -437,27 +736,38 @@ static const ot_u8 FECtable[16] = { 0, 3, 1, 2, 3, 0, 2, 1, 3, 0, 2, 1, 0, 3, 1,
                         ot_u8 new_byte;
                         
                         em2.databytes--;
-                        new_byte        = (ot_u8)(path_matrix[em2.current_buffer][0] >> em2.path_bits);
                         em2.path_bits  -= 8;
+                        new_byte        = (ot_u8)(em2.path_matrix[em2.current_buffer][0] >> em2.path_bits);
                         new_byte       ^= get_PN9();
                         rotate_PN9();
-                        q_writebyte(&rxq, new_byte);
-                        crc_calc_stream();
+                        sub_rxq_putbyte(new_byte);
                     }
+                    em2.crc_cursor = rxq.putcursor;
                     return;
                 }
                 
+                // Soft costs can overflow a byte within a block, so they are 
+                // normalized after every symbol.
+#               if (FEC_SOFTBITS)
+                for (j=0; j<8; j++) {
+                    em2.cost_matrix[em2.current_buffer][j] -= min_cost;
+                }
+#               endif
+                
                 // Swap current and last buffers for next iteration
                 em2.last_buffer      = (em2.last_buffer+1) & 1;
                 em2.current_buffer   = (em2.current_buffer+1) & 1;
             }
             
             // Normalize costs so that minimum cost becomes 0
+#           if (FEC_SOFTBITS == 0)
             for (j=0; j<8; j++) {
                 em2.cost_matrix[em2.last_buffer][j] -= min_cost;
             }
+#           endif
         }
         
+        em2.crc_cursor = rxq.putcursor;
     }
 #   endif 
 #endif
@@ -465,6 +775,437 @@ static const ot_u8 FECtable[16] = { 0, 3, 1, 2, 3, 0, 2, 1, 3, 0, 2, 1, 0, 3, 1,
 
 
 
+#if ((M2_FEATURE(FECRX) == ENABLED) && (RF_FEATURE(FEC) != ENABLED) && \
+     (M2_FEATURE(FECRXACS) == ENABLED))
+/// Packed add-compare-select (ACS) version of the Viterbi decoder.  The eight
+/// path metrics are kept as bytes in two 32 bit words (states 0-3 and 4-7), so
+/// each received symbol is two packed adds, two packed compare-selects and a
+/// shuffle, instead of eight passes with table lookups and Hamming weights.
+/// Rather than copying eight 32 bit paths per symbol, each ACS stores one 
+/// byte of decision bits, and the decoded bytes are recovered by tracing back
+/// through that history from state 0.  That yields exactly the same bits as
+/// the path registers of em2_decode_data_FEC(), which remains the reference.
+/// The traceback is not done for each byte: bytes are held back until there
+/// are FECACS_BLOCK of them, and then one traceback decodes them all.
+///
+/// Lane i of a packed word is bits 8i to 8i+7, so nothing here is endian 
+/// dependent.  Metrics are normalized once per 4 byte block (or every four
+/// symbols with soft bits), which keeps them well below 128, as the packed 
+/// compare requires.
+
+    /// Branch metrics for each received symbol.  Lane i is the cost of the
+    /// transition from state i to state 2i, which outputs symbol {0,1,3,2}[i].
+    /// All other transitions output that symbol or its complement, and the 
+    /// complement costs 2 minus the value here.
+    static const ot_u32 FECbranch_metric[4] = {
+        0x01020100, 0x02010001, 0x00010201, 0x01000102
+    };
+
+/// Bytes decoded per traceback.  The history has to reach back over all of
+/// them, plus the 24 symbol window and the 8 bits of the oldest one.
+#   define FECACS_BLOCK         4
+
+#   define FECACS_SPREAD(X)     ((((X) & 0xFFFF) | (((X) & 0xFFFF) << 8)) & 0x00FF00FF)
+
+    static ot_u32 sub_fecacs_select(ot_u32 cost0, ot_u32 cost1, ot_u32* decision) {
+    /// Lane-wise minimum of cost0 and cost1 (cost0 on ties, like the reference
+    /// decoder).  Decision gets the top bit of each lane that took cost1.
+        ot_u32 keep;
+        keep        = ((cost1 | 0x80808080) - cost0) & 0x80808080;
+        *decision   = keep ^ 0x80808080;
+        keep      >>= 7;
+        keep        = (keep << 8) - keep;
+        return (cost0 & keep) | (cost1 & ~keep);
+    }
+
+    static void sub_fecacs_init(fecacs_struct* acs) {
+        acs->metric[0]  = FEC_STARTCOST & ~0xFF;    // state 0 is the start
+        acs->metric[1]  = FEC_STARTCOST;
+        acs->cursor     = 0;
+        acs->pending    = 0;
+    }
+
+    static void sub_fecacs_step(fecacs_struct* acs, ot_u32 metric0, ot_u32 metric1) {
+    /// Runs one trellis step, with metric0 as the branch metrics (lanes as in
+    /// FECbranch_metric) and metric1 as their complement.
+        ot_u32 even, odd;
+        ot_u32 dec_even, dec_odd;
+        
+        // Dest 2i and 2i+1 both come from states i and i+4.  "even" gets the
+        // new metrics of states {0,2,4,6}, "odd" the ones of {1,3,5,7}.
+        even    = sub_fecacs_select(acs->metric[0] + metric0, acs->metric[1] + metric1, &dec_even);
+        odd     = sub_fecacs_select(acs->metric[0] + metric1, acs->metric[1] + metric0, &dec_odd);
+        
+        acs->metric[0]  = FECACS_SPREAD(even) | (FECACS_SPREAD(odd) << 8);
+        acs->metric[1]  = FECACS_SPREAD(even >> 16) | (FECACS_SPREAD(odd >> 16) << 8);
+        
+        // Decision byte: bit i is for state 2i, bit i+4 for state 2i+1
+        dec_even    = (dec_even >> 7) | (dec_odd >> 3);
+        dec_even   |= (dec_even >> 7) | (dec_even >> 14) | (dec_even >> 21);
+        acs->cursor = (acs->cursor + 1) & 63;
+        acs->decision[acs->cursor] = (ot_u8)dec_even;
+    }
+
+    static void sub_fecacs_normalize(fecacs_struct* acs) {
+    /// Subtracts the minimum metric from all of them, so it becomes 0
+        ot_u32 min_metric;
+        ot_u32 scratch;
+        min_metric  = sub_fecacs_select(acs->metric[0], acs->metric[1], &scratch);
+        min_metric  = sub_fecacs_select(min_metric, min_metric >> 16, &scratch);
+        min_metric  = sub_fecacs_select(min_metric, min_metric >> 8, &scratch);
+        min_metric &= 0xFF;
+        min_metric |= min_metric << 8;
+        min_metric |= min_metric << 16;
+        acs->metric[0] -= min_metric;
+        acs->metric[1] -= min_metric;
+    }
+
+    static ot_int sub_fecacs_traceback(fecacs_struct* acs, ot_u8* output, ot_int depth) {
+    /// Decodes the pending bytes into output, oldest first, and returns how 
+    /// many there were.  They are consecutive, and the last bit of the newest
+    /// one is "depth" symbols before the newest symbol.  Each byte is read from
+    /// the path of state 0 at 24 symbols after its last bit (or at the newest
+    /// symbol, if that is sooner), which is where em2_decode_data_FEC() reads 
+    /// it.  Those paths merge after a few symbols, so only the newest byte's
+    /// path is traced back in full, and each older one just until it joins it.
+        ot_u8   path[64];       // path[x]: state x symbols before the newest
+        ot_int  bytes   = acs->pending;
+        ot_int  end     = depth + ((bytes-1) << 3) + 5;
+        ot_int  traced  = end + 1;
+        ot_int  i, x;
+        
+        for (i=bytes-1; i>=0; i--, depth+=8) {
+            ot_u8 state = 0;
+            
+            x = (depth > 24) ? (depth - 24) : 0;
+            for (; (x < traced) || (path[x] != state); x++) {
+                ot_u8 decision;
+                path[x] = state;
+                if (x == end) {
+                    break;
+                }
+                decision    = acs->decision[(acs->cursor - x) & 63];
+                decision  >>= (state >> 1) | ((state & 1) << 2);
+                state       = (state >> 1) | ((decision & 1) << 2);
+            }
+            traced = (depth > 24) ? (depth - 24) : 0;
+            
+            // The state is the last three decoded bits, so the oldest three
+            // bits of the byte come from one state.
+            output[i] = path[depth+5] << 5;
+            for (x=0; x<5; x++) {
+                output[i] |= (path[depth+x] & 1) << x;
+            }
+        }
+        
+        acs->pending = 0;
+        return bytes;
+    }
+    
+    static void sub_fecacs_putbytes() {
+    /// Decodes the pending bytes from the em2 decoder history and puts them in
+    /// rxq, still whitened.  sub_fecacs_commit() takes care of the rest.
+        ot_int bytes;
+        bytes           = sub_fecacs_traceback(&em2.acs, rxq.putcursor, em2.path_bits);
+        rxq.putcursor  += bytes;
+        rxq.length     += bytes;
+    }
+    
+    static void sub_fecacs_commit() {
+    /// De-whitens the bytes decoded since the last commit, in place, and adds 
+    /// them to the CRC in the same pass.  This is done once per 4 byte radio
+    /// group (for up to FECACS_BLOCK bytes), so the data is touched once more
+    /// after the traceback, not twice.
+    /// Until the length byte is decoded, em2.crc_end holds the cursor back.
+        ot_u8* end = (rxq.putcursor < em2.crc_end) ? rxq.putcursor : em2.crc_end;
+        
+        for (; em2.crc_cursor < end; em2.crc_cursor++) {
+            ot_u8 data;
+            data    = *em2.crc_cursor ^ get_PN9();
+            rotate_PN9();
+            crc_ctx_byte(em2.crc, data);
+            *em2.crc_cursor = data;
+        }
+    }
+    
+    static ot_bool sub_fecacs_symbol(ot_u32 metric0, ot_u32 metric1) {
+    /// Runs one trellis step of the em2 decoder.  Returns True when the frame
+    /// has been flushed.
+        sub_fecacs_step(&em2.acs, metric0, metric1);
+        em2.path_bits++;
+        
+        // If trellis history is sufficiently long, a byte of decoded data is
+        // due.  It waits for the next traceback, except for the length byte.
+        if (em2.path_bits == 32) {
+            em2.path_bits  -= 8;
+            em2.acs.pending++;
+            
+            if (em2.state == 0) {
+                ot_int new_byte;
+                sub_fecacs_putbytes();
+                new_byte        = rxq.putcursor[-1];
+                new_byte       ^= get_PN9();    // not yet committed
+                new_byte++;                     // added to meet new spec
+                em2.databytes   = new_byte;     // frame length is the first byte... always.
+                em2.bytes       = ((em2.databytes >> 1) + 1) << 2;
+                em2.bytes      -= 8;
+                em2.state--;
+                em2.crc_end = em2.crc_cursor + new_byte;
+            }
+            else if (em2.acs.pending == FECACS_BLOCK) {
+                sub_fecacs_putbytes();
+            }
+            em2.databytes--;
+        }
+        
+        // After having processed 3-symbol trellis terminator, 
+        // flush out remaining data (always end-of-frame)
+        if ( (em2.databytes <= 3)  && (em2.path_bits == ((em2.databytes<<3) + 3)) ) {
+            while (em2.path_bits >= 8) {
+                em2.databytes--;
+                em2.path_bits -= 8;
+                em2.acs.pending++;
+            }
+            sub_fecacs_putbytes();
+            sub_fecacs_commit();
+            return True;
+        }
+        
+        return False;
+    }
+    
+#   ifndef EXTF_em2_decode_data_FECACS
+    void em2_decode_data_FECACS() {
+#   if (FEC_SOFTBITS)
+        ot_int  i;
+        ot_u32  metric0;
+        ot_u32  lanes;
+        
+        while ( (em2.bytes > 0) && (radio_rxopen_4() == True) ) {
+            ot_u8 soft[32];
+            sub_fec_getsoft(soft);
+            em2.bytes -= 4;
+            
+            // Soft branch metrics in FECbranch_metric lane order, for expected
+            // symbols {0,1,3,2}.  The complement lanes are 14 minus these.
+            // Metrics grow up to 14 per symbol, so normalize every 4 symbols.
+            for (i=0; i<32; i+=2) {
+                lanes   = soft[i] + soft[i+1];
+                metric0 = lanes | ((14 - lanes) << 16);
+                lanes   = soft[i] + 7 - soft[i+1];
+                metric0|= (lanes << 8) | ((14 - lanes) << 24);
+                
+                if (sub_fecacs_symbol(metric0, 0x0E0E0E0E - metric0)) {
+                    return;
+                }
+                if ((i & 6) == 6) {
+                    sub_fecacs_normalize(&em2.acs);
+                }
+            }
+            sub_fecacs_commit();
+        }
+#   else
+        ot_int  i, j;
+        ot_u32  metric0;
+        
+        while ( (em2.bytes > 0) && (radio_rxopen_4() == True) ) {
+            ot_u8 int_data[4];
+            radio_getfourbytes(int_data);
+            em2.bytes -= 4;
+            
+            // De-interleaving is just reading the 2 bit symbols by column
+            for (i=0; i<8; i+=2) {
+                for (j=3; j>=0; j--) {
+                    metric0 = FECbranch_metric[(int_data[j] >> i) & 0x03];
+                    if (sub_fecacs_symbol(metric0, 0x02020202 - metric0)) {
+                        return;
+                    }
+                }
+            }
+            sub_fecacs_normalize(&em2.acs);
+            sub_fecacs_commit();
+        }
+#   endif
+    }
+#   endif
+#endif
+
+
+
+
+#if (M2_FEATURE(BLOCKCODEC) == ENABLED)
+/// Whole-buffer codec, for gateways that have complete frames in memory.  It
+/// uses the same kernels as the streaming codec (PN9 keystream/LFSR, FEC byte
+/// tables and the ACS decoder), but all state is local, and there are no 
+/// queue, radio or CRC stream callbacks.
+///
+/// The streaming em2_encode_data_*() and em2_decode_data_*() functions are not
+/// wrappers over this one.  They run from the radio FIFO interrupts, a few 
+/// bytes at a time, while the frame is still on the air: the encoder cannot
+/// wait for the whole frame to be coded into another buffer before the FIFO
+/// is first filled, and the decoder cannot wait for the last byte before it
+/// reads the length.  Wrapping them would also need a second frame buffer, 
+/// which the MCU builds do not have room for.  What they share is the kernels.
+
+#   define BLOCK_FECTX  ( (M2_FEATURE(FECTX) == ENABLED) && (RF_FEATURE(FEC) != ENABLED) && \
+                          (M2_FEATURE(FECTXTABLE) == ENABLED) )
+#   define BLOCK_FECRX  ( (M2_FEATURE(FECRX) == ENABLED) && (RF_FEATURE(FEC) != ENABLED) && \
+                          (M2_FEATURE(FECRXACS) == ENABLED) )
+
+#ifndef EXTF_em2_encode_block
+ot_int em2_encode_block(ot_u8* dst, ot_u8* src, ot_bool fec) {
+    crc_ctx ctx;
+    ot_int  length;
+    ot_u16  crcval;
+    ot_u16  pn9;
+    
+    /// The frame must at least hold its length byte, ahead of the CRC
+    if (src[0] < 2) {
+        return -1;
+    }
+    
+    length  = (ot_int)src[0] - 1;       // frame bytes, without CRC
+    crc_ctx_init(&ctx);
+    crc_ctx_update(&ctx, src, length);
+    crcval  = crc_ctx_final(&ctx);
+    pn9     = PN9_SEED;
+    
+    if (fec == False) {
+        platform_memcpy(dst, src, length);
+        dst[length]     = (ot_u8)(crcval >> 8);
+        dst[length+1]   = (ot_u8)crcval;
+        sub_PN9_block(dst, length+2, pn9);
+        return length + 2;
+    }
+    
+#   if (BLOCK_FECTX)
+    {   
+        ot_int  i, total;
+        ot_u8   input;
+        ot_u8   fec_state   = 0;
+        ot_u32  codeword    = 0;
+        
+        // Frame + CRC is followed by one or two trellis terminators, so the
+        // number of input bytes is even.  Each pair becomes a 4 byte word.
+        total = ((length + 2) | 1) + 1;
+        
+        for (i=0; i<total; i++) {
+            if (i < length)             input = src[i];
+            else if (i == length)       input = (ot_u8)(crcval >> 8);
+            else if (i == (length+1))   input = (ot_u8)crcval;
+            else                        input = 0x0B;       //trellis terminator
+            
+            if (i < (length+2)) {
+                pn9 = sub_PN9_block(&input, 1, pn9);
+            }
+            
+            if ((i & 1) == 0) {
+                codeword    = sub_fectbl_byte(input, &fec_state);
+            }
+            else {
+                codeword   |= sub_fectbl_byte(input, &fec_state) << 4;
+                *dst++      = (ot_u8)(codeword >> 24);
+                *dst++      = (ot_u8)(codeword >> 16);
+                *dst++      = (ot_u8)(codeword >> 8);
+                *dst++      = (ot_u8)codeword;
+            }
+        }
+        return total << 1;
+    }
+#   else
+    return -1;
+#   endif
+}
+#endif
+
+
+#ifndef EXTF_em2_decode_block
+ot_int em2_decode_block(ot_u8* dst, ot_u8* src, ot_int length, ot_bool fec) {
+    ot_int frame;
+
+    if (fec == False) {
+        if (length < 1) {
+            return -2;
+        }
+        dst[0]  = src[0];
+        sub_PN9_block(dst, 1, PN9_SEED);
+        frame   = (ot_int)dst[0] + 1;
+        if (frame > length) {
+            return -2;
+        }
+        platform_memcpy(dst, src, frame);
+        sub_PN9_block(dst, frame, PN9_SEED);
+    }
+    else {
+#   if (BLOCK_FECRX)
+        fecacs_struct   acs;
+        ot_u16          pn9         = PN9_SEED;
+        ot_int          databytes   = 255+1;    // dummy until length is decoded
+        ot_int          path_bits   = 0;
+        ot_int          i, j, bytes;
+        ot_u32          metric0;
+        
+        frame = 0;
+        sub_fecacs_init(&acs);
+        
+        // Same windowing and flush as sub_fecacs_symbol(), so the output is 
+        // identical to the streaming ACS decoder
+        for (; length >= 4; length -= 4, src += 4) {
+            for (i=0; i<8; i+=2) {
+                for (j=3; j>=0; j--) {
+                    metric0 = FECbranch_metric[(src[j] >> i) & 0x03];
+                    sub_fecacs_step(&acs, metric0, 0x02020202 - metric0);
+                    path_bits++;
+                    
+                    if (path_bits == 32) {
+                        path_bits -= 8;
+                        acs.pending++;
+                        if ((frame == 0) || (acs.pending == FECACS_BLOCK)) {
+                            bytes   = sub_fecacs_traceback(&acs, &dst[frame], path_bits);
+                            pn9     = sub_PN9_block(&dst[frame], bytes, pn9);
+                            if (frame == 0) {
+                                databytes = (ot_int)dst[0] + 1;
+                            }
+                            frame  += bytes;
+                        }
+                        databytes--;
+                    }
+                    if ( (databytes <= 3)  && (path_bits == ((databytes<<3) + 3)) ) {
+                        while (path_bits >= 8) {
+                            databytes--;
+                            path_bits -= 8;
+                            acs.pending++;
+                        }
+                        bytes   = sub_fecacs_traceback(&acs, &dst[frame], path_bits);
+                        sub_PN9_block(&dst[frame], bytes, pn9);
+                        frame  += bytes;
+                        goto em2_decode_block_CHECK;
+                    }
+                }
+            }
+            sub_fecacs_normalize(&acs);
+        }
+        return -2;
+#   else
+        return -1;
+#   endif
+    }
+    
+#   if (BLOCK_FECRX)
+    em2_decode_block_CHECK:
+#   endif
+    {   crc_ctx ctx;
+        crc_ctx_init(&ctx);
+        crc_ctx_update(&ctx, dst, frame);
+        return (crc_ctx_final(&ctx) == 0) ? frame : -1;
+    }
+}
+#endif
+
+#endif
+
+
+
 #if ((RF_FEATURE(FEC) == ENABLED) || (RF_FEATURE(PN9) == ENABLED))
 #   define SET_ENCODER_HW()         (em2_encode_data = &em2_encode_data_HW)
 #   define SET_DECODER_HW()         (em2_decode_data = &em2_decode_data_HW)
@@ -484,7 +1225,7 @@ static const ot_u8 FECtable[16] = { 0, 3, 1, 2, 3, 0, 2, 1, 3, 0, 2, 1, 0, 3, 1,
 
 
 #define ENC_HW_ON		(RF_FEATURE(CRC) && RF_FEATURE(PN9))
-#define ENC_HWCRC_ON	(RF_FEATURE(PN9))
+#define ENC_HWCRC_ON	(RF_FEATURE(PN9) && !RF_FEATURE(CRC))
 #define ENC_FEC_ON     	((RF_FEATURE(FEC) != ENABLED) && M2_FEATURE(FECTX))
 #define ENC_PN9_ON		(RF_FEATURE(PN9) != ENABLED)
 #define ENCODERS		(ENC_HW_ON + ENC_HWCRC_ON + ENC_FEC_ON + ENC_PN9_ON)
@@ -516,7 +1257,9 @@ static const fn_codec m2_encoder[ENCODERS] = {
 #if (ENC_PN9_ON)
 	&em2_encode_data_PN9,
 #endif
-#if (ENC_FEC_ON)
+#if (ENC_FEC_ON && (M2_FEATURE(FECTXTABLE) == ENABLED))
+	&em2_encode_data_FECTBL,
+#elif (ENC_FEC_ON)
 	&em2_encode_data_FEC,
 #endif
 };
@@ -531,7 +1274,9 @@ static const fn_codec m2_decoder[DECODERS] = {
 #if (DEC_PN9_ON)
 	&em2_decode_data_PN9,
 #endif
-#if (DEC_FEC_ON)
+#if (DEC_FEC_ON && (M2_FEATURE(FECRXACS) == ENABLED))
+	&em2_decode_data_FECACS,
+#elif (DEC_FEC_ON)
 	&em2_decode_data_FEC,
 #endif
 };
@@ -574,11 +1319,18 @@ void em2_decode_newpacket() {
 
 #ifndef EXTF_em2_encode_newframe
 void em2_encode_newframe() {
-    /// 1. Prepare the CRC, also adding 2 bytes to the frame length
-#   if (RF_FEATURE(CRC) != ENABLED)
-		if (txq.options.ubyte[UPPER] != 0) {
-			crc_init_stream(txq.length, txq.front);
-        	txq.length  += 2;
+    /// 1. Make room for the CRC at the end of the frame, adding 2 bytes to the
+    ///    frame length.  The encoder adds up the CRC as it reads the frame,
+    ///    and puts it there just before it reads it (see sub_txq_readbyte()).
+    ///    A radio with HW CRC still can't do it for frames that get SW FEC, so
+    ///    those always use the SW CRC (as the SW FEC decoders do).  Frames
+    ///    without a SW CRC end at em2.crc_end, so nothing is written there.
+    crc_ctx_init(&em2.crc);
+    em2.crc_end = &txq.front[txq.length];
+#   if ((RF_FEATURE(CRC) != ENABLED) || ENC_FEC_ON)
+		if ((txq.options.ubyte[UPPER] != 0) &&
+            ((RF_FEATURE(CRC) != ENABLED) || (txq.options.ubyte[LOWER] != 0))) {
+        	txq.length += 2;
 		}
 #   endif
 
@@ -590,17 +1342,23 @@ void em2_encode_newframe() {
     ///    (0) HW Encoder: do nothing. 
     ///    (1) SW PN9 Encoder: init PN9 LFSR -- also used in FEC. 
     ///    (2) SW FEC Encoder: init FEC state machine and data. 
+    ///    Each frame has its own CRC, PN9 sequence and trellis termination,
+    ///    so nothing is carried over from the previous frame of the packet.
+    em2.state = 0;
 #   if ((M2_FEATURE(FECTX) == ENABLED) && (RF_FEATURE(FEC) != ENABLED))
         if (txq.options.ubyte[LOWER]) {
-            // state is 1 if odd amount of data, 2 if even
+            // state is 1 if odd amount of data, 2 if even: this is the number
+            // of trellis terminators, which em2.bytes also counts.
         	/// Amount of FEC bytes over the air is always a multiple of 4:
             ///  (   (Bytewise Data)       )
             ///  ( ------------------- + 1 ) * 4
             ///  (          2              )
             ///  = ((em2.bytes >> 1) + 1) << 2;
 
-            em2.state   = ((em2.bytes & 1) == 0);
-            em2.state  += 1;
+            em2.state       = ((em2.bytes & 1) == 0);
+            em2.state      += 1;
+            em2.bytes      += em2.state;
+            em2.fec_state   = 0;
 #			if (RF_FEATURE(PN9) == ENABLED)
             	init_PN9();
 #			endif
@@ -620,22 +1378,32 @@ void em2_decode_newframe() {
     em2.state   = 0;
     em2.bytes   = 8;      // dummy length until actual length is received
     
+    /// The CRC end is set by the decoder when it gets the length byte
+    crc_ctx_init(&em2.crc);
+    em2.crc_cursor  = rxq.putcursor;
+    em2.crc_end     = rxq.putcursor;
+    
     /// Prepare SW FEC Decoders, and if necessary PN9 decoder
 #   if ((M2_FEATURE(FECRX) == ENABLED) && (RF_FEATURE(FEC) != ENABLED))
         if (rxq.options.ubyte[LOWER]) {
+#       if (M2_FEATURE(FECRXACS) == ENABLED)
+            sub_fecacs_init(&em2.acs);
+#       else
 #           ifdef __BIG_ENDIAN__
                 ///@todo: make endian agnostic
 #           else
-                *((ot_u32*)(&em2.cost_matrix[0][0])) = 0x64646400;
-                *((ot_u32*)(&em2.cost_matrix[0][4])) = 0x64646464;
+                *((ot_u32*)(&em2.cost_matrix[0][0])) = FEC_STARTCOST & ~0xFF;
+                *((ot_u32*)(&em2.cost_matrix[0][4])) = FEC_STARTCOST;
                 *((ot_u32*)(&em2.cost_matrix[1][0])) = 0x00000000;
                 *((ot_u32*)(&em2.cost_matrix[1][4])) = 0x00000000;
                 ///@todo Verify: seemed like an error on the last line ([0][4]), which I corrected to [1][4]
 #           endif
 
-            em2.path_bits       = 0;
             em2.last_buffer     = 0;
             em2.current_buffer  = 1;
+#       endif
+            em2.databytes       = 255+1;    // dummy length until actual length is received
+            em2.path_bits       = 0;
 #			if (RF_FEATURE(PN9) == ENABLED)
             	init_PN9();
 #			endif
@@ -651,7 +1419,12 @@ void em2_decode_newframe() {
 
 #ifndef EXTF_em2_remaining_frames
 ot_int em2_remaining_frames() {
-/// Returns 0 if no more frames, or non-zero if more frames
+/// Returns 0 if no more frames, or non-zero if more frames.  During RX, the
+/// frame info byte may not be decoded yet, and until it is, there may still 
+/// be more frames.
+    if ((em2.fr_info == &rxq.front[3]) && (rxq.putcursor <= em2.fr_info)) {
+        return 1;
+    }
     return (ot_int)(*em2.fr_info & 0x10);
 }
 #endif
@@ -663,9 +1436,20 @@ ot_int em2_remaining_bytes() {
 }
 #endif
 
-//ot_bool em2_complete() {
-//    return (ot_bool)((em2.bytes + em2.frames) == 0);
-//}
+#ifndef EXTF_em2_crc_check
+ot_bool em2_crc_check() {
+/// The SW decoders keep the CRC up to date, so this only catches up with
+/// bytes that something else has put into rxq.
+    sub_crc_rx();
+    return (ot_bool)(crc_ctx_final(&em2.crc) == 0);
+}
+#endif
+
+#ifndef EXTF_em2_complete
+ot_bool em2_complete() {
+    return (ot_bool)((em2.bytes == 0) && (em2_remaining_frames() == 0));
+}
+#endif
 
 
 
@@ -42,23 +42,49 @@
 #include "OT_platform.h"
 #include "OT_types.h"
 #include "OT_config.h"
+#include "crc16.h"
+
+#if ((M2_FEATURE(FECRX) == ENABLED) && (M2_FEATURE(FECRXACS) == ENABLED))
+/** Packed add-compare-select Viterbi state, used by the streaming decoder (in
+  * em2) and by em2_decode_block() (on the stack).
+  */
+typedef struct {
+    ot_u32  metric[2];          // packed path metrics: states 0-3, 4-7
+    ot_u8   cursor;             // index of newest decision
+    ot_u8   pending;            // decoded bytes waiting for a traceback
+    ot_u8   decision[64];       // ACS decision bits, one byte per symbol
+} fecacs_struct;
+#endif
 
 typedef struct {
     ot_u8*  fr_info;
     ot_int  bytes;
     ot_int  state;              // could be changed to ot_s8
 
+    crc_ctx crc;                // SW CRC of the frame
+    ot_u8*  crc_cursor;         // RX: next byte to add to the CRC
+    ot_u8*  crc_end;            // RX: end of the frame (and its CRC), TX: the CRC
+
 #   if ( (RF_FEATURE(PN9) != ENABLED) || \
          ((M2_FEATURE(FEC) == ENABLED) && (RF_FEATURE(FEC) != ENABLED)) )
-        Twobytes PN9_lfsr;
+        ot_u16  PN9_state;          // LFSR, or cursor in the PN9 keystream
+#   endif
+
+#   if ((M2_FEATURE(FECTX) == ENABLED) && (RF_FEATURE(FEC) != ENABLED))
+        ot_u8   fec_state;          // trellis state carried between calls
 #   endif
 
 #   if ((M2_FEATURE(FECRX) == ENABLED) && (RF_FEATURE(FEC) != ENABLED))
         ot_int  databytes;
         ot_int  path_bits;
-        ot_u8   last_buffer;
-        ot_u8   current_buffer;
-        ot_u8   cost_matrix[2][8];
+#       if (M2_FEATURE(FECRXACS) == ENABLED)
+            fecacs_struct acs;
+#       else
+            ot_u8   last_buffer;
+            ot_u8   current_buffer;
+            ot_u8   cost_matrix[2][8];
+            ot_u32  path_matrix[2][8];  // decoded paths (32b window)
+#       endif
 #   endif
 
 } em2_struct;
@@ -150,8 +176,11 @@ void em2_decode_newframe();
 
 /** @brief  Returns the number of frames following the current one
   * @param none
-  * @retval ot_int      value from em2.frames
+  * @retval ot_int      0 if this is the last frame, else non-zero
   * @ingroup Encode
+  *
+  * The value comes from the frame continuity bit of the current frame.  When
+  * decoding, non-zero is returned until the frame info byte is received.
   */
 ot_int em2_remaining_frames();
 
@@ -162,15 +191,27 @@ ot_int em2_remaining_frames();
   * @ingroup Encode
   *
   * For encoding, the value returned is the number of unencoded bytes that are
-  * remaining to be encoded.  For decoding, the value is the number of encoded
+  * remaining to be encoded (with FEC, this includes the trellis terminators
+  * that are appended to the frame).  For decoding, the value is the number of encoded
   * bytes that are remaining to be decoded.
   */
 ot_int em2_remaining_bytes();
 
 
+/** @brief  Checks the SW CRC of the frame that was just decoded
+  * @param none
+  * @retval ot_bool     True if the CRC is good
+  * @ingroup Encode
+  *
+  * The decoder adds the frame to its CRC context in chunks, as it decodes it,
+  * so this is quick.  Radios that do CRC in HW only use it for FEC frames.
+  */
+ot_bool em2_crc_check();
+
+
 /** @brief  Returns True when the encoding/decoding is complete
   * @param none
-  * @retval ot_bool     true on (em2.bytes == 0) && (em2.frames == 0)
+  * @retval ot_bool     true when no bytes and no frames remain
   * @ingroup Encode
   */
 ot_bool em2_complete();
@@ -178,6 +219,47 @@ ot_bool em2_complete();
 
 
 
+/** @brief  Encodes a whole Mode 2 frame from a buffer, in one call
+  * @param  dst         (ot_u8*) output for the encoded frame
+  * @param  src         (ot_u8*) frame data, starting with the length byte
+  * @param  fec         (ot_bool) True for FEC, False for PN9 only
+  * @retval ot_int      number of encoded bytes written to dst, or -1
+  * @ingroup Encode
+  *
+  * src[0] is the Mode 2 length byte, and src holds the frame without its CRC:
+  * src[0]-1 bytes.  The CRC is computed and appended, then the frame is 
+  * whitened and (optionally) FEC encoded in a single pass.  The output is the
+  * same byte sequence the streaming encoder sends to the radio, so dst needs
+  * room for src[0]+1 bytes (PN9) or ((src[0]+1)/2 + 1)*4 bytes (FEC).
+  *
+  * Nothing here touches em2, the queues or the radio, so it can be used
+  * while the streaming codec is running.  Returns -1 if src[0] is less than 2
+  * (too short for the length byte and CRC), or if FEC is requested without 
+  * M2_FEATURE(FECTXTABLE).  This function needs M2_FEATURE(BLOCKCODEC).
+  */
+ot_int em2_encode_block(ot_u8* dst, ot_u8* src, ot_bool fec);
+
+
+/** @brief  Decodes a whole Mode 2 frame from a buffer, in one call
+  * @param  dst         (ot_u8*) output for the decoded frame (up to 256 bytes)
+  * @param  src         (ot_u8*) encoded frame, as received from the radio
+  * @param  length      (ot_int) number of bytes available at src
+  * @param  fec         (ot_bool) True for FEC, False for PN9 only
+  * @retval ot_int      decoded frame length (including CRC), or negative
+  * @ingroup Encode
+  *
+  * This is the inverse of em2_encode_block().  The decoded frame in dst keeps
+  * its CRC bytes at the end, like the streaming decoder leaves it in rxq.
+  * Returns -1 if the CRC does not match (or FEC is requested without 
+  * M2_FEATURE(FECRXACS)), or -2 if src ends before the frame does.  Decoding
+  * is hard-decision only.  The output for FEC frames is identical to 
+  * em2_decode_data_FECACS().
+  */
+ot_int em2_decode_block(ot_u8* dst, ot_u8* src, ot_int length, ot_bool fec);
+
+
+
+
 
 
 
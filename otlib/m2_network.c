@@ -39,6 +39,7 @@
 
 #include "auth.h"
 #include "buffers.h"
+#include "crypto_aes128.h"
 #include "queue.h"
 #include "system.h"         //including system.h just for some constants
 #include "veelite.h"
@@ -59,6 +60,191 @@ m2dp_struct m2dp;
 
 
 
+/** Frame Security (DLLS & NLS)
+  * ============================================================================
+  * - Both layers use AES-CCM with a 4 byte MIC, one pass over the frame.
+  * - A secured layer has a 4 byte frame counter in its header, in the clear.
+  *   The 13 byte nonce is the layer (0=DLLS, 1=NLS), the counter, and the 
+  *   source address (zero padded to 8 bytes).  DLLS encrypts the M2NP source
+  *   address, so a DLLS frame carries the 8 byte UID of the sender in the 
+  *   clear, ahead of its counter.  Devices that share a key never share a 
+  *   nonce, as long as each one's counter does not wrap.
+  * - Replayed frames are rejected: for each recent sender (per layer), the
+  *   last accepted counter is kept, and a frame is only accepted if its 
+  *   counter is newer (in serial number order, so a counter can wrap).  The 
+  *   counter is only kept after the MIC has passed, so a forged frame cannot
+  *   move it.  There are OT_PARAM(M2SEC_PEERS) senders, replaced in round-
+  *   robin order.  The newest counter of a replaced sender is kept as the 
+  *   floor of its layer (each layer has its own key), and a sender that is
+  *   not in the table is only accepted if its counter is newer than that, so
+  *   a replaced sender's old frames are not accepted again.
+  * - The TX frame counter is saved in an ISF every OT_PARAM(M2SEC_SAVE_FRAMES)
+  *   frames, ahead of its use, and each boot starts where the saved one is.
+  *   So it never goes back after a reset: peers keep accepting the frames, 
+  *   and a nonce is never used twice.
+  * - The authenticated header starts at the subnet, because the TX EIRP byte 
+  *   is filled-in by the radio after the frame is built.
+  */
+#if (OT_FEATURE(DLL_SECURITY) || OT_FEATURE(NL_SECURITY))
+
+#define M2SEC_MICLEN        4
+#define M2SEC_DLLS          0
+#define M2SEC_NLS           1
+#define M2SEC_DLLS_KEY      ISF_ID(user_authentication_key)
+#define M2SEC_NLS_KEY       ISF_ID(root_authentication_key)
+
+static void sub_sec_nonce(ot_u8* nonce, ot_u8 layer, ot_u8* counter, id_tmpl* source) {
+    ot_int i;
+    
+    nonce[0] = layer;
+    platform_memcpy(&nonce[1], counter, 4);
+    for (i=0; i<8; i++) {
+        nonce[5+i] = ((source != NULL) && (i < source->length)) ? source->value[i] : 0;
+    }
+}
+
+
+static ot_bool sub_sec_newer(ot_u32 counter, ot_u32 last) {
+/// Serial number order, so the counter can wrap
+    return (ot_bool)((ot_s32)(counter - last) > 0);
+}
+
+
+static ot_bool sub_sec_fresh(ot_u8 layer, id_tmpl* source, ot_u32 counter) {
+/// RX: True if the counter is newer than the last one accepted from the same
+/// sender on the same layer, and it is then kept as the last one.  A sender
+/// that is not in the table must be newer than the floor of the layer, and it
+/// takes the next entry.  The counter of the sender it replaces goes into the
+/// floor of that sender's layer.
+    security_peer*  peer;
+    ot_u8           bit;
+    ot_int          i, j;
+    
+    peer = m2np.sec.peer;
+    for (i=0; i<OT_PARAM(M2SEC_PEERS); i++, peer++) {
+        if ((peer->layer != (layer+1)) || (peer->id_length != source->length)) {
+            continue;
+        }
+        for (j=0; (j<source->length) && (peer->id[j] == source->value[j]); j++);
+        if (j == source->length) {
+            if (sub_sec_newer(counter, peer->counter) == False) {
+                return False;
+            }
+            peer->counter = counter;
+            return True;
+        }
+    }
+    
+    if ((m2np.sec.floors & (1 << layer)) && \
+        (sub_sec_newer(counter, m2np.sec.floor[layer]) == False)) {
+        return False;
+    }
+    
+    peer                = &m2np.sec.peer[m2np.sec.next_peer];
+    m2np.sec.next_peer  = (m2np.sec.next_peer + 1) % OT_PARAM(M2SEC_PEERS);
+    if (peer->layer != 0) {
+        i   = peer->layer - 1;
+        bit = (ot_u8)(1 << i);
+        if (((m2np.sec.floors & bit) == 0) || \
+            sub_sec_newer(peer->counter, m2np.sec.floor[i])) {
+            m2np.sec.floor[i]   = peer->counter;
+            m2np.sec.floors    |= bit;
+        }
+    }
+    peer->layer         = layer + 1;
+    peer->id_length     = source->length;
+    peer->counter       = counter;
+    platform_memcpy(peer->id, source->value, source->length);
+    return True;
+}
+
+
+static ot_bool sub_sec_open(ot_u8 key_id, ot_u8 layer, id_tmpl* source) {
+/// RX: the frame counter is at rxq.getcursor.  The rest of the frame is 
+/// decrypted in place, the MIC is stripped, and False is returned if the MIC
+/// does not match or the frame is a replay (see sub_sec_fresh()).
+    aes_ccm_ctx ccm;
+    ot_u8       nonce[AES_CCM_NONCE_SIZE];
+    ot_u8*      mic;
+    ot_u32      counter;
+    ot_int      aad_len;
+    ot_int      msg_len;
+    
+    sub_sec_nonce(nonce, layer, rxq.getcursor, source);
+    counter         = q_readlong(&rxq);
+    aad_len         = (ot_int)(rxq.getcursor - &rxq.front[2]);
+    mic             = &rxq.front[rxq.front[0] + 1 - M2SEC_MICLEN];
+    msg_len         = (ot_int)(mic - rxq.getcursor);
+    if (msg_len < 0) {
+        return False;
+    }
+    
+    AES_ccm_init(&ccm, auth_get_expkey(key_id), nonce, aad_len, msg_len, M2SEC_MICLEN);
+    AES_ccm_aad(&ccm, &rxq.front[2], aad_len);
+    AES_ccm_decrypt(&ccm, rxq.getcursor, msg_len);
+    rxq.front[0] -= M2SEC_MICLEN;
+    
+    if (AES_ccm_verify(&ccm, mic) == False) {
+        return False;
+    }
+    return sub_sec_fresh(layer, source, counter);
+}
+
+
+static void sub_sec_save(ot_u32 saved) {
+/// Saves the counter to the frame counter ISF (high word first)
+    vlFILE* fp;
+    
+    m2np.sec.saved  = saved;
+    fp              = ISF_open_su(ISF_ID(frame_counter));
+    if (fp != NULL) {
+        vl_write(fp, 0, (ot_u16)(saved >> 16));
+        vl_write(fp, 2, (ot_u16)saved);
+        vl_close(fp);
+    }
+}
+
+
+static void sub_sec_putcounter() {
+/// TX: the saved counter stays ahead of the one in use, so it is saved again
+/// before it is reached
+    if (sub_sec_newer(m2np.sec.saved, m2np.sec.counter) == False) {
+        sub_sec_save(m2np.sec.counter + OT_PARAM(M2SEC_SAVE_FRAMES));
+    }
+    q_writelong(&txq, m2np.sec.counter);
+    m2np.sec.counter++;
+}
+
+
+static void sub_sec_close(ot_u8 key_id, ot_u8 layer, ot_u8* counter, id_tmpl* source) {
+/// TX: everything in txq after the frame counter is encrypted in place, and
+/// the MIC is appended.
+    aes_ccm_ctx ccm;
+    ot_u8       nonce[AES_CCM_NONCE_SIZE];
+    ot_u8       mic[M2SEC_MICLEN];
+    ot_u8*      start;
+    ot_int      aad_len;
+    ot_int      msg_len;
+    
+    sub_sec_nonce(nonce, layer, counter, source);
+    start   = counter + 4;
+    aad_len = (ot_int)(start - &txq.front[2]);
+    msg_len = (ot_int)(txq.putcursor - start);
+    
+    AES_ccm_init(&ccm, auth_get_expkey(key_id), nonce, aad_len, msg_len, M2SEC_MICLEN);
+    AES_ccm_aad(&ccm, &txq.front[2], aad_len);
+    AES_ccm_encrypt(&ccm, start, msg_len);
+    AES_ccm_final(&ccm, mic);
+    q_writestring(&txq, mic, M2SEC_MICLEN);
+}
+
+#endif
+
+
+
+
+
+
 /** Low-Level Network Functions
   * ============================================================================
   * - In some OSI models, these might be in the "LLC" layer of the MAC.  They
@@ -72,6 +258,31 @@ void network_init() {
 #   endif
 #   endif
 
+#   if (OT_FEATURE(DLL_SECURITY) || OT_FEATURE(NL_SECURITY))
+    {   vlFILE* fp;
+        ot_int  i;
+        
+        /// The frame counter starts where it was saved, and the saved one
+        /// moves ahead, so each boot starts on frames that were never used.
+        fp = ISF_open_su(ISF_ID(frame_counter));
+        if (fp != NULL) {
+            m2np.sec.counter    = (ot_u32)vl_read(fp, 0) << 16;
+            m2np.sec.counter   |= vl_read(fp, 2);
+            vl_close(fp);
+        }
+        else {
+            platform_rand((ot_u8*)&m2np.sec.counter, 4);
+        }
+        sub_sec_save(m2np.sec.counter + OT_PARAM(M2SEC_SAVE_FRAMES));
+        
+        for (i=0; i<OT_PARAM(M2SEC_PEERS); i++) {
+            m2np.sec.peer[i].layer = 0;
+        }
+        m2np.sec.next_peer  = 0;
+        m2np.sec.floors     = 0;
+    }
+#   endif
+
     // Hop code should be explicitly set when producing an anycast or unicast 
     // transmission.  OTAPI will do this for you.
     //m2np.rt.hop_code  = 0;
@@ -142,10 +353,12 @@ ot_int network_route_ff(m2session* session) {
     /// Data Link Layer Security
     if (m2np.header.fr_info & M2FI_DLLS) {
 #   if (OT_FEATURE(DLL_SECURITY))
-        ///@todo experimental
-        AES_load_static_key(ISF_ID(user_authentication_key), (ot_u32*)txq.front);
-        AES_keyschedule_dec((ot_u32*)txq.front, (ot_u32*)(txq.front+16));
-        AES_decrypt(rxq.getcursor, rxq.getcursor, (ot_u32*)(txq.front+16));
+        id_tmpl source;
+        source.length   = 8;
+        source.value    = q_markbyte(&rxq, 8);
+        if (sub_sec_open(M2SEC_DLLS_KEY, M2SEC_DLLS, &source) == False) {
+            return -1;
+        }
 #   else
         return -1;
 #   endif
@@ -177,9 +390,11 @@ ot_int network_route_ff(m2session* session) {
         m2np.rt.dlog.value  = q_markbyte(&rxq, m2np.rt.dlog.length);
         
         /// Network Layer Security
-        /// @note Network Layer Security not supported at this time
         if (m2np.header.addr_ctl & M2_FLAG_NLS) {
 #       if (OT_FEATURE(NL_SECURITY))
+            if (sub_sec_open(M2SEC_NLS_KEY, M2SEC_NLS, &m2np.rt.dlog) == False) {
+                return -1;
+            }
 #       else
             return -1;
 #       endif
@@ -290,10 +505,8 @@ void m2np_header(m2session* session, ot_u8 addressing, ot_u8 nack) {
     
 #   if (OT_FEATURE(DLL_SECURITY))
     if (m2np.header.fr_info & M2FI_DLLS) {
-        ///@todo experimental
-        AES_load_static_key(ISF_ID(user_authentication_key), (ot_u32*)rxq.front);
-        AES_keyschedule_enc((ot_u32*)rxq.front, (ot_u32*)(rxq.front+16));
-        AES_encrypt(&txq.front[4], &txq.front[4], (ot_u32*)(rxq.front+16));
+        m2np_put_deviceid(False);
+        sub_sec_putcounter();
     }
 #   endif
     
@@ -304,9 +517,10 @@ void m2np_header(m2session* session, ot_u8 addressing, ot_u8 nack) {
         q_writebyte(&txq, m2np.header.addr_ctl);
         m2np_put_deviceid( (ot_bool)(m2np.header.addr_ctl & M2AC_VID) );
         
-        ///@todo Put NLS auth header (NLS not currently supported)
 #       if (OT_FEATURE(NL_SECURITY))
         if (m2np.header.addr_ctl & M2_FLAG_NLS) {
+            m2np.sec.nls_counter = txq.putcursor;
+            sub_sec_putcounter();
         }
 #       endif
         
@@ -346,16 +560,24 @@ void m2np_header(m2session* session, ot_u8 addressing, ot_u8 nack) {
 
 #ifndef EXTF_m2np_footer
 void m2np_footer(m2session* session) {
+    /// NLS is inside DLLS, so it is done first.  The source address is just
+    /// before the NLS frame counter.
 #   if (OT_FEATURE(NL_SECURITY))
-    if (m2np.header.addr_ctl & M2_FLAG_NLS) {
-        ///@todo Put footer: NLS not currently supported
+    if ((m2np.header.fr_info & M2FI_ENADDR) && (m2np.header.addr_ctl & M2_FLAG_NLS)) {
+        id_tmpl source;
+        source.length   = (m2np.header.addr_ctl & M2AC_VID) ? 2 : 8;
+        source.value    = m2np.sec.nls_counter - source.length;
+        sub_sec_close(M2SEC_NLS_KEY, M2SEC_NLS, m2np.sec.nls_counter, &source);
     }
 #   endif
 
 #   if (OT_FEATURE(DLL_SECURITY))
-    ///DLLS footer is just padding, goes in automatically during encryption
-    //if (m2np.header.fr_info & M2_FLAG_DLLS) {
-    //}
+    if (m2np.header.fr_info & M2FI_DLLS) {
+        id_tmpl source;
+        source.length   = 8;
+        source.value    = &txq.front[4];
+        sub_sec_close(M2SEC_DLLS_KEY, M2SEC_DLLS, &txq.front[12], &source);
+    }
 #   endif
     
     /// Add payload (+txq.length), subtract length byte (-1), add CRC (+2)
@@ -112,9 +112,79 @@ typedef struct {
 
 
 
+/** @typedef security_peer
+  * RX replay state of DLLS or NLS for one sender: the last frame counter that
+  * was accepted from it.
+  *
+  * layer       (ot_u8)     0 if empty, else 1 + layer (0=DLLS, 1=NLS)
+  * id_length   (ot_u8)     bytes in id (2 for a VID, 8 for a UID)
+  * id          (ot_u8[8])  address of the sender
+  * counter     (ot_u32)    last frame counter accepted from the sender
+  */
+typedef struct {
+    ot_u8   layer;
+    ot_u8   id_length;
+    ot_u8   id[8];
+    ot_u32  counter;
+} security_peer;
+
+/** @typedef security_struct
+  * State of DLLS and NLS (AES-CCM, see m2np_footer() and network_route_ff()).
+  *
+  * counter     (ot_u32)    Frame counter, written to each secured frame and
+  *                         used in its nonce.  It starts where the last boot
+  *                         left off (see network_init()).
+  * saved       (ot_u32)    Counter value saved in the frame counter ISF: the
+  *                         counter must not reach it without saving again.
+  * nls_counter (ot_u8*)    Where the NLS frame counter is in txq
+  * floor[]     (ot_u32)    Per layer: newest counter of a sender that was
+  *                         replaced in peer[].  Unknown senders must be newer.
+  * floors      (ot_u8)     Per layer bit: 1 if floor[] is set
+  * peer[]      (security_peer) Last counters of recent senders, for replay
+  *                         rejection.  There are OT_PARAM(M2SEC_PEERS).
+  * next_peer   (ot_u8)     Next peer entry to replace
+  */
+
+/// OT_PARAM(M2SEC_PEERS) should be at least the number of devices that send
+/// secured frames to this one, and it must be at least 2.  When there are 
+/// more senders, the ones that do not fit are rejected until their counters 
+/// pass the floor of their layer.
+#ifndef OT_PARAM_M2SEC_PEERS
+#   define OT_PARAM_M2SEC_PEERS         4
+#endif
+#if (OT_PARAM_M2SEC_PEERS < 2)
+#   error "OT_PARAM_M2SEC_PEERS must be at least 2 (check app_config.h)"
+#endif
+
+/// The frame counter is saved in ISF_ID(frame_counter) (4 bytes, as two words
+/// with the high word first), OT_PARAM(M2SEC_SAVE_FRAMES) frames ahead of the
+/// one in use, so it never goes back after a reset.  The file is an ext file
+/// (their IDs go down from 0xFF), so ISF_NUM_EXT_FILES is 2 or more when 
+/// security is on.  If it cannot be opened, the counter starts at random.
+#ifndef ISF_ID_frame_counter
+#   define ISF_ID_frame_counter         0xFE
+#endif
+#ifndef OT_PARAM_M2SEC_SAVE_FRAMES
+#   define OT_PARAM_M2SEC_SAVE_FRAMES   256
+#endif
+
+typedef struct {
+    ot_u32          counter;
+    ot_u32          saved;
+    ot_u8*          nls_counter;
+    ot_u32          floor[2];
+    ot_u8           floors;
+    security_peer   peer[OT_PARAM(M2SEC_PEERS)];
+    ot_u8           next_peer;
+} security_struct;
+
+
 typedef struct {
     routing_tmpl    rt;
     header_struct   header;
+#   if (OT_FEATURE(DLL_SECURITY) || OT_FEATURE(NL_SECURITY))
+        security_struct sec;
+#   endif
 #   if (OT_FEATURE(M2NP_CALLBACKS) == ENABLED) 
         m2npsig_struct  signal;    
 #   endif
@@ -239,6 +309,13 @@ void m2np_header(m2session* session, ot_u8 addressing, ot_u8 nack);
   * you have appended the payload.  It will attach the Mode 2 DLL + M2NP footer
   * which at least contains the CRC.  It will also calculate the frame length
   * and set that field of the frame accordingly.
+  *
+  * Secured frames are encrypted and authenticated here, with AES-CCM and a 4
+  * byte MIC, once the payload is complete.  NLS covers what follows its frame
+  * counter (after the source address), and DLLS then covers what follows its
+  * frame counter (after the Frame Info field and the device UID), NLS MIC 
+  * included.  The header from the subnet up to each counter is authenticated
+  * but not encrypted.
   */
 void m2np_footer(m2session* session);
 
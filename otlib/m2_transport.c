@@ -26,6 +26,7 @@
 #include "m2_transport.h"
 
 #include "OT_config.h"
+#include "OT_platform.h"
 #include "OT_utils.h"
 #include "OTAPI.h"
 
@@ -44,6 +45,10 @@
 #define LOCAL_U16(OFFSET)   *((ot_u16*)&rxq.front[rxq.alloc-32+(OFFSET)])
 #define LOCAL_U32(OFFSET)   *((ot_u32*)&rxq.front[rxq.alloc-32+(OFFSET)])
 
+// Longest query token (per the Mode 2 Spec).  Longer ones fail before any
+// data is loaded into LOCAL_U8.
+#define M2QP_TOKEN_MAX      16
+
 // Argument Shortcut for some callbacks
 #if (OT_FEATURE(M2QP_CALLBACKS) == ENABLED)
 #   define M2QP_CALLBACK(VAL)   M2QP_CB_##VAL
@@ -99,34 +104,213 @@
 m2qp_struct m2qp;
 
 
+/** String Search State
+  * A search query that can only pass on an exact match of the token is run as
+  * a bit-parallel Shift-And search.  Bit i of "match" is set when the last 
+  * i+1 bytes of data match the first i+1 bytes of the token.  A data byte 
+  * matches a masked token byte when both of its nibbles do, so the bytes of
+  * the token that each data byte matches are found with two 16 entry tables
+  * (one per nibble) instead of a loop over the token.  Tokens are at most 16
+  * bytes (per the Mode 2 Spec), so each table entry is 16 bits.
+  *
+  * A search with a partial-match threshold is run as a correlation, on a ring
+  * buffer of the last token-length bytes.  "head" is the oldest byte.
+  */
+typedef struct {
+    ot_u16  match;
+    ot_u16  final;
+    ot_u16  hinib[16];
+    ot_u16  lonib[16];
+    ot_int  head;
+} m2qp_search_struct;
+
+m2qp_search_struct m2qp_search;
+
+
+/** Compiled Arithmetic Comparison
+  * sub_load_query() compiles an arithmetic (ALU) query once, for the global
+  * and for the local query alike.  The masked value is packed big-endian into
+  * 32 bit words, so comparing words as numbers gives the same order as 
+  * comparing the bytes one at a time.  Bytes after the end of the token get a
+  * mask of 0 in the last word.  "masked" is False when the query has no mask
+  * (or an all-ones mask), and then only the last word is masked.  The return
+  * value for each outcome is resolved from the comparison code in advance.
+  */
+typedef struct {
+    ot_u8   words;
+    ot_bool masked;
+    ot_s8   on_less;        // return value when value < data
+    ot_s8   on_greater;     // return value when value > data
+    ot_s8   on_equal;       // return value when value == data
+    ot_u32  value[4];
+    ot_u32  mask[4];
+} m2qp_cmp_struct;
+
+m2qp_cmp_struct m2qp_cmp;
+
+/// Mask for queries that don't supply one (as big as the LOCAL_U8 buffer)
+const ot_u8 m2qp_nomask[32] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF
+};
+
+
+/** Query Result Cache
+  * With M2_FEATURE(QCACHE), the results of m2qp_isf_comp() are cached, so a
+  * gateway that polls again and again with the same query gets its answer
+  * without the file data being read and compared again.  An entry is found
+  * by the file or series ID, the offset, the whole query template, and the ID
+  * of the requesting user (who may not be able to read the same files as 
+  * another user).  They are all kept in the entry and compared byte for byte,
+  * so a different query can never get a cached score.  Templates longer than
+  * M2QP_QCACHE_TMPLBYTES and user IDs longer than 8 bytes are not cached.  An
+  * entry is good while the write generations of the files it was made from 
+  * are the same (see vl_genmask()).  Entries are replaced in round-robin order.
+  */
+#if (M2_FEATURE(QCACHE) == ENABLED)
+typedef struct {
+    ot_u8   flags;          // 0 = empty, else 1 + is_series
+    ot_u8   comp_id;
+    ot_int  comp_offset;
+    ot_u8   code;           // query template: code, length, value, mask
+    ot_u8   length;
+    ot_u8   value[M2QP_QCACHE_TMPLBYTES];
+    ot_u8   mask[M2QP_QCACHE_TMPLBYTES];
+    ot_u8   user_length;    // ID of the requesting user (0 is root)
+    ot_u8   user[8];
+    ot_u16  gensum;         // vl_gensum(genmask) when the score was made
+    ot_u8   genmask;        // Veelite generation slots of the files read
+    ot_int  score;
+} m2qp_qentry;
+
+typedef struct {
+    ot_u8       genmask;    // Generation slots read by the running comparison
+    ot_u8       next;       // Next entry to replace
+    m2qp_qentry entry[M2QP_QCACHE_ENTRIES];
+} m2qp_qcache_struct;
+
+m2qp_qcache_struct m2qp_qcache;
+
+#   define QCACHE_READ(MASK)    (m2qp_qcache.genmask |= (MASK))
+#else
+#   define QCACHE_READ(MASK)    
+#endif
+
+
 
 /** @brief Subroutine for use with m2qp_load_isf(): Loads arithmetic comparison.
   * @param cursor       (ot_int*)   Used by m2qp_load_isf()
-  * @param data_byte    (ot_u8)     One byte of data to load (and process)
+  * @param data         (ot_u8*)    Span of data to load (and process)
+  * @param length       (ot_int)    Bytes in the span
   * @retval ot_int      always returns 0
   */
-ot_int sub_load_comparison(ot_int* cursor, ot_u8 data_byte);
+ot_int sub_load_comparison(ot_int* cursor, ot_u8* data, ot_int length);
 
 /** @brief Subroutine for use with m2qp_load_isf(): Performs string token search.
   * @param cursor       (ot_int*)   Used by m2qp_load_isf()
-  * @param data_byte    (ot_u8)     One byte of data to load (and process)
-  * @retval ot_int      returns 1 if there is a match, 0 if no match
+  * @param data         (ot_u8*)    Span of data to load (and process)
+  * @param length       (ot_int)    Bytes in the span
+  * @retval ot_int      number of matches in the span
+  */
+ot_int sub_load_charcorrelation(ot_int* cursor, ot_u8* data, ot_int length);
+
+/** @brief Subroutine for use with m2qp_load_isf(): Exact string token search.
+  * @param cursor       (ot_int*)   Used by m2qp_load_isf()
+  * @param data         (ot_u8*)    Span of data to load (and process)
+  * @param length       (ot_int)    Bytes in the span
+  * @retval ot_int      number of places in the span where the token ends
+  */
+ot_int sub_load_search(ot_int* cursor, ot_u8* data, ot_int length);
+
+/** @brief Prepares a string token search for the query in m2qp.qtmpl
+  * @param none
+  * @retval ot_bool     True: use sub_load_search(), 
+  *                     False: use sub_load_charcorrelation()
+  */
+ot_bool sub_search_start();
+
+/** @brief Runs the query in m2qp.qtmpl on the file/series in m2qp.qdata
+  * @param is_series    (ot_u8)     0/1 depending if ISF or ISF Series
+  * @param user_id      (id_tmpl*)  user ID of the requester
+  * @retval ot_int      same as m2qp_isf_comp()
+  */
+ot_int sub_isf_comp(ot_u8 is_series, id_tmpl* user_id);
+
+/** @brief Compiles the arithmetic query in m2qp.qtmpl into m2qp_cmp
+  * @param none
+  * @retval none
+  */
+void sub_compile_alu();
+
+/** @brief Runs the compiled arithmetic query on the data in LOCAL_U8
+  * @param none
+  * @retval ot_int      0 if the comparison passes, -1 if not
+  */
+ot_int sub_run_alu();
+
+#if (M2_FEATURE(QCACHE) == ENABLED)
+/** @brief Checks if a query cache entry is for the query in m2qp
+  * @param entry        (m2qp_qentry*) the entry
+  * @param flags        (ot_u8)     1 + is_series
+  * @param user_id      (id_tmpl*)  user ID of the requester (NULL is root)
+  * @retval ot_bool     True if the file, offset, template and user all match
   */
-ot_int sub_load_charcorrelation(ot_int* cursor, ot_u8 data_byte);
+ot_bool sub_qcache_match(m2qp_qentry* entry, ot_u8 flags, id_tmpl* user_id);
+
+/** @brief Keeps the query in m2qp in a query cache entry, for sub_qcache_match()
+  * @param entry        (m2qp_qentry*) the entry
+  * @param flags        (ot_u8)     1 + is_series
+  * @param user_id      (id_tmpl*)  user ID of the requester (NULL is root)
+  * @retval none
+  */
+void sub_qcache_store(m2qp_qentry* entry, ot_u8 flags, id_tmpl* user_id);
+#endif
+
+/** @brief Compares two device IDs as unsigned byte strings (like memcmp)
+  * @param id_a         (ot_u8*)    first ID
+  * @param id_b         (ot_u8*)    second ID
+  * @param length       (ot_int)    bytes in each ID
+  * @retval ot_int      negative if id_a < id_b, 0 if equal, positive if >
+  */
+ot_int sub_bytecmp(ot_u8* id_a, ot_u8* id_b, ot_int length);
+
+/** @brief Sorts an ACK list in place, in the order of sub_bytecmp()
+  * @param list         (ot_u8*)    first ID of the list
+  * @param count        (ot_int)    number of IDs in the list
+  * @param length       (ot_int)    bytes in each ID (2 or 8)
+  * @retval none
+  */
+void sub_sort_acklist(ot_u8* list, ot_int count, ot_int length);
+
+/** @brief Looks for this device's ID in an ACK list
+  * @param list         (ot_u8*)    first ID of the list
+  * @param count        (ot_int)    number of IDs in the list
+  * @param length       (ot_int)    bytes in each ID (2 or 8)
+  * @retval ot_bool     True if this device is in the list
+  *
+  * If the request has M2CE_ACKSORT, the list is in ascending order and it is
+  * binary searched against the device ID (loaded once from the ISF).  Else,
+  * it is scanned with m2np_idcmp(), which is how legacy gateways expect it.
+  */
+ot_bool sub_ack_search(ot_u8* list, ot_int count, ot_int length);
 
 /** @brief Subroutine for use with m2qp_load_isf(): Loads return template
   * @param cursor       (ot_int*)   Used by m2qp_load_isf()
-  * @param data_byte    (ot_u8)     One byte of data to load (and process)
+  * @param data         (ot_u8*)    Span of data to load (and process)
+  * @param length       (ot_int)    Bytes in the span
   * @retval ot_int      always returns 0
   */
-ot_int sub_load_return(ot_int* cursor, ot_u8 data_byte);
+ot_int sub_load_return(ot_int* cursor, ot_u8* data, ot_int length);
 
 /** @brief Subroutine for use with m2qp_load_isf(): Does nothing
   * @param cursor       (ot_int*)   Used by m2qp_load_isf()
-  * @param data_byte    (ot_u8)     One byte of data to load (and process)
+  * @param data         (ot_u8*)    Span of data to load (and process)
+  * @param length       (ot_int)    Bytes in the span
   * @retval ot_int      always returns 0
   */
-ot_int sub_load_nonnull(ot_int* cursor, ot_u8 data_byte);
+ot_int sub_load_nonnull(ot_int* cursor, ot_u8* data, ot_int length);
 
 
 
@@ -218,13 +402,25 @@ ot_u16 otapi_put_query_tmpl(ot_u8* status, query_tmpl* query) {
 #ifndef EXTF_otapi_put_ack_tmpl
 ot_u16 otapi_put_ack_tmpl(ot_u8* status, ack_tmpl* ack) {
     ot_int  i;
+    ot_u8*  count_ptr;
     ot_u8*  data_ptr    = ack->list;
     ot_u8*  limit       = txq.back - ack->length;
     
+    /// The ACK list is the number of IDs, then the IDs.  The number is 
+    /// written after the IDs that fit in the queue have been written.
+    count_ptr = txq.putcursor;
+    q_writebyte(&txq, 0);
+    
     for (i=0; (i < ack->count) && (txq.putcursor < limit); \
-            i+=ack->length, data_ptr+=ack->length ) {
+            i++, data_ptr+=ack->length ) {
         q_writestring(&txq, data_ptr, ack->length);
     }
+    *count_ptr = (ot_u8)i;
+    
+    /// With M2CE_ACKSORT, the receivers binary search the list
+    if (m2qp.cmd.ext & M2CE_ACKSORT) {
+        sub_sort_acklist(count_ptr+1, i, ack->length);
+    }
     
     *status = (ot_u8)i;
     return txq.length;
@@ -639,18 +835,138 @@ void sub_load_query(void) {
         m2qp.qtmpl.mask = q_markbyte(&rxq, m2qp.qtmpl.length);
     }
     else {
-        /// Option 2: we need to stash a mask of FF's at the back of the queue!
-        /// This is not a problem, because the RX queue will never get this far
-        /// during comp & call commands.
-        m2qp.qtmpl.mask = &rxq.front[rxq.alloc-16];
-
-        *((ot_u32*)&rxq.front[rxq.alloc-16]) = 0xFFFFFFFF;
-        *((ot_u32*)&rxq.front[rxq.alloc-12]) = 0xFFFFFFFF;
-        *((ot_u32*)&rxq.front[rxq.alloc-8])  = 0xFFFFFFFF;
-        *((ot_u32*)&rxq.front[rxq.alloc-4])  = 0xFFFFFFFF;
+        /// Option 2: use the constant mask of FF's
+        m2qp.qtmpl.mask = (ot_u8*)m2qp_nomask;
     }
 
     m2qp.qtmpl.value  = q_markbyte(&rxq, m2qp.qtmpl.length);
+    
+    if (m2qp.qtmpl.code & M2QC_ALU) {
+        sub_compile_alu();
+    }
+}
+
+
+
+void sub_compile_alu() {
+/// The return values are the same as the byte-wise comparison gives: the even
+/// codes (!=, <, >) fail on equality and the odd ones (==, <=, >=) pass.
+    static const ot_s8 results[6][2] = {
+        {  0,  0 },             // !=
+        { -1, -1 },             // ==
+        {  0, -1 },             // <, <=
+        {  0, -1 },
+        { -1,  0 },             // >, >=
+        { -1,  0 }
+    };
+    ot_int  i;
+    ot_int  length;
+    ot_u8   code;
+    ot_u8   mask;
+    
+    code                = m2qp.qtmpl.code & 0x1F;
+    length              = m2qp.qtmpl.length;
+    m2qp_cmp.on_equal   = (ot_s8)(code & 1) - 1;
+    m2qp_cmp.on_less    = (code < 6) ? results[code][0] : -1;
+    m2qp_cmp.on_greater = (code < 6) ? results[code][1] : -1;
+    m2qp_cmp.masked     = False;
+    
+    /// Comparison is limited per the Mode 2 Spec: fail longer ones
+    if (length > M2QP_TOKEN_MAX) {
+        m2qp_cmp.words      = 0;
+        m2qp_cmp.on_equal   = -1;
+        return;
+    }
+    
+    m2qp_cmp.words = (length+3) >> 2;
+    for (i=0; i<16; i++) {
+        mask = (i < length) ? m2qp.qtmpl.mask[i] : 0;
+        if ((i & 3) == 0) {
+            m2qp_cmp.value[i>>2]    = 0;
+            m2qp_cmp.mask[i>>2]     = 0;
+        }
+        m2qp_cmp.value[i>>2]  <<= 8;
+        m2qp_cmp.mask[i>>2]   <<= 8;
+        if (i < length) {
+            m2qp_cmp.value[i>>2]   |= (m2qp.qtmpl.value[i] & mask);
+            m2qp_cmp.mask[i>>2]    |= mask;
+            m2qp_cmp.masked        |= (mask != 0xFF);
+        }
+    }
+}
+
+
+
+ot_int sub_bytecmp(ot_u8* id_a, ot_u8* id_b, ot_int length) {
+    ot_int diff = 0;
+    
+    for (; (length > 0) && (diff == 0); length--) {
+        diff = (ot_int)*id_a++ - (ot_int)*id_b++;
+    }
+    return diff;
+}
+
+
+
+void sub_sort_acklist(ot_u8* list, ot_int count, ot_int length) {
+/// Insertion sort: ACK lists are short, and the gateway is not in a hurry
+    ot_u8   id[8];
+    ot_u8*  dest;
+    ot_int  i;
+    
+    if ((length <= 0) || (length > 8)) {
+        return;
+    }
+    for (i=1; i<count; i++) {
+        dest = &list[i*length];
+        platform_memcpy(id, dest, length);
+        
+        while ((dest > list) && (sub_bytecmp(dest-length, id, length) > 0)) {
+            platform_memcpy(dest, dest-length, length);
+            dest -= length;
+        }
+        platform_memcpy(dest, id, length);
+    }
+}
+
+
+
+ot_bool sub_ack_search(ot_u8* list, ot_int count, ot_int length) {
+    /// Sorted list: binary search against the device ID
+    if ((m2qp.cmd.ext & M2CE_ACKSORT) && (length > 0) && (length <= 8)) {
+        ot_u8   self[8];
+        ot_int  lo, hi, mid, diff;
+        vlFILE* fp;
+        
+        //file 0=network_settings, 1=device_features (as m2np_idcmp)
+        fp = ISF_open_su( (length == 8) );
+        if (fp == NULL) {
+            return False;
+        }
+        vl_read_block(fp, 0, length, self);
+        vl_close(fp);
+        
+        lo = 0;
+        hi = count - 1;
+        while (lo <= hi) {
+            mid     = (lo + hi) >> 1;
+            diff    = sub_bytecmp(&list[mid*length], self, length);
+            if (diff == 0) {
+                return True;
+            }
+            if (diff < 0)   lo = mid + 1;
+            else            hi = mid - 1;
+        }
+        return False;
+    }
+    
+    /// Legacy list: linear scan
+    for (; count > 0; count--, list+=length) {
+        if (m2np_idcmp(length, list)) {
+            return True;
+        }
+    }
+    return False;
 }
 
 
@@ -664,17 +980,10 @@ ot_int sub_process_query(m2session* session) {
     /// Look through the ack list for this host's device ID.  If it is
     /// there, then the query can exit.
     if (cmd_type > 0x40) {
-        ot_bool id_test;
-        ot_int  number_of_acks  = (ot_int)q_readbyte(&rxq);
-        
-        do {
-            number_of_acks--;
-            id_test = m2np_idcmp(m2np.rt.dlog.length, \
-                                    q_markbyte(&rxq, m2np.rt.dlog.length));   
-        }
-        while ((number_of_acks >= 0) && (id_test == False));
+        ot_int  ack_count   = (ot_int)q_readbyte(&rxq);
+        ot_u8*  ack_list    = q_markbyte(&rxq, ack_count*m2np.rt.dlog.length);
         
-        if (number_of_acks != 0) {
+        if (sub_ack_search(ack_list, ack_count, m2np.rt.dlog.length)) {
             goto sub_process_query_exit;
         }
     }
@@ -730,26 +1039,95 @@ ot_int sub_process_query(m2session* session) {
   */
 #ifndef EXTF_m2qp_isf_comp
 ot_int m2qp_isf_comp(ot_u8 is_series, id_tmpl* user_id) {
+    // Assure length is 0 when Non-Null search is used
+    m2qp.qtmpl.length   = (m2qp.qtmpl.code) ? m2qp.qtmpl.length : 0;
+
+    // Get ISF information from queue
+    m2qp.qdata.comp_id  = q_readbyte(&rxq);
+    
+    if (is_series)  m2qp.qdata.comp_offset  = q_readshort(&rxq);
+    else            m2qp.qdata.comp_offset  = q_readbyte(&rxq);
+
+#   if (M2_FEATURE(QCACHE) == ENABLED)
+    {   // Use the cached score, if the query has been run on the same data
+        // before.  Else, run it and cache the score.
+        m2qp_qentry*    entry;
+        ot_u8           flags;
+        ot_int          i;
+        
+        if ((m2qp.qtmpl.length > M2QP_QCACHE_TMPLBYTES) || \
+            ((user_id != NULL) && (user_id->length > 8))) {
+            return sub_isf_comp(is_series, user_id);
+        }
+        
+        flags   = 1 + (is_series != 0);
+        entry   = m2qp_qcache.entry;
+        
+        for (i=0; i<M2QP_QCACHE_ENTRIES; i++, entry++) {
+            if (sub_qcache_match(entry, flags, user_id)) {
+                if (entry->gensum == vl_gensum(entry->genmask)) {
+                    return entry->score;
+                }
+                break;      // stale: the data has been written
+            }
+        }
+        if (i == M2QP_QCACHE_ENTRIES) {
+            entry = &m2qp_qcache.entry[m2qp_qcache.next];
+            if (++m2qp_qcache.next == M2QP_QCACHE_ENTRIES) {
+                m2qp_qcache.next = 0;
+            }
+        }
+        
+        m2qp_qcache.genmask = 0;
+        entry->score        = sub_isf_comp(is_series, user_id);
+        sub_qcache_store(entry, flags, user_id);
+        entry->genmask      = m2qp_qcache.genmask;
+        entry->gensum       = vl_gensum(m2qp_qcache.genmask);
+        
+        // A file that could not be opened has no generation slot in the 
+        // mask, so creating it (or changing its mod) would not make the entry
+        // stale.  Don't keep those results.
+        if (entry->score == -32768) {
+            entry->flags    = 0;
+        }
+        return entry->score;
+    }
+#   else
+        return sub_isf_comp(is_series, user_id);
+#   endif
+}
+#endif
+
+
+
+ot_int sub_isf_comp(ot_u8 is_series, id_tmpl* user_id) {
     ot_int  score;
 
+    // Tokens longer than the Mode 2 limit fail here, before any method loads
+    // data for them into LOCAL_U8 (32 bytes, at the end of rxq) or reads 
+    // m2qp_nomask past its end.
+    if (m2qp.qtmpl.length > M2QP_TOKEN_MAX) {
+        return -1;
+    }
+
     // Load the data from the file/series into the query buffer
+    // Searches go from the offset to the end of the file/series, comparisons
+    // load the token length.
     {
-        ot_int  (*load_function)(ot_int*, ot_u8);
-        
-        // Assure length is 0 when Non-Null search is used, and set the load
-        // function accordingly, depending on the query method
-        m2qp.qtmpl.length   = (m2qp.qtmpl.code) ? m2qp.qtmpl.length : 0;
-        load_function       = ((m2qp.qtmpl.code & M2QC_COR_SEARCH) != 0) ? \
-                               &sub_load_charcorrelation : &sub_load_comparison;
-    
-        // Get ISF information from queue, and load data 
-        m2qp.qdata.comp_id  = q_readbyte(&rxq);
+        ot_int  (*load_function)(ot_int*, ot_u8*, ot_int);
+        ot_int  window;
         
-        if (is_series)  m2qp.qdata.comp_offset  = q_readshort(&rxq);
-        else            m2qp.qdata.comp_offset  = q_readbyte(&rxq);
+        // Set the load function, depending on the query method
+        load_function       = &sub_load_comparison;
+        window              = m2qp.qtmpl.length;
+        if (m2qp.qtmpl.code & M2QC_COR_SEARCH) {
+            load_function   = sub_search_start() ? \
+                                &sub_load_search : &sub_load_charcorrelation;
+            window          = 0x7FFF;
+        }
             
         score   = m2qp_load_isf(is_series, m2qp.qdata.comp_id, m2qp.qdata.comp_offset, 
-                                m2qp.qtmpl.length, load_function, user_id );
+                                window, load_function, user_id );
     }
     
     // Manage search errors
@@ -772,35 +1150,39 @@ ot_int m2qp_isf_comp(ot_u8 is_series, id_tmpl* user_id) {
     // - m2qp_load_isf will return a score based on the load_function you give
     //   it.  In either of these cases, anything less than 0 means fail.
     else if (m2qp.qtmpl.code & M2QC_ALU) {
-        ot_int i, j, k;
+        return sub_run_alu();
+    }
+    
+    return score;
+}
 
-        // Run Arithmetic comparison
-        for (i=0; i<m2qp.qtmpl.length; i++) {
-            j = m2qp.qtmpl.mask[i] & m2qp.qtmpl.value[i];
-            k = m2qp.qtmpl.mask[i] & LOCAL_U8(i);
-            
-            if (j != k) {
-                switch (m2qp.qtmpl.code & 0x1F) {
-                    case 0: return 0;                   // !=
-                    case 1: return -1;                  // ==
-                    case 2: 
-                    case 3: return (j < k) - 1;         // <, <=
-                    case 4: 
-                    case 5: return (j > k) - 1;         // >, >=
-                    default: return -1;
-                }
-            }
+
+
+
+ot_int sub_run_alu() {
+/// The first word that differs decides the comparison
+    ot_u8*  data;
+    ot_u32  dword;
+    ot_int  i;
+    ot_int  last;
+    
+    data    = &LOCAL_U8(0);
+    last    = m2qp_cmp.words - 1;
+    
+    for (i=0; i<=last; i++, data+=4) {
+        dword   = ((ot_u32)data[0] << 24) | ((ot_u32)data[1] << 16) | \
+                  ((ot_u32)data[2] << 8)  |  (ot_u32)data[3];
+        if (m2qp_cmp.masked || (i == last)) {
+            dword &= m2qp_cmp.mask[i];
+        }
+        if (dword != m2qp_cmp.value[i]) {
+            return (m2qp_cmp.value[i] < dword) ? \
+                    m2qp_cmp.on_less : m2qp_cmp.on_greater;
         }
-        
-        /// If you are here, j == k
-        /// the even numbered codes are non-equalities (!=, <, >)
-        /// so subtract 1 from the equality output to make -1/0
-        return ((ot_int)m2qp.qtmpl.code & 1) - 1;
     }
     
-    return score;
+    return m2qp_cmp.on_equal;
 }
-#endif
 
 
 
@@ -902,81 +1284,32 @@ ot_int m2qp_load_isf(   ot_u8       is_series,
                         ot_u8       isf_id, 
                         ot_int      offset, 
                         ot_int      window_bytes,
-                        ot_int      (*load_function)(ot_int*, ot_u8),
+                        ot_int      (*load_function)(ot_int*, ot_u8*, ot_int),
                         id_tmpl*    user_id ) {            
-    Twobytes scratch;
-    ot_int  i;
-    vlFILE* fp_f;
-    vlFILE* fp_s    = NULL;
-    ot_int  n_files = 1;
+    vlSERIES series;
+    ot_int  length;
     ot_int  j       = 0;
     ot_int  output  = 0;
 
-    /// 1. Open the ISF Series, if enabled
+    /// 1. Open the ISF Series, or the ISF as a series of size 1.
     ///    Do not respond if the series is not accessible (return negative)
-    if (is_series) {
-        fp_s = ISFS_open( isf_id, VL_ACCESS_R, user_id );
-        if (fp_s == NULL) {
-            return -32768;
-        }
-        n_files = fp_s->length;
-    }
-    
-    /// 2. If no Series, spoof a single file access as a series of size 1
-    else {
-        scratch.ubyte[0]    = isf_id;
-        n_files             = 1;
-    }
-
-    /// 3.  Step through each file of the ISF Series, and process it.
-    ///     This double-loop will extract and process a window of "window_bytes"
-    ///     bytes that is stored contiguously across any number of files in a
-    ///     series.  Processing stops when the series ends or the window is full.
-    for (i=0; i<n_files; i++) {
-        ot_u8 align = (i & 1);
-    
-        // Read the next file ID if we are processing a ISFS (series)
-        if ((is_series) && (align == 0)) {
-            scratch.ushort = vl_read(fp_s, i);
-        }
-        
-        // Open the file: 
-        // - If not accessible as a series, skip it
-        // - If not accessible as an file, bail
-        fp_f = ISF_open( scratch.ubyte[align], VL_ACCESS_R, user_id );
-        if (fp_f == NULL) {
-            vl_close(fp_s);
-            return -32768;
-        }
-                
-        // Subtract the file length from the offset value.  When the offset 
-        // goes negative, the current file is the one we should start on.
-        offset -= fp_f->length;
-        if (offset < 0) {
-            offset += fp_f->length;
-            
-            // Load the window and process it, using the open file
-            while ( (j < window_bytes) && (offset < fp_f->length) ) {
-                Twobytes ldata;
-                
-                align = offset & 1;
-                if (align == 0) {
-                    ldata.ushort = vl_read(fp_f, offset);
-                }
-                output += load_function( &j, ldata.ubyte[align] );
-                offset++;
-            }
-            // reset offset to 0, so the process resumes at next series file
-            offset = 0;
+    /// 2. Process the window of "window_bytes" bytes that is stored 
+    ///    contiguously across any number of files in the series, one span at
+    ///    a time.  Processing stops when the series ends or the window is
+    ///    done, or (returning negative) if a file is not accessible.
+    length = vl_series_open(&series, is_series, isf_id, offset, window_bytes, user_id);
+    if (length == 0) {
+        while ((length = vl_series_next(&series)) > 0) {
+            output += load_function(&j, series.span, length);
         }
-        vl_close(fp_f);
     }
-    vl_close(fp_s);
+    vl_series_close(&series);
+    QCACHE_READ(series.genmask);
     
     ///@todo Here is where an algorithm could go to manage the way "scoring" is
     /// done for search-based load operations.
     
-    return output;
+    return (length < 0) ? -32768 : output;
 }
 #endif
 
@@ -1003,73 +1336,195 @@ ot_int m2qp_load_isf(   ot_u8       is_series,
   * - Used as the load_function() argument to sub_load_isf()
   */
 
-ot_int sub_load_charcorrelation(ot_int* cursor, ot_u8 data_byte) {
+#if (M2_FEATURE(QCACHE) == ENABLED)
+ot_bool sub_qcache_match(m2qp_qentry* entry, ot_u8 flags, id_tmpl* user_id) {
+    ot_u8 user_length = (user_id != NULL) ? user_id->length : 0;
+    
+    if ((entry->flags != flags) || \
+        (entry->comp_id != m2qp.qdata.comp_id) || \
+        (entry->comp_offset != m2qp.qdata.comp_offset) || \
+        (entry->code != m2qp.qtmpl.code) || \
+        (entry->length != m2qp.qtmpl.length) || \
+        (entry->user_length != user_length)) {
+        return False;
+    }
+    if (sub_bytecmp(entry->value, m2qp.qtmpl.value, m2qp.qtmpl.length) != 0) {
+        return False;
+    }
+    if ((m2qp.qtmpl.code & M2QC_MASKED) && \
+        (sub_bytecmp(entry->mask, m2qp.qtmpl.mask, m2qp.qtmpl.length) != 0)) {
+        return False;
+    }
+    if ((user_length != 0) && \
+        (sub_bytecmp(entry->user, user_id->value, user_length) != 0)) {
+        return False;
+    }
+    return True;
+}
+
+
+void sub_qcache_store(m2qp_qentry* entry, ot_u8 flags, id_tmpl* user_id) {
+    entry->flags        = flags;
+    entry->comp_id      = m2qp.qdata.comp_id;
+    entry->comp_offset  = m2qp.qdata.comp_offset;
+    entry->code         = m2qp.qtmpl.code;
+    entry->length       = m2qp.qtmpl.length;
+    entry->user_length  = (user_id != NULL) ? user_id->length : 0;
+    
+    platform_memcpy(entry->value, m2qp.qtmpl.value, m2qp.qtmpl.length);
+    if (m2qp.qtmpl.code & M2QC_MASKED) {
+        platform_memcpy(entry->mask, m2qp.qtmpl.mask, m2qp.qtmpl.length);
+    }
+    if (entry->user_length != 0) {
+        platform_memcpy(entry->user, user_id->value, entry->user_length);
+    }
+}
+#endif
+
+
+ot_bool sub_search_start() {
+/// The correlation score of a window is (matches - mismatches), so it can only
+/// be the token length (all match) or two or more less than it.  If the
+/// threshold is the token length or one less, only an exact match passes, and
+/// the Shift-And search gives the same result.
+    ot_int  i;
+    ot_int  n;
+    ot_int  length;
+    ot_int  threshold;
+    ot_u16  bit;
+    
+    length      = m2qp.qtmpl.length;
+    threshold   = (ot_int)(m2qp.qtmpl.code & M2QC_COR_THRMASK);
+    m2qp_search.head = 0;
+    
+    if ((length == 0) || (length > M2QP_TOKEN_MAX) || \
+        (threshold < (length-1)) || (threshold > length)) {
+        return False;
+    }
+    
+    /// Build the nibble tables.  A nibble of a token byte that is fully
+    /// masked-in matches only one value, otherwise all 16 values are tested.
+    for (n=0; n<16; n++) {
+        m2qp_search.hinib[n] = 0;
+        m2qp_search.lonib[n] = 0;
+    }
+    for (i=0, bit=1; i<length; i++, bit<<=1) {
+        ot_u8 mask  = m2qp.qtmpl.mask[i];
+        ot_u8 value = m2qp.qtmpl.value[i] & mask;
+        
+        if (mask == 0xFF) {
+            m2qp_search.hinib[value >> 4]  |= bit;
+            m2qp_search.lonib[value & 15]  |= bit;
+        }
+        else {
+            for (n=0; n<16; n++) {
+                if ((n & (mask >> 4)) == (value >> 4))  m2qp_search.hinib[n] |= bit;
+                if ((n & (mask & 15)) == (value & 15))  m2qp_search.lonib[n] |= bit;
+            }
+        }
+    }
+    
+    m2qp_search.match   = 0;
+    m2qp_search.final   = (ot_u16)1 << (length-1);
+    return True;
+}
+
+
+ot_int sub_load_search(ot_int* cursor, ot_u8* data, ot_int length) {
+/// Shift-And: each token prefix that matched up to the last byte, plus the
+/// empty prefix, is extended by this byte if the next token byte matches it.
+/// The cursor is not used: the search goes through all of the data.
+    ot_u16  match   = m2qp_search.match;
+    ot_int  hits    = 0;
+    
+    for (; length > 0; length--, data++) {
+        match   = ((match << 1) | 1) & m2qp_search.hinib[*data >> 4] & \
+                                       m2qp_search.lonib[*data & 15];
+        hits   += ((match & m2qp_search.final) != 0);
+    }
+    
+    m2qp_search.match = match;
+    return hits;
+}
+
+
+ot_int sub_load_charcorrelation(ot_int* cursor, ot_u8* data, ot_int length) {
 /// This is a pure character-by-character correlation, which is not as efficient
-/// for comparing strings as more specialized methods (The Boyer-Moore-Horspool
-/// method might fit nicely here) but it gives the ability to report partial
-/// matches, which the BM or BMH methods do not.
+/// for comparing strings as sub_load_search(), but it gives the ability to 
+/// report partial matches, which Shift-And and the BM or BMH methods do not.
 ///
 /// A correlation is a mathematic process for comparing two sequences, so check
 /// Wikipedia for more info (http://en.wikipedia.org/wiki/Cross-correlation).
 /// This function performs a correlation of a byte-wise token onto a byte-wise 
 /// datastream.  The token is usually supplied in the command data (stored in 
-/// shared memory), and the datastream is fed into this function byte-by-byte
-/// (usually referenced from file data).
+/// shared memory), and the datastream is fed into this function a span at a
+/// time (usually referenced from file data).
 
     ot_int i;
+    ot_int j;
     ot_int c;
+    ot_int hits = 0;
     
-    /// The datastream is buffered in an unused part of the data-queue.
-    /// The LOCAL_U8() macro behaves similar to array nomenclature
-    LOCAL_U8(*cursor) = data_byte;
-    
-    /// If the datastream is *not* fully pre-buffered, return to the caller.
-    /// If the datastream is fully pre-buffered, then proceed to correlation.
-    if ( *cursor < (m2qp.qtmpl.length-1) ) {
-        (*cursor)++;
-        return 0;
-    }
-    
-    /// Equality Correlation with data shifting of the buffer after each
-    /// comparison operation.  The value c is the comparison score.  It is a
-    /// bipolar accumulator, so a non-equality alters the score by -1 and an
-    /// equality by +1.  It is implemented as c += (0 or 2) - 1
-    else {
-        for (i=0, c=0; i<m2qp.qtmpl.length; i++) {
-            c += ( (LOCAL_U8(i) & m2qp.qtmpl.mask[i]) == \
+    for (; length > 0; length--, data++) {
+        /// The datastream is buffered in an unused part of the data-queue, as
+        /// a ring buffer.  The newest byte replaces the oldest one.
+        LOCAL_U8(m2qp_search.head) = *data;
+        if (++m2qp_search.head == m2qp.qtmpl.length) {
+            m2qp_search.head = 0;
+        }
+        
+        /// If the datastream is *not* fully pre-buffered, go to the next byte.
+        /// If the datastream is fully pre-buffered, then do the correlation.
+        if ( *cursor < (m2qp.qtmpl.length-1) ) {
+            (*cursor)++;
+            continue;
+        }
+        
+        /// Equality Correlation, from the oldest byte in the ring buffer.  The
+        /// value c is the comparison score.  It is a bipolar accumulator, so a 
+        /// non-equality alters the score by -1 and an equality by +1.  It is 
+        /// implemented as c += (0 or 2) - 1
+        for (i=0, j=m2qp_search.head, c=0; i<m2qp.qtmpl.length; i++) {
+            c += ( (LOCAL_U8(j) & m2qp.qtmpl.mask[i]) == \
                    (m2qp.qtmpl.value[i] & m2qp.qtmpl.mask[i]) ) << 1;
             c -= 1;
             
-            LOCAL_U8(i-1) = LOCAL_U8(i);
+            if (++j == m2qp.qtmpl.length) {
+                j = 0;
+            }
         }
+        
+        /// One parameter of the correlation query is a correlation threshold.
+        /// It occupies the lower 5 bits of the query code.  It is an integer 
+        /// value.  Scores higher than the threshold are passing scores.  The 
+        /// query score indicates the number of hits the query made on the 
+        /// file data.
+        hits += (c >= (ot_int)(m2qp.qtmpl.code & 0x1F));
     }
     
-    /// One parameter of the correlation query is a correlation threshold.  It
-    /// occupies the lower 5 bits of the query code.  It is an integer value.
-    /// Scores higher than the threshold are passing scores.  The query score
-    /// indicates the number of hits the query made on the file data.
-    return (c >= (ot_int)(m2qp.qtmpl.code & 0x1F));  
+    return hits;
 }
 
 
-ot_int sub_load_comparison(ot_int* cursor, ot_u8 data_byte) {
+ot_int sub_load_comparison(ot_int* cursor, ot_u8* data, ot_int length) {
 /// Just loads comparison data, from the file system, into the local buffer.  
-/// Comparison is limited to16 bytes per the Mode 2 Spec.
-    LOCAL_U8(*cursor) = data_byte;
-    (*cursor)++;
+/// The window is the token length, which sub_isf_comp() limits to 
+/// M2QP_TOKEN_MAX bytes.
+    platform_memcpy(&LOCAL_U8(*cursor), data, length);
+    *cursor += length;
     return 0;  
 }
 
 
-ot_int sub_load_return(ot_int* cursor, ot_u8 data_byte) {
+ot_int sub_load_return(ot_int* cursor, ot_u8* data, ot_int length) {
 /// Just loads file data into the TX queue.
-    q_writebyte(&txq, data_byte);
-    (*cursor)++;
+    q_writestring(&txq, data, length);
+    *cursor += length;
     return 0;  
 }
 
 
-ot_int sub_load_nonnull(ot_int* cursor, ot_u8 data_byte) {
+ot_int sub_load_nonnull(ot_int* cursor, ot_u8* data, ot_int length) {
 /// Does Nothing: the nonnull comparison only requires that the specified file
 /// exists on the device.
     return 0;
@@ -80,6 +80,7 @@
 
 
 // M2QP Command Extension Options
+#define M2CE_ACKSORT            (0x01 << 0)     // ACK list IDs are in ascending order
 #define M2CE_NORESP             (0x01 << 1)
 #define M2CE_NOCSMA             (0x01 << 2)
 #define M2CE_CA_MASK            (0x07 << 3)
@@ -103,6 +104,16 @@
 #define M2QC_COR_THRMASK        (0x1F)
 #define M2QC_ERROR              (0xFF)
 
+// Entries in the query result cache, with M2_FEATURE(QCACHE)
+#ifndef M2QP_QCACHE_ENTRIES
+#   define M2QP_QCACHE_ENTRIES  4
+#endif
+
+// Longest query template (value bytes) that the query result cache keeps
+#ifndef M2QP_QCACHE_TMPLBYTES
+#   define M2QP_QCACHE_TMPLBYTES    16
+#endif
+
 
 
 
@@ -390,7 +401,7 @@ ot_int m2qp_isf_call( ot_u8 is_series, Queue* input_q, id_tmpl* user_id );
   * @param  isf_id        (ot_int)  ID for the UDB Element or List
   * @param  offset        (ot_int)  Byte offset into the UDB dataset
   * @param  window_bytes  (ot_int)  Number of bytes, following offset, to process
-  * @param  load_function (ot_int (*)(ot_int*, ot_u8) ) Processing function
+  * @param  load_function (ot_int (*)(ot_int*, ot_u8*, ot_int) ) Processing function
   * @retval ot_int        A running sum of returns from the processing function
   * @ingroup Protocol_Special
   * @sa pm2_isf_comp()
@@ -398,22 +409,25 @@ ot_int m2qp_isf_call( ot_u8 is_series, Queue* input_q, id_tmpl* user_id );
   * @sa sub_load_charcorrelation()
   * @sa sub_load_comparison()
   * @sa sub_load_return()
+  * @sa vl_series_next()
   *
   * In a nutshell, this function can do basically anything to any kind of UDB
   * dataset.  It is typically only used by pm2_isf_comp() or pm2_isf_call().
   * It is one of the cooler and more useful functions in OpenTag.
   * 
   * The processing function is a subroutine that takes in an index pointer (this
-  * is issued by pm2_load_isf() ) and a byte of data.  It can do whatever it
-  * wants to the data, and return whatever it wants.  There are currently three
-  * subroutines used as processing functions for different tasks: 
-  * sub_load_charcorrelation(), sub_load_comparison(), sub_load_return()
+  * is issued by pm2_load_isf() ) and a span of data (a pointer and a number of
+  * bytes, from vl_series_next()).  It is called once per span, not per byte.
+  * It can do whatever it wants to the data, and return whatever it wants.  
+  * There are currently three subroutines used as processing functions for 
+  * different tasks: sub_load_charcorrelation(), sub_load_comparison(), 
+  * sub_load_return()
   */
 ot_int m2qp_load_isf(   ot_u8       is_series, 
                         ot_u8       isf_id, 
                         ot_int      offset, 
                         ot_int      window_bytes,
-                        ot_int      (*load_function)(ot_int*, ot_u8),
+                        ot_int      (*load_function)(ot_int*, ot_u8*, ot_int),
                         id_tmpl*    user_id );
 
 
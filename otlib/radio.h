@@ -383,6 +383,19 @@ ot_u8 radio_getbyte();
   */
 void radio_getfourbytes(ot_u8* data);
 
+/** @brief Gets 4 bytes from the RX radio buffer, as 32 soft-decision bits
+  * @param soft         (ot_u8*) pointer to an array of 32 bytes to load into
+  * @retval none
+  * @ingroup Radio
+  *
+  * Only required when the radio has RF_FEATURE(SOFTBITS).  It takes the same
+  * 4 bytes as radio_getfourbytes(), but each bit comes out as a 3 bit
+  * confidence value: 0 is a certain "0", 7 is a certain "1", and 3 or 4 are
+  * barely better than a guess.  The bits are in the order they would appear
+  * in radio_getfourbytes(): bit b of byte k is soft[(k*8) + (7-b)].
+  */
+void radio_getfourbytes_soft(ot_u8* soft);
+
 
 
 /** @brief Checks the RX buffer to see if there is at least 1 more byte in it
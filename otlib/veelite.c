@@ -78,6 +78,110 @@ typedef vlFILE* (*sub_new)(ot_u8, ot_u8, ot_u8);
 
 
 
+/** File ID Index
+  * With OT_FEATURE(VLINDEX), each header block that is searched by ID gets a
+  * RAM table, indexed by file ID, which holds the header's number in the block
+  * (or VLINDEX_NONE).  It is built by vl_init() and kept current by vl_new()
+  * and vl_delete(), so file open does not search the header array.  Stock
+  * ISFs are found by ID without a search, so only the user ISF IDs are in the
+  * ISF table.  The tables are sized for all IDs: 256 bytes each for the GFB 
+  * and ISFS blocks, and about the same for user ISFs (if there are any).
+  */
+#if (OT_FEATURE(VLINDEX) == ENABLED)
+#   define VLINDEX_NONE         0xFF
+#   define VLINDEX_ISF_FIRST    (ISF_NUM_M1_FILES+ISF_NUM_M2_FILES)
+#   define VLINDEX_ISF_IDS      (256-ISF_NUM_EXT_FILES-VLINDEX_ISF_FIRST)
+#   if (GFB_NUM_USER_FILES > 0)
+        ot_u8 vlindex_gfb[256];
+#   endif
+        ot_u8 vlindex_isfs[256];
+#   if ((OT_FEATURE(VLNEW) == ENABLED) && (ISF_NUM_USER_FILES > 0))
+        ot_u8 vlindex_isf[VLINDEX_ISF_IDS];
+#   endif
+#endif
+
+
+
+/** Heap Allocation
+  * Each heap that can get new files (with OT_FEATURE(VLNEW)) has a list of
+  * its free extents in RAM.  The list is built by vl_init() from the headers,
+  * and then kept current by vl_new() and vl_delete(), so allocation does not
+  * read any headers.  The list is sorted by size (and then by address), so 
+  * the best fit is found with a binary search.  Free extents are merged with
+  * their neighbors when a file is deleted, so there are never more than one
+  * more free extents than there are headers.
+  *
+  * With OT_FEATURE(VLDEFRAG), vl_defrag_step() moves one file at a time down
+  * into the free extent just below it (or out of the way, when it does not
+  * fit there), which the kernel does in idle time.  This moves all free space
+  * to the end of the heap.
+  */
+#define VLHEAP_GFB  ((OT_FEATURE(VLNEW) == ENABLED) && \
+                     (GFB_HEAP_BYTES > 0) && (GFB_NUM_USER_FILES > 0))
+#define VLHEAP_ISFS ((OT_FEATURE(VLNEW) == ENABLED) && (ISFS_NUM_USER_CODES > 0))
+#define VLHEAP_ISF  ((OT_FEATURE(VLNEW) == ENABLED) && (ISF_NUM_USER_FILES > 0))
+
+typedef struct {
+    vaddr       base;
+    ot_u16      size;
+} vl_extent;
+
+typedef struct {
+    vl_extent*  extent;         // free extents, sorted by size and then base
+    ot_int      count;          // number of free extents in the list
+    vaddr       start;          // first byte of the heap for new files
+    vaddr       end;            // end of the heap (one past last byte)
+    vaddr       header;         // first header of files in this heap
+    ot_int      num_headers;    // number of headers of files in this heap
+} vl_heap;
+
+#if (VLHEAP_GFB)
+    vl_extent   vlfree_gfb[GFB_NUM_USER_FILES+1];
+    vl_heap     vlheap_gfb = { vlfree_gfb, 0, GFB_HEAP_USER_START, GFB_HEAP_END,
+                                GFB_Header_START_USER, GFB_NUM_USER_FILES };
+#endif
+#if (VLHEAP_ISFS)
+    vl_extent   vlfree_isfs[ISFS_NUM_USER_CODES+1];
+    vl_heap     vlheap_isfs = { vlfree_isfs, 0, ISFS_HEAP_USER_START, ISFS_HEAP_END,
+                                ISFS_Header_START_USER, ISFS_NUM_USER_CODES };
+#endif
+#if (VLHEAP_ISF)
+    vl_extent   vlfree_isf[ISF_NUM_USER_FILES+1];
+    vl_heap     vlheap_isf = { vlfree_isf, 0, ISF_HEAP_USER_START, ISF_HEAP_END,
+                                ISF_Header_START_USER, ISF_NUM_USER_FILES };
+#endif
+
+
+
+/** Write Generations
+  * Each file has one of VL_GEN_SLOTS generation counters, picked by the
+  * position of its header.  vl_write() and vl_write_block() (and so vl_store())
+  * increment the counter of the file.  vl_new(), vl_delete() and vl_chmod()
+  * increment all of them, because they change which files can be opened, and
+  * by whom.  A module that keeps results made from file data saves the sum of
+  * the counters of the files it read (see vl_gensum()), and the result is good
+  * for as long as the sum does not change.
+  */
+#define VLGEN_SLOT(HEADER)  (((HEADER) / sizeof(vl_header)) & (VL_GEN_SLOTS-1))
+ot_u16 vlgen[VL_GEN_SLOTS];
+
+
+
+/** ISF Mirror Dirty Map
+  * Each word of the ISF mirror (in VSRAM) has a bit, which vl_write() and
+  * vl_write_block() set, and vl_close() sets for the length word if it has
+  * changed.  Syncing writes only the words that have their bit set back to
+  * VWORM, and clears the bits.  ISF_loadmirror() clears them all.  The count
+  * of set bits is kept, so the pending work is known without a scan.
+  */
+#if (ISF_MIRROR_HEAP_BYTES > 0)
+#   define MIRROR_WORD(VADDR)   (((VADDR) - ISF_MIRROR_BASE) >> 1)
+    ot_u8   vlmirror_dirty[(ISF_MIRROR_HEAP_BYTES+15)/16];
+    ot_uint vlmirror_pending;
+#endif
+
+
+
 
 
 
@@ -96,6 +200,39 @@ vaddr sub_isfs_search(ot_u8 id);
 vaddr sub_isf_search(ot_u8 id);
 
 
+/** @brief Builds the File ID Index of one header block
+  * @param table : (ot_u8*) index table
+  * @param id_first : (ot_u8) file ID of table[0]
+  * @param num_ids : (ot_int) number of entries in the table
+  * @param header : (vaddr) first header in the block
+  * @param num_headers : (ot_int) number of headers in the block
+  * @retval none
+  *
+  * Where two headers have the same ID, the first one is indexed, which is the 
+  * one that sub_header_search() would find.
+  */
+void sub_index_build(ot_u8* table, ot_u8 id_first, ot_int num_ids, vaddr header, ot_int num_headers);
+
+
+/** @brief Finds a header using the File ID Index
+  * @param table : (ot_u8*) index table
+  * @param index : (ot_u8) file ID, less the ID of table[0]
+  * @param header : (vaddr) first header in the block
+  * @retval vaddr : the header, or NULL_vaddr if the ID is not in the block
+  */
+vaddr sub_index_lookup(ot_u8* table, ot_u8 index, vaddr header);
+
+
+/** @brief Updates the File ID Index after a file is created or deleted
+  * @param block : (ot_u8) block number (0 = GFB, 1 = ISFS, 2 = ISF)
+  * @param id : (ot_u8) file ID
+  * @param header : (vaddr) header of the new file, or NULL_vaddr on delete
+  *                 (then the block is searched for another file with the ID)
+  * @retval none
+  */
+void sub_index_put(ot_u8 block, ot_u8 id, vaddr header);
+
+
 /** @brief Performs mirroring operations on ISF files
   * @param direction : (ot_u8) vworm->vsram or vsram->vworm
   * @retval ot_u8  
@@ -105,11 +242,44 @@ vaddr sub_isf_search(ot_u8 id);
 ot_u8 sub_isf_mirror(ot_u8 direction);
 
 
+/** @brief Tells the auth module when an ISF is written
+  * @param fp : (vlFILE*) file pointer being written
+  * @retval none
+  *
+  * An ISF may hold a key that the auth module has expanded and cached, so the
+  * cached copy has to go when the file changes.
+  */
+void sub_isf_written(vlFILE* fp);
+
+
+
+/** @brief Increments all of the write generations
+  * @param none
+  * @retval none
+  */
+void sub_gen_all();
+
+
+/** @brief Sets the dirty bits of the mirror words in a span of VSRAM
+  * @param addr : (vaddr) first VSRAM byte of the span
+  * @param span : (ot_uint) number of bytes in the span
+  * @retval none
+  */
+void sub_mirror_mark(vaddr addr, ot_uint span);
+
+
+/** @brief Writes dirty mirror words of the stock ISFs back to VWORM
+  * @param limit : (ot_uint) maximum number of words to write
+  * @retval ot_uint : number of dirty words still pending
+  */
+ot_uint sub_mirror_sync(ot_uint limit);
+
+
 
 
 vlFILE* sub_new_fp();
-vlFILE* sub_new_file(vl_header* new_header, vaddr heap_base, vaddr heap_end, vaddr header_base, ot_int header_window );
-void sub_delete_file(vaddr del_header);
+vlFILE* sub_new_file(vl_header* new_header, vl_heap* heap);
+void sub_delete_file(vaddr del_header, vl_heap* heap);
 void sub_copy_header( vaddr header, ot_u16* output_header );
 
 /** @brief Writes a block of data to the header
@@ -143,35 +313,67 @@ vaddr sub_find_empty_header(vaddr header, ot_int num_headers);
 
 
 
-/** @brief Searches for an amount of the empty space in the heap
-  * @param base : (vaddr*) physical pointer to the @c base @c file of a header
-  * @param alloc: (size_t) number of bytes needed to allocate
-  * @param header_size : (size_t) number of bytes in the given header type
-  * @param num_headers : (ot_int) number of headers to search through
+/** @brief Returns the heap of a block, if files can be created in it
+  * @param block : (ot_u8) block number (0 = GFB, 1 = ISFS, 2 = ISF)
+  * @retval vl_heap* : the heap, or NULL
+  */
+vl_heap* sub_get_heap(ot_u8 block);
+
+
+
+/** @brief Builds the free extent list of a heap from its headers
+  * @param heap : (vl_heap*) heap to build
+  * @retval none
+  *
+  * This runs once, from vl_init().  It reads each header once, and the sorting
+  * is done in the extent list itself, so it needs no other RAM.
+  */
+void sub_heap_build(vl_heap* heap);
+
+
+
+/** @brief Allocates space in the heap, using best fit
+  * @param heap : (vl_heap*) heap to allocate from
+  * @param alloc : (ot_uint) number of bytes needed to allocate
   * @retval vaddr : virtual address of the spot in heap to put data.
   *                 returns @c NULL_vaddr @c if heap has no room
   *
-  * @c sub_find_empty_heap() @c runs in quadratic time based on the @c num_headers
-  * parameter.  Implementations on systems that are less memory constrained 
-  * could be made faster.  @c sub_find_empty_heap() @c only runs when adding a ISF
-  * file, which may never even happen.
+  * The smallest free extent that is big enough is used, and if there are
+  * several, the one with the lowest address.
+  */
+vaddr sub_heap_alloc(vl_heap* heap, ot_uint alloc);
+
+
+
+/** @brief Returns space to the heap, merging it with free neighbors
+  * @param heap : (vl_heap*) heap that the space belongs to
+  * @param base : (vaddr) first byte of the space
+  * @param size : (ot_uint) number of bytes
+  * @retval none
   */
-vaddr sub_find_empty_heap(  vaddr heap_base, vaddr heap_end, 
-                        vaddr header, ot_uint new_alloc, ot_int num_headers);
+void sub_heap_free(vl_heap* heap, vaddr base, ot_uint size);
 
 
 
-/** @brief Defragments a given heap space
-  * @param base : (vaddr) base vaddr of the heap space to defragment
-  * @param size : (size_t) number of bytes in heap space
-  * @retval vaddr : Non-zero on failure
+/** @brief Moves one file in a heap out of the way of the lowest free extent
+  * @param heap : (vl_heap*) heap to defragment
+  * @retval ot_u8 : 1 if a file was moved, 0 if there is nothing to do now
   *
-  * Run this function to clean out fragmented empty space in a heap.  For 
-  * example, if @c sub_find_empty_heap() @c returns NULL_vaddr
+  * The lowest free extent is taken, and the file just above it is moved down
+  * into it, so the free extent moves up and merges with the next one.  If the
+  * file is bigger than the free extent, it is moved to the best free extent
+  * above instead, and the lowest free extent grows by its old space.  Each 
+  * call moves one file, so it can be done in idle time.  The heap is compact
+  * when the only free extent is at the end.  A file that is open is not moved
+  * (its vlFILE has the old base address), so this returns 0 until it is 
+  * closed.  A file that fits nowhere is not moved either.
   *
-  * Not implemented at time being.
+  * The copy never overlaps the file, and the file's header is switched to 
+  * the copy with one write, so if power is lost during the move, the file is
+  * whole at either its old or its new base.  vl_init() rebuilds the heap from
+  * the headers, so the space that is not used is free again.
   */
-ot_u8 sub_defragment_heap(vaddr base, ot_uint window);
+ot_u8 sub_defragment_heap(vl_heap* heap);
 
 
 
@@ -222,6 +424,29 @@ void vl_init() {
     // Copy to mirror
     ISF_loadmirror();
     
+    /// Index the file IDs in each header block that gets searched
+#   if (OT_FEATURE(VLINDEX) == ENABLED)
+#   if (GFB_NUM_USER_FILES > 0)
+    sub_index_build(vlindex_gfb, 0, 256, GFB_Header_START, GFB_NUM_USER_FILES);
+#   endif
+    sub_index_build(vlindex_isfs, 0, 256, ISFS_Header_START, ISFS_NUM_LISTS);
+#   if ((OT_FEATURE(VLNEW) == ENABLED) && (ISF_NUM_USER_FILES > 0))
+    sub_index_build(vlindex_isf, VLINDEX_ISF_FIRST, VLINDEX_ISF_IDS, 
+                    ISF_Header_START_USER, ISF_NUM_USER_FILES);
+#   endif
+#   endif
+
+    /// Find the free space in each heap that can get new files
+#   if (VLHEAP_GFB)
+    sub_heap_build(&vlheap_gfb);
+#   endif
+#   if (VLHEAP_ISFS)
+    sub_heap_build(&vlheap_isfs);
+#   endif
+#   if (VLHEAP_ISF)
+    sub_heap_build(&vlheap_isf);
+#   endif
+    
     
 #if (CC_SUPPORT == SIM_GCC)
 
@@ -305,6 +530,8 @@ ot_u8 vl_new(vlFILE** fp_new, vlBLOCK block_id, ot_u8 data_id, ot_u8 mod, ot_uin
         return 0x06;
     }
     
+    sub_index_put(block_id, data_id, (*fp_new)->header);
+    sub_gen_all();
     return 0;
 #else
     return 255;
@@ -358,7 +585,12 @@ ot_u8 vl_delete(vlBLOCK block_id, ot_u8 data_id, id_tmpl* user_id) {
         }
     }
     
-    sub_delete_file(header);
+    sub_delete_file(header, sub_get_heap(block_id));
+    sub_index_put(block_id, data_id, NULL_vaddr);
+    sub_gen_all();
+    if (block_id == 2) {
+        auth_invalidate_key(data_id);
+    }
     return 0;
 #else
     return 255; //error, delete disabled
@@ -473,6 +705,7 @@ ot_u8 vl_chmod(vlBLOCK block_id, ot_u8 data_id, ot_u8 mod, id_tmpl* user_id) {
         idmod.ubyte[1]  = mod;
         
         sub_write_header((header+4), &idmod.ushort, 2);
+        sub_gen_all();
     }
 
     return output;
@@ -494,9 +727,14 @@ ot_u8 vl_write( vlFILE* fp, ot_uint offset, ot_u16 data ) {
     if (offset >= fp->alloc) {
         return 255;
     }
+    sub_isf_written(fp);
+    vlgen[VLGEN_SLOT(fp->header)]++;
     if (offset >= fp->length) {
         fp->length = offset+2;
     }
+    if (fp->read == &vsram_read) {
+        sub_mirror_mark((offset+fp->start), 2);
+    }
     
     return fp->write( (offset+fp->start), data);
 }
@@ -504,49 +742,112 @@ ot_u8 vl_write( vlFILE* fp, ot_uint offset, ot_u16 data ) {
 
 
 
-#ifndef EXTF_vl_load
-ot_uint vl_load( vlFILE* fp, ot_uint length, ot_u8* data ) {
+#ifndef EXTF_vl_read_block
+ot_uint vl_read_block( vlFILE* fp, ot_uint offset, ot_uint length, ot_u8* data ) {
     Twobytes    scratch;
     ot_uint     cursor;
+    ot_uint     limit;
 
-    if (length > fp->length) {
-        length = fp->length;
+    /// One bounds check for the whole block: clip it to the allocation
+    if (offset >= fp->alloc) {
+        return 0;
+    }
+    if (length > (fp->alloc - offset)) {
+        length = fp->alloc - offset;
     }
 
-    cursor      = fp->start;
-    length      = cursor+length;
+    /// VSRAM is contiguous and byte addressable, so the block is one copy
+    if (fp->read == &vsram_read) {
+        platform_memcpy(data, vsram_get(fp->start+offset), (ot_int)length);
+        return length;
+    }
 
-    for (; cursor<length; cursor++) {
-        ot_u8 align = (cursor & 1);
-        if (align == 0) {
-            scratch.ushort = fp->read(cursor);
+    /// So is VWORM on a core that maps it (see VWORM_CONTIGUOUS)
+#   if (VWORM_CONTIGUOUS == ENABLED)
+    {   ot_u8* src = vworm_get(fp->start+offset);
+        if (src != NULL) {
+            platform_memcpy(data, src, (ot_int)length);
+            return length;
         }
-        *data++ = scratch.ubyte[align];
+    }
+#   endif
+
+    /// Else the core may be paged (in X2, the data is the XNOR of a primary
+    /// and an ancillary page), so VWORM is read a word at a time.
+    cursor  = fp->start + offset;
+    limit   = cursor + length;
+
+    if ((cursor & 1) && (cursor < limit)) {
+        scratch.ushort  = fp->read(cursor-1);
+        *data++         = scratch.ubyte[1];
+        cursor++;
+    }
+    for (; cursor < (limit & ~1); cursor+=2) {
+        scratch.ushort  = fp->read(cursor);
+        *data++         = scratch.ubyte[0];
+        *data++         = scratch.ubyte[1];
+    }
+    if (cursor < limit) {
+        scratch.ushort  = fp->read(cursor);
+        *data           = scratch.ubyte[0];
     }
 
-    return (length - fp->start);
+    return length;
 }
 #endif
 
 
-#ifndef EXTF_vl_store
-ot_u8 vl_store( vlFILE* fp, ot_uint length, ot_u8* data ) {
+
+#ifndef EXTF_vl_write_block
+ot_u8 vl_write_block( vlFILE* fp, ot_uint offset, ot_uint length, ot_u8* data ) {
     Twobytes    scratch;
     ot_uint     cursor;
+    ot_uint     limit;
     ot_u8       test;
 
-    if (length > fp->alloc) {
+    /// One bounds check for the whole block: it must fit in the allocation
+    if ((offset > fp->alloc) || (length > (fp->alloc - offset))) {
         return 255;
     }
+    if (length == 0) {
+        return 0;
+    }
+    sub_isf_written(fp);
+    vlgen[VLGEN_SLOT(fp->header)]++;
+    if ((offset+length) > fp->length) {
+        fp->length = offset+length;
+    }
 
-    fp->length  = length;
-    cursor      = fp->start;
-    length      = cursor+length;
+    /// VSRAM is contiguous and byte addressable, so the block is one copy
+    if (fp->read == &vsram_read) {
+        platform_memcpy(vsram_get(fp->start+offset), data, (ot_int)length);
+        sub_mirror_mark((fp->start+offset), length);
+        return 0;
+    }
 
-    for (test=0; cursor<length; cursor+=2) {
-        scratch.ubyte[0]    = *data++;
-        scratch.ubyte[1]    = *data++;
-        test               |= fp->write(cursor, scratch.ushort);
+    /// VWORM is written a word at a time through the core.  A byte at an odd
+    /// start or end shares its word with data outside the block, so that word
+    /// is read, patched and written back.
+    cursor  = fp->start + offset;
+    limit   = cursor + length;
+    test    = 0;
+
+    if (cursor & 1) {
+        cursor--;
+        scratch.ushort  = fp->read(cursor);
+        scratch.ubyte[1]= *data++;
+        test           |= fp->write(cursor, scratch.ushort);
+        cursor         += 2;
+    }
+    for (; cursor < (limit & ~1); cursor+=2) {
+        scratch.ubyte[0]= *data++;
+        scratch.ubyte[1]= *data++;
+        test           |= fp->write(cursor, scratch.ushort);
+    }
+    if (cursor < limit) {
+        scratch.ushort  = fp->read(cursor);
+        scratch.ubyte[0]= *data;
+        test           |= fp->write(cursor, scratch.ushort);
     }
 
     return test;
@@ -555,6 +856,30 @@ ot_u8 vl_store( vlFILE* fp, ot_uint length, ot_u8* data ) {
 
 
 
+#ifndef EXTF_vl_load
+ot_uint vl_load( vlFILE* fp, ot_uint length, ot_u8* data ) {
+    if (length > fp->length) {
+        length = fp->length;
+    }
+    return vl_read_block(fp, 0, length, data);
+}
+#endif
+
+
+#ifndef EXTF_vl_store
+ot_u8 vl_store( vlFILE* fp, ot_uint length, ot_u8* data ) {
+    if (length > fp->alloc) {
+        return 255;
+    }
+    sub_isf_written(fp);
+    fp->length = length;
+
+    return vl_write_block(fp, 0, length, data);
+}
+#endif
+
+
+
 
 #ifndef EXTF_vl_close
 ot_u8 vl_close( vlFILE* fp ) {
@@ -562,7 +887,10 @@ ot_u8 vl_close( vlFILE* fp ) {
         if (fp->read == &vsram_read) {
             ot_u16* mhead;
             mhead   = (ot_u16*)vsram_get(fp->start-2);
-            *mhead  = (*mhead != fp->length) ? fp->length : *mhead;
+            if (*mhead != fp->length) {
+                *mhead = fp->length;
+                sub_mirror_mark((fp->start-2), 2);
+            }
         }
         else if ( vworm_read(fp->header+0) != fp->length ) {
             sub_write_header( (fp->header+0), &(fp->length), 2);
@@ -607,6 +935,157 @@ ot_uint vl_checkalloc( vlFILE* fp ) {
 
 
 
+#ifndef EXTF_vl_genmask
+ot_u8 vl_genmask( vlFILE* fp ) {
+    return (ot_u8)(1 << VLGEN_SLOT(fp->header));
+}
+#endif
+
+
+
+#ifndef EXTF_vl_gensum
+ot_u16 vl_gensum( ot_u8 genmask ) {
+    ot_u16  sum = 0;
+    ot_int  i;
+    
+    for (i=0; genmask!=0; i++, genmask>>=1) {
+        if (genmask & 1) {
+            sum += vlgen[i];
+        }
+    }
+    return sum;
+}
+#endif
+
+
+
+#ifndef EXTF_vl_series_open
+ot_int vl_series_open( vlSERIES* it, ot_u8 is_series, ot_u8 isf_id, 
+                        ot_int offset, ot_int window, id_tmpl* user_id ) {
+    it->genmask = 0;
+    it->isf_id  = isf_id;
+    it->next    = 0;
+    it->count   = 1;
+    it->offset  = offset;
+    it->window  = window;
+    it->user_id = user_id;
+    it->fp_s    = NULL;
+    it->fp_f    = NULL;
+    
+    /// A single ISF is treated as a series of one file
+    if (is_series) {
+        it->fp_s = ISFS_open(isf_id, VL_ACCESS_R, user_id);
+        if (it->fp_s == NULL) {
+            return -1;
+        }
+        it->genmask = vl_genmask(it->fp_s);
+        it->count   = it->fp_s->length;
+    }
+    return 0;
+}
+#endif
+
+
+
+#ifndef EXTF_vl_series_next
+ot_int vl_series_next( vlSERIES* it ) {
+    ot_int length;
+
+    while (1) {
+        /// Open the next file of the series.  The series data is a list of
+        /// file IDs, one per byte.  All of the files are opened, even after
+        /// the window is done, because all of them must be accessible.
+        if (it->fp_f == NULL) {
+            Twobytes scratch;
+        
+            if (it->next >= it->count) {
+                break;
+            }
+            if (it->fp_s != NULL) {
+                scratch.ushort  = vl_read(it->fp_s, (it->next & ~1));
+                it->isf_id      = scratch.ubyte[it->next & 1];
+            }
+            it->next++;
+            
+            it->fp_f = ISF_open(it->isf_id, VL_ACCESS_R, it->user_id);
+            if (it->fp_f == NULL) {
+                return -1;
+            }
+            it->genmask |= vl_genmask(it->fp_f);
+        }
+        
+        /// If the offset is past this file, subtract the file length from it
+        /// and go to the next file.
+        length = (ot_int)it->fp_f->length - it->offset;
+        if ((length <= 0) || (it->window <= 0)) {
+            it->offset = -length;
+            vl_close(it->fp_f);
+            it->fp_f = NULL;
+            continue;
+        }
+        if (length > it->window) {
+            length = it->window;
+        }
+        
+        /// VSRAM data is given in place, and so is VWORM data on a core that
+        /// maps it (see VWORM_CONTIGUOUS).  Else VWORM data is copied.
+        it->span = NULL;
+        if (it->fp_f->read == &vsram_read) {
+            it->span = vsram_get(it->fp_f->start + it->offset);
+        }
+#       if (VWORM_CONTIGUOUS == ENABLED)
+        else {
+            it->span = vworm_get(it->fp_f->start + it->offset);
+        }
+#       endif
+        if (it->span == NULL) {
+            if (length > VL_SPAN_BYTES) {
+                length = VL_SPAN_BYTES;
+            }
+            vl_read_block(it->fp_f, it->offset, length, it->buffer);
+            it->span = it->buffer;
+        }
+        it->offset += length;
+        it->window -= length;
+        return length;
+    }
+    
+    return 0;
+}
+#endif
+
+
+
+#ifndef EXTF_vl_series_close
+void vl_series_close( vlSERIES* it ) {
+    vl_close(it->fp_f);
+    vl_close(it->fp_s);
+    it->fp_f = NULL;
+    it->fp_s = NULL;
+}
+#endif
+
+
+
+#ifndef EXTF_vl_defrag_step
+ot_bool vl_defrag_step() {
+#if (OT_FEATURE(VLDEFRAG) == ENABLED)
+    ot_u8 block;
+    vl_heap* heap;
+
+    for (block=0; block<3; block++) {
+        heap = sub_get_heap(block);
+        if ((heap != NULL) && sub_defragment_heap(heap)) {
+            return True;
+        }
+    }
+#endif
+    return False;
+}
+#endif
+
+
+
 
 
 
@@ -671,12 +1150,22 @@ ot_u8 ISF_chmod_su( ot_u8 id, ot_u8 mod ) {
 
 ot_u8 ISF_syncmirror() {
 #   if (ISF_MIRROR_HEAP_BYTES > 0)
-        return sub_isf_mirror(MIRROR_TO_FLASH);
+        return (sub_mirror_sync(~0) != 0);
 #   else
         return 0;
 #   endif
 }
 
+#ifndef EXTF_ISF_syncmirror_step
+ot_uint ISF_syncmirror_step(ot_uint limit) {
+#   if (ISF_MIRROR_HEAP_BYTES > 0)
+        return sub_mirror_sync(limit);
+#   else
+        return 0;
+#   endif
+}
+#endif
+
 ot_u8 ISF_loadmirror() {
 #   if (ISF_MIRROR_HEAP_BYTES > 0)
         return sub_isf_mirror(MIRROR_TO_SRAM);
@@ -711,11 +1200,7 @@ vlFILE* sub_gfb_new(ot_u8 id, ot_u8 mod, ot_u8 null_arg) {
     new_header.mirror   = NULL_vaddr;
     
     // Find where to put the new data, and if heap is full
-    return sub_new_file(    &new_header,
-                        GFB_HEAP_USER_START, 
-                        GFB_HEAP_END,
-                        GFB_Header_START_USER, 
-                        GFB_NUM_USER_FILES   ); 
+    return sub_new_file(&new_header, &vlheap_gfb); 
 #else
     return NULL;
 #endif
@@ -736,11 +1221,7 @@ vlFILE* sub_isfs_new(ot_u8 id, ot_u8 mod, ot_u8 null_arg) {
     new_header.mirror   = NULL_vaddr;
     
     // Find where to put the new data, and if heap is full
-    return sub_new_file(    &new_header, 
-                        ISFS_HEAP_USER_START,
-                        ISFS_HEAP_END,
-                        ISFS_Header_START_USER, 
-                        ISFS_NUM_USER_CODES   );
+    return sub_new_file(&new_header, &vlheap_isfs);
 #else
     return NULL;
 #endif
@@ -766,11 +1247,7 @@ vlFILE* sub_isf_new(ot_u8 id, ot_u8 mod, ot_u8 max_length ) {
     new_header.alloc &= ~1;
     
     // Find where to put the new data, and if heap is full
-    return sub_new_file(&new_header, 
-                        ISF_HEAP_USER_START, 
-                        ISF_HEAP_END,
-                        ISF_Header_START_USER, 
-                        ISF_NUM_USER_FILES ); 
+    return sub_new_file(&new_header, &vlheap_isf); 
 #else
     return NULL;
 #endif
@@ -811,12 +1288,20 @@ ot_u8 sub_isf_delete_check(ot_u8 id) {
 
 
 vaddr sub_gfb_search(ot_u8 id) {
+#   if ((OT_FEATURE(VLINDEX) == ENABLED) && (GFB_NUM_USER_FILES > 0))
+    return sub_index_lookup(vlindex_gfb, id, GFB_Header_START);
+#   else
     return sub_header_search( GFB_Header_START, id, GFB_NUM_USER_FILES );
+#   endif
 }
 
 
 vaddr sub_isfs_search(ot_u8 id) {
+#   if (OT_FEATURE(VLINDEX) == ENABLED)
+    return sub_index_lookup(vlindex_isfs, id, ISFS_Header_START);
+#   else
     return sub_header_search( ISFS_Header_START, id, ISFS_NUM_LISTS );
+#   endif
 }
 
 
@@ -825,7 +1310,11 @@ vaddr sub_isf_search(ot_u8 id) {
     // Check IDs added by the user during runtime
     if ( (id >= (ISF_NUM_M1_FILES+ISF_NUM_M2_FILES)) && \
             (id < (256-ISF_NUM_EXT_FILES)) ) {
+#       if ((OT_FEATURE(VLINDEX) == ENABLED) && (ISF_NUM_USER_FILES > 0))
+        return sub_index_lookup(vlindex_isf, (id-VLINDEX_ISF_FIRST), ISF_Header_START_USER);
+#       else
         return sub_header_search(ISF_Header_START_USER, id, ISF_NUM_USER_FILES);
+#       endif
     }
 #   endif
 
@@ -849,6 +1338,112 @@ vaddr sub_isf_search(ot_u8 id) {
 
 
 
+void sub_index_build(ot_u8* table, ot_u8 id_first, ot_int num_ids, vaddr header, ot_int num_headers) {
+#if (OT_FEATURE(VLINDEX) == ENABLED)
+    Twobytes    idmod;
+    ot_u16      base;
+    ot_int      slot;
+    ot_int      i;
+
+    for (i=0; i<num_ids; i++) {
+        table[i] = VLINDEX_NONE;
+    }
+    
+    for (slot=0; slot<num_headers; slot++, header+=sizeof(vl_header)) {
+        base            = vworm_read(header + 6);
+        idmod.ushort    = vworm_read(header + 4);
+        i               = (ot_int)idmod.ubyte[0] - (ot_int)id_first;
+        
+        if ((base != 0) && (base != 0xFFFF) && (i >= 0) && (i < num_ids)) {
+            if (table[i] == VLINDEX_NONE) {
+                table[i] = (ot_u8)slot;
+            }
+        }
+    }
+#endif
+}
+
+
+vaddr sub_index_lookup(ot_u8* table, ot_u8 index, vaddr header) {
+#if (OT_FEATURE(VLINDEX) == ENABLED)
+    ot_u8 slot = table[index];
+
+    if (slot == VLINDEX_NONE) {
+        return NULL_vaddr;
+    }
+    return header + ((vaddr)slot * sizeof(vl_header));
+#else
+    return NULL_vaddr;
+#endif
+}
+
+
+void sub_index_put(ot_u8 block, ot_u8 id, vaddr header) {
+#if (OT_FEATURE(VLINDEX) == ENABLED)
+    ot_u8*  table;
+    vaddr   block_start;
+    ot_int  num_headers;
+    
+    switch (block) {
+#   if (GFB_NUM_USER_FILES > 0)
+        case 0: table       = &vlindex_gfb[id];
+                block_start = GFB_Header_START;
+                num_headers = GFB_NUM_USER_FILES;
+                break;
+#   endif
+        case 1: table       = &vlindex_isfs[id];
+                block_start = ISFS_Header_START;
+                num_headers = ISFS_NUM_LISTS;
+                break;
+                
+#   if ((OT_FEATURE(VLNEW) == ENABLED) && (ISF_NUM_USER_FILES > 0))
+        case 2: if ((id < VLINDEX_ISF_FIRST) || (id >= (256-ISF_NUM_EXT_FILES))) {
+                    return;
+                }
+                table       = &vlindex_isf[id-VLINDEX_ISF_FIRST];
+                block_start = ISF_Header_START_USER;
+                num_headers = ISF_NUM_USER_FILES;
+                break;
+#   endif
+       default: return;
+    }
+    
+    /// On delete, another header could have the same ID, so search for it.
+    /// Deletes are rare, and this keeps the index the same as the search.
+    if (header == NULL_vaddr) {
+        header = sub_header_search(block_start, id, num_headers);
+    }
+    *table = (header == NULL_vaddr) ? VLINDEX_NONE : \
+                (ot_u8)((header - block_start) / sizeof(vl_header));
+#endif
+}
+
+
+
+
+
+void sub_gen_all() {
+    ot_int i;
+    for (i=0; i<VL_GEN_SLOTS; i++) {
+        vlgen[i]++;
+    }
+}
+
+
+
+void sub_isf_written(vlFILE* fp) {
+    if ( (fp->header >= ISF_Header_START) && 
+         (fp->header < (ISF_Header_START + (ISF_NUM_FILES*sizeof(vl_header)))) ) {
+        Twobytes idmod;
+        idmod.ushort = fp->idmod;
+        auth_invalidate_key(idmod.ubyte[0]);
+    }
+}
+
+
+
+
+
 ot_u8 sub_isf_mirror(ot_u8 direction) {
     vaddr   header;
     vaddr   header_base;
@@ -896,7 +1491,101 @@ ot_u8 sub_isf_mirror(ot_u8 direction) {
         }
     }
     
+#   if (ISF_MIRROR_HEAP_BYTES > 0)
+    /// The mirror now matches VWORM
+    if (direction == MIRROR_TO_SRAM) {
+        for (i=0; i<(ot_int)sizeof(vlmirror_dirty); i++) {
+            vlmirror_dirty[i] = 0;
+        }
+        vlmirror_pending = 0;
+    }
+#   endif
+    
+    return 0;
+}
+
+
+
+void sub_mirror_mark(vaddr addr, ot_uint span) {
+#if (ISF_MIRROR_HEAP_BYTES > 0)
+    ot_uint word;
+    ot_uint end;
+    ot_u8   bit;
+
+    word    = MIRROR_WORD(addr);
+    end     = MIRROR_WORD(addr+span-1);
+    for (; word<=end; word++) {
+        bit = 1 << (word & 7);
+        if ((vlmirror_dirty[word>>3] & bit) == 0) {
+            vlmirror_dirty[word>>3] |= bit;
+            vlmirror_pending++;
+        }
+    }
+#endif
+}
+
+
+
+ot_uint sub_mirror_sync(ot_uint limit) {
+#if (ISF_MIRROR_HEAP_BYTES > 0)
+    vaddr   header;
+    vaddr   header_base;
+    vaddr   header_mirror;
+    vaddr   mirror_start;
+    vaddr   mirror_end;
+    ot_uint word;
+    ot_u8   bit;
+    ot_int  i;
+
+    /// Go through the ISF Header array, like sub_isf_mirror(), until there is
+    /// nothing pending or the limit is used up.  The mirror of a file is its
+    /// length word and then alloc bytes of data.  The length word goes to
+    /// header+0, and data word n goes to base+2n.  Mirror-only files have
+    /// nowhere to go in VWORM, so their bits are just cleared.
+    header = ISF_Header_START;
+    for (i=0; (i<ISF_NUM_STOCK_FILES) && (vlmirror_pending != 0); \
+                i++, header+=sizeof(vl_header)) {
+        header_mirror = vworm_read(header+8);
+        if (header_mirror == NULL_vaddr) {
+            continue;
+        }
+        header_base = vworm_read(header+6);
+        mirror_start= header_mirror;
+        mirror_end  = header_mirror + 2 + vworm_read(header+2);
+        word        = MIRROR_WORD(header_mirror);
+
+        for (; header_mirror<mirror_end; header_mirror+=2, word++) {
+            // Skip clean bytes of the map in one step
+            if ((word & 7) == 0) {
+                while ((header_mirror<mirror_end) && (vlmirror_dirty[word>>3] == 0)) {
+                    header_mirror  += 16;
+                    word           += 8;
+                }
+                if (header_mirror >= mirror_end) {
+                    break;
+                }
+            }
+            bit = 1 << (word & 7);
+            if (vlmirror_dirty[word>>3] & bit) {
+                if (header_base != NULL_vaddr) {
+                    if (limit == 0) {
+                        return vlmirror_pending;
+                    }
+                    limit--;
+                    vworm_write( (header_mirror == mirror_start) ? (header+0) : \
+                                    (header_base + (header_mirror - mirror_start - 2)),
+                                 *(ot_u16*)vsram_get(header_mirror) );
+                }
+                vlmirror_dirty[word>>3] &= ~bit;
+                vlmirror_pending--;
+            }
+        }
+    }
+
+    return vlmirror_pending;
+#else
     return 0;
+#endif
 }
 
 
@@ -923,23 +1612,19 @@ vlFILE* sub_new_fp() {
 }
 
 
-vlFILE* sub_new_file(vl_header* new_header, vaddr heap_base, vaddr heap_end, vaddr header_base, ot_int header_window ) {
+vlFILE* sub_new_file(vl_header* new_header, vl_heap* heap) {
 #if (OT_FEATURE(VLNEW) == ENABLED)
     //vlFILE* fp;
     //vaddr   new_base    = 0;
     vaddr   header_addr = 0;
 
     // Find where to put the new header, and if it's full
-    header_addr = sub_find_empty_header( header_base, header_window );
+    header_addr = sub_find_empty_header( heap->header, heap->num_headers );
     if (header_addr == NULL_vaddr) 
         return NULL;
     
     // Find where to put the new data, and if heap is full
-    new_header->base = sub_find_empty_heap( heap_base, 
-                                            heap_end, 
-                                            header_base, 
-                                            (ot_uint)new_header->alloc, 
-                                            header_window );
+    new_header->base = sub_heap_alloc(heap, (ot_uint)new_header->alloc);
     if (new_header->base == NULL_vaddr) 
         return NULL;
     
@@ -968,7 +1653,7 @@ vlFILE* sub_new_file(vl_header* new_header, vaddr heap_base, vaddr heap_end, vad
 
 
 
-void sub_delete_file(vaddr del_header) { 
+void sub_delete_file(vaddr del_header, vl_heap* heap) { 
 #if (OT_FEATURE(VLNEW) == ENABLED)
     vaddr   header_base;
     ot_u16  header_alloc;
@@ -980,6 +1665,11 @@ void sub_delete_file(vaddr del_header) {
     vworm_wipeblock(header_base, header_alloc);
     vworm_mark((del_header+2), 0);                //alloc
     vworm_mark((del_header+6), NULL_vaddr);       //base
+    
+    // Give the space back to the heap
+    if (heap != NULL) {
+        sub_heap_free(heap, header_base, header_alloc);
+    }
 #endif
 }
 
@@ -1040,80 +1730,264 @@ vaddr sub_find_empty_header(vaddr header, ot_int num_headers) {
 }
 
 
-/// @todo This checks out in testing, although it is a complex function that
-///       probably merits further testing
-vaddr sub_find_empty_heap(  vaddr heap_base, vaddr heap_end, 
-                        vaddr header, ot_uint new_alloc, ot_int num_headers) {
+vl_heap* sub_get_heap(ot_u8 block) {
+    switch (block) {
+#   if (VLHEAP_GFB)
+        case 0: return &vlheap_gfb;
+#   endif
+#   if (VLHEAP_ISFS)
+        case 1: return &vlheap_isfs;
+#   endif
+#   if (VLHEAP_ISF)
+        case 2: return &vlheap_isf;
+#   endif
+       default: return NULL;
+    }
+}
+
+
 #if (OT_FEATURE(VLNEW) == ENABLED)
-    //Search all header combinations to find:
-    // - pairs of adjacent files in the heap
-    // - gaps between these pairs
-    // - the smallest gap that is big enough.
-    vaddr   loop1           = header;
-    vaddr   loop1_base;
-    ot_uint loop1_alloc;
-    vaddr   loop2;
-    vaddr   loop2_base;
-    //ot_uint loop2_alloc;	///@todo figure out why this is disused
+static ot_bool sub_extent_before(vl_extent* a, vl_extent* b) {
+/// Order of the free list: by size, and then by base
+    return (ot_bool)((a->size < b->size) || ((a->size == b->size) && (a->base < b->base)));
+}
+
+
+static void sub_extent_sort(vl_extent* list, ot_int count, ot_bool by_size) {
+/// Insertion sort, only used by sub_heap_build()
+    vl_extent   x;
+    ot_int      i, j;
     
-    ot_int  i;
-    ot_int  j;
-    ot_int  gap;
-    ot_int  closest_gap     = (ot_int)(heap_end - heap_base);
-    ot_int  bestfit_alloc   = (ot_int)(32767);
-    vaddr   bestfit_base    = NULL_vaddr;
-    //vaddr   loop1_end       = heap_base;
-    
-    for (i=0; i<num_headers; i++, loop1+=sizeof(vl_header) ) {
-        loop1_alloc = vworm_read(loop1 + 2);                                    // load alloc (max) from header
-        loop1_base  = vworm_read(loop1 + 6);                                    // load base from header
-        
-        if ( loop1_base != NULL_vaddr ) {                                       // skip if header is deleted, or empty
-            heap_base   = (vaddr)(loop1_base + loop1_alloc);
-            loop2       = header;
-        
-            for (j=0; j<num_headers; j++, loop2+=sizeof(vl_header) ) {
-                //loop2_alloc = vworm_read(loop2 + 2);
-                loop2_base  = vworm_read(loop2 + 6);
-            
-                if ( (loop2_base != NULL_vaddr) && (loop2_base > heap_base) ) { // if header is valid ...
-                    gap = (ot_int)(loop2_base - heap_base);                     // calc gap between the two files
-                
-                    if (gap < closest_gap) {                                    // The closest gap ...
-                        closest_gap = gap;                                      // will be between two adjacent ...
-                        //heap_base   = loop1_end;                                // files in the heap.
-                    }
-                }
+    for (i=1; i<count; i++) {
+        x = list[i];
+        for (j=i; j>0; j--) {
+            if (by_size ? !sub_extent_before(&x, &list[j-1]) : (list[j-1].base <= x.base)) {
+                break;
             }
+            list[j] = list[j-1];
+        }
+        list[j] = x;
+    }
+}
+
+
+static void sub_extent_remove(vl_heap* heap, ot_int i) {
+    heap->count--;
+    for (; i<heap->count; i++) {
+        heap->extent[i] = heap->extent[i+1];
+    }
+}
+
+
+static void sub_extent_insert(vl_heap* heap, vaddr base, ot_uint size) {
+    vl_extent   x;
+    ot_int      lo, hi, mid;
+    
+    x.base  = base;
+    x.size  = (ot_u16)size;
+    lo      = 0;
+    hi      = heap->count;
+    while (lo < hi) {
+        mid = (lo + hi) >> 1;
+        if (sub_extent_before(&heap->extent[mid], &x))  lo = mid + 1;
+        else                                            hi = mid;
+    }
+    for (hi=heap->count; hi>lo; hi--) {
+        heap->extent[hi] = heap->extent[hi-1];
+    }
+    heap->extent[lo] = x;
+    heap->count++;
+}
+#endif
+
+
+void sub_heap_build(vl_heap* heap) {
+#if (OT_FEATURE(VLNEW) == ENABLED)
+    vaddr   header;
+    vaddr   base;
+    vaddr   cursor;
+    vaddr   used_end;
+    ot_uint alloc;
+    ot_int  used;
+    ot_int  i;
+    
+    /// 1. Put the files that are in the heap into the list, sorted by base
+    used    = 0;
+    header  = heap->header;
+    for (i=0; i<heap->num_headers; i++, header+=sizeof(vl_header)) {
+        alloc   = vworm_read(header + 2);
+        base    = vworm_read(header + 6);
+        if ((base != NULL_vaddr) && (alloc != 0) && \
+            (base >= heap->start) && (base < heap->end)) {
+            heap->extent[used].base = base;
+            heap->extent[used].size = (ot_u16)alloc;
+            used++;
+        }
+    }
+    sub_extent_sort(heap->extent, used, False);
+    
+    /// 2. Replace them, in place, with the gaps between them.  The gap before
+    ///    file i goes to position <= i, so file i is read before it is lost.
+    heap->count = 0;
+    cursor      = heap->start;
+    for (i=0; i<=used; i++) {
+        if (i < used) {
+            base        = heap->extent[i].base;
+            used_end    = base + heap->extent[i].size;
+        }
+        else {
+            base        = heap->end;
+            used_end    = heap->end;
+        }
+        if (base > cursor) {
+            heap->extent[heap->count].base = cursor;
+            heap->extent[heap->count].size = (ot_u16)(base - cursor);
+            heap->count++;
         }
-        //if (closest_gap >= new_alloc) {                                         // If the gap between loop1 and next file ...
-        //    if (closest_gap < bestfit_alloc) {                                  // is big enough for the data we need ...
-        //        bestfit_alloc   = closest_gap;                                  // and is smaller than other big-enough gaps ...
-        //        bestfit_base    = heap_base;                                    // then it is the gap we will write into.
-        //    }
-        //}
-        if ((closest_gap >= new_alloc) && (closest_gap < bestfit_alloc))  {
-            bestfit_alloc   = closest_gap;
-            bestfit_base    = heap_base;
+        if (used_end > cursor) {
+            cursor = used_end;
         }
+    }
+    
+    /// 3. Sort the free list by size
+    sub_extent_sort(heap->extent, heap->count, True);
+#endif
+}
 
+
+vaddr sub_heap_alloc(vl_heap* heap, ot_uint alloc) {
+#if (OT_FEATURE(VLNEW) == ENABLED)
+    vl_extent   best;
+    ot_int      lo, hi, mid;
+    
+    /// Binary search for the first extent with size >= alloc
+    lo  = 0;
+    hi  = heap->count;
+    while (lo < hi) {
+        mid = (lo + hi) >> 1;
+        if (heap->extent[mid].size < alloc) lo = mid + 1;
+        else                                hi = mid;
+    }
+    if (lo == heap->count) {
+        return NULL_vaddr;
     }
     
-    return bestfit_base;
+    /// Take the front of it, and put back what is left
+    best = heap->extent[lo];
+    sub_extent_remove(heap, lo);
+    if (best.size > alloc) {
+        sub_extent_insert(heap, best.base+alloc, best.size-alloc);
+    }
+    return best.base;
 #else
     return NULL_vaddr;
 #endif
 }
 
 
-
-
-//Save sub_defragment_heap for a rainy day
-ot_u8 sub_defragment_heap(vaddr base, ot_uint window) {
-    return ~0;
+void sub_heap_free(vl_heap* heap, vaddr base, ot_uint size) {
+#if (OT_FEATURE(VLNEW) == ENABLED)
+    ot_int i;
+    
+    if ((size == 0) || (base == NULL_vaddr)) {
+        return;
+    }
+    
+    /// Merge with the free extents just below and just above, if any
+    for (i=0; i<heap->count; ) {
+        if ((heap->extent[i].base + heap->extent[i].size) == base) {
+            base    = heap->extent[i].base;
+            size   += heap->extent[i].size;
+            sub_extent_remove(heap, i);
+        }
+        else if (heap->extent[i].base == (base + size)) {
+            size   += heap->extent[i].size;
+            sub_extent_remove(heap, i);
+        }
+        else {
+            i++;
+        }
+    }
+    sub_extent_insert(heap, base, size);
+#endif
 }
 
 
+ot_u8 sub_defragment_heap(vl_heap* heap) {
+#if ((OT_FEATURE(VLNEW) == ENABLED) && (OT_FEATURE(VLDEFRAG) == ENABLED))
+    vl_extent   gap;
+    vaddr       header;
+    vaddr       base;
+    vaddr       dest;
+    ot_uint     alloc;
+    ot_int      i;
+    
+    /// 1. Find the lowest free extent.  If it is at the end, the heap is done.
+    if (heap->count == 0) {
+        return 0;
+    }
+    gap = heap->extent[0];
+    for (i=1; i<heap->count; i++) {
+        if (heap->extent[i].base < gap.base) {
+            gap = heap->extent[i];
+        }
+    }
+    if ((gap.base + gap.size) >= heap->end) {
+        return 0;
+    }
+    
+    /// 2. Find the file that starts where the free extent ends, and make sure
+    ///    that it is not open.
+    header = heap->header;
+    for (i=0; i<heap->num_headers; i++, header+=sizeof(vl_header)) {
+        if (vworm_read(header + 6) == (gap.base + gap.size)) {
+            break;
+        }
+    }
+    if (i == heap->num_headers) {
+        return 0;
+    }
+    for (i=0; i<OT_FEATURE(VLFPS); i++) {
+        if ((vl_file[i].read != NULL) && (vl_file[i].header == header)) {
+            return 0;
+        }
+    }
+    
+    /// 3. Pick where it goes.  The copy must not overlap the file, so that
+    ///    the file stays whole at its old base until its header is switched.
+    ///    If the gap is big enough, the file goes to the bottom of it.  Else
+    ///    it goes to the best free extent above, and the gap grows by the 
+    ///    space it leaves, so a later step can fill it.
+    alloc   = vworm_read(header + 2);
+    base    = gap.base + gap.size;
+    if (gap.size >= alloc) {
+        for (i=0; heap->extent[i].base != gap.base; i++);
+        sub_extent_remove(heap, i);
+        if (gap.size > alloc) {
+            sub_extent_insert(heap, gap.base+alloc, gap.size-alloc);
+        }
+        dest = gap.base;
+    }
+    else {
+        dest = sub_heap_alloc(heap, alloc);
+        if (dest == NULL_vaddr) {
+            return 0;
+        }
+    }
+    
+    /// 4. Copy it, switch the base in the header (one write), and then wipe
+    ///    the old copy and give it back to the heap.
+    for (i=0; i<alloc; i+=2) {
+        vworm_write(dest+i, vworm_read(base+i));
+    }
+    vworm_write(header + 6, dest);
+    vworm_wipeblock(base, alloc);
+    sub_heap_free(heap, base, alloc);
+    return 1;
+#else
+    return 0;
+#endif
+}
 
 
 
@@ -149,6 +149,42 @@ typedef struct {
 
 
 
+/// Number of write generation counters (see vl_genmask()).  Must be a power
+/// of two, up to 8.
+#define VL_GEN_SLOTS        8
+
+
+/// Bytes that vl_series_next() copies from VWORM into a span at a time.  
+/// Files in VSRAM (or in a contiguous VWORM) are not copied, so their spans 
+/// can be longer.
+#ifndef VL_SPAN_BYTES
+#   define VL_SPAN_BYTES    16
+#endif
+
+
+/** @typedef vlSERIES
+  * Iterator over a window of the data in an ISF, or in the files of an ISF
+  * Series (which is the data of its files, one after the other).  Set it up
+  * with vl_series_open(), get the data as spans with vl_series_next(), and
+  * close it with vl_series_close().  Only span, and genmask (the OR of 
+  * vl_genmask() for each file opened so far), should be used by the caller.
+  */
+typedef struct {
+    ot_u8*      span;
+    ot_u8       genmask;
+    ot_u8       isf_id;
+    ot_int      next;
+    ot_int      count;
+    ot_int      offset;
+    ot_int      window;
+    id_tmpl*    user_id;
+    vlFILE*     fp_s;
+    vlFILE*     fp_f;
+    ot_u8       buffer[VL_SPAN_BYTES];
+} vlSERIES;
+
+
+
 /// Access Control parameters
 #define VL_ACCESS_GUEST     (ot_u8)b00000111
 #define VL_ACCESS_USER      (ot_u8)b00111000
@@ -221,6 +257,10 @@ typedef struct {
   * @param none
   * @retval none
   * @ingroup Veelite
+  *
+  * With OT_FEATURE(VLINDEX), this also builds the RAM index of file IDs that
+  * the open functions use instead of searching the headers.  Files must not
+  * be opened before vl_init() runs.
   */
 void vl_init();
 
@@ -444,6 +484,42 @@ ot_u8 vl_write( vlFILE* fp, ot_uint offset, ot_u16 data );
 
 
 
+/** @brief  Reads a block of bytes from the open file (GFB, ISF, ISFS)
+  * @param  fp          (vlFILE*) file pointer of open file
+  * @param  offset      (ot_uint) byte offset into the file
+  * @param  length      (ot_uint) number of bytes to read
+  * @param  data        (ot_u8*) byte buffer to read into
+  * @retval (ot_uint)   Number of bytes read into the buffer
+  * @ingroup Veelite
+  *
+  * The block is bounds-checked once, and clipped to the allocation of the
+  * file (like vl_read(), it does not stop at the file length).  Files in VSRAM
+  * are copied in one go, and so are files in VWORM if VWORM_CONTIGUOUS is
+  * ENABLED.  Else, files in VWORM are read through the core a word at a time,
+  * since the core may not store them contiguously.  Any offset and length, 
+  * odd or even, can be used.
+  */
+ot_uint vl_read_block( vlFILE* fp, ot_uint offset, ot_uint length, ot_u8* data );
+
+
+
+/** @brief  Writes a block of bytes to the open file (GFB, ISF, ISFS)
+  * @param  fp          (vlFILE*) file pointer of open file
+  * @param  offset      (ot_uint) byte offset into the file
+  * @param  length      (ot_uint) number of bytes to write
+  * @param  data        (ot_u8*) byte buffer to write from
+  * @retval (ot_u8)     Non-zero on failure
+  * @ingroup Veelite
+  *
+  * The block is bounds-checked once: if it does not fit in the allocation of
+  * the file, nothing is written and 255 is returned.  The file length is
+  * extended to the end of the block, if it is not already longer.  Unlike
+  * vl_write(), odd offsets and lengths write exactly the bytes given.
+  */
+ot_u8 vl_write_block( vlFILE* fp, ot_uint offset, ot_uint length, ot_u8* data );
+
+
+
 /** @brief  Loads the contents of a file into a supplied byte-buffer
   * @param  fp          (vlFILE*) file pointer of open file
   * @param  length      (ot_uint) number of bytes to load, starting from beginning of file
@@ -508,6 +584,84 @@ ot_uint vl_checklength( vlFILE* fp );
 ot_uint vl_checkalloc( vlFILE* fp );
 
 
+/** @brief Returns the write generation slot of an open file, as a bit mask
+  * @param fp : (vlFILE*) file pointer of an open file
+  * @retval ot_u8 : one bit set, for the generation slot of the file
+  * @ingroup Veelite
+  *
+  * Every file has one of VL_GEN_SLOTS write generation counters, which goes
+  * up when the file is written.  All of them go up when a file is created or
+  * deleted, or its mod is changed.  OR the masks of the files that a result
+  * is made from, and save vl_gensum() of the mask along with the result.
+  */
+ot_u8 vl_genmask( vlFILE* fp );
+
+
+/** @brief Sums the write generations in a mask from vl_genmask()
+  * @param genmask : (ot_u8) OR of the masks of some files
+  * @retval ot_u16 : sum of the write generations in the mask
+  * @ingroup Veelite
+  *
+  * If the sum is the same as it was, none of the files have been written (and
+  * none have been created or deleted) since then.
+  */
+ot_u16 vl_gensum( ot_u8 genmask );
+
+
+/** @brief Moves one file to defragment the Veelite heaps
+  * @param none
+  * @retval (ot_bool) : True if a file was moved (there may be more to do)
+  * @ingroup Veelite
+  *
+  * With OT_FEATURE(VLDEFRAG), the kernel calls this when it is idle, until 
+  * it returns False.  Each call moves at most one file down into the free
+  * space below it, so the free space in each heap ends up at the end of the
+  * heap.  Open files are not moved.  Without OT_FEATURE(VLDEFRAG), it does
+  * nothing and returns False.
+  */
+ot_bool vl_defrag_step();
+
+
+/** @brief Sets up an iterator over the data of an ISF or ISF Series
+  * @param it : (vlSERIES*) iterator to set up
+  * @param is_series : (ot_u8) 0 for an ISF, non-zero for an ISF Series
+  * @param isf_id : (ot_u8) ID of the ISF or ISF Series
+  * @param offset : (ot_int) byte offset into the data
+  * @param window : (ot_int) bytes of data, following offset, to iterate over
+  * @param user_id : (id_tmpl*) user ID, for read access
+  * @retval (ot_int) : 0 on success, -1 if the ISF Series is not accessible
+  * @ingroup Veelite
+  *
+  * Always call vl_series_close() afterwards, even if this fails.
+  */
+ot_int vl_series_open( vlSERIES* it, ot_u8 is_series, ot_u8 isf_id, 
+                        ot_int offset, ot_int window, id_tmpl* user_id );
+
+
+/** @brief Gets the next span of data from an iterator
+  * @param it : (vlSERIES*) iterator from vl_series_open()
+  * @retval (ot_int) : bytes in the span at it->span, 0 at the end, or -1 if
+  *                    a file is not accessible
+  * @ingroup Veelite
+  *
+  * All of the files of the series are opened (and must be accessible), even 
+  * the ones outside the window.  A span never crosses a file.  Data in VSRAM
+  * (including mirrored ISFs), or in VWORM if VWORM_CONTIGUOUS is ENABLED, is
+  * given in place, so a span may be as long as the file.  Else, data in VWORM
+  * is copied into the iterator with vl_read_block(), up to VL_SPAN_BYTES at a
+  * time.  The span is valid until the next call.
+  */
+ot_int vl_series_next( vlSERIES* it );
+
+
+/** @brief Closes the files that an iterator has open
+  * @param it : (vlSERIES*) iterator from vl_series_open()
+  * @retval none
+  * @ingroup Veelite
+  */
+void vl_series_close( vlSERIES* it );
+
+
 //Compatibility definitions (deprecated)
 #define GFB_close(FP)                 vl_close(FP)
 #define ISF_close(FP)                 vl_close(FP)
@@ -534,10 +688,25 @@ ot_uint vl_checkalloc( vlFILE* fp );
   *
   * Only works on ISF files that are mirrored.  In certain implementations,
   * this function may do nothing at all.  It should really only be used by the
-  * root user.
+  * root user.  Only the mirror words that have been written since the last 
+  * sync (or load) are written back to VWORM.
   */
 ot_u8 ISF_syncmirror( );
 
+/** @brief Syncs some of the written mirror words back to main ISF file data
+  * @param limit : (ot_uint) maximum number of words to write to VWORM
+  * @retval ot_uint : number of written mirror words that are still not synced
+  * @ingroup Veelite
+  *
+  * This is ISF_syncmirror() in steps.  With OT_FEATURE(VLSYNC), the kernel
+  * calls it when it is idle, with a limit of ISF_MIRROR_STEP_WORDS, until it
+  * returns 0.  Then the sync before sleep has nothing left to do.
+  */
+#ifndef ISF_MIRROR_STEP_WORDS
+#   define ISF_MIRROR_STEP_WORDS    8
+#endif
+ot_uint ISF_syncmirror_step(ot_uint limit);
+
 /** @brief loads file data from vworm to data in the mirror
   * @param none
   * @retval ot_u8 : Non-zero on failure
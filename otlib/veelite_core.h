@@ -229,9 +229,19 @@ ot_u8 vworm_mark_physical(ot_u16* addr, ot_u16 value);
   *
   * @note Data in VWORM, in most cases, is NOT contiguous.  This function is
   *       here "just because."  Besides, it is useful for debugging.
+  *
+  * A core that maps VWORM contiguously (the POSIX core) does implement it, 
+  * and its platform config can set VWORM_CONTIGUOUS to ENABLED.  Veelite then
+  * copies VWORM file data with platform_memcpy() from vworm_get(), instead of
+  * a word at a time.  The MCU cores don't implement it, so the default is 
+  * DISABLED.
   */
 ot_u8* vworm_get(vaddr addr);
 
+#ifndef VWORM_CONTIGUOUS
+#   define VWORM_CONTIGUOUS     DISABLED
+#endif
+
 
 
 /** @brief Debugging function that prints out the state of the block table
@@ -255,6 +265,19 @@ ot_u8 vworm_wipeblock(vaddr addr, ot_uint wipe_span);
 //ot_u8 vworm_wipeblock_physical(ot_u8* addr, ot_uint wipe_span);
 
 
+/** @brief Does one step of journal maintenance in VWORM, for idle time
+  * @param none
+  * @retval ot_bool : True if a step was done, False if there was nothing to do
+  * @ingroup Veelite
+  *
+  * Only for cores with a write journal (OT_FEATURE_VLJOURNAL).  Once the
+  * journal is half full, each call merges one block with its journal records,
+  * or, if all are merged, moves the journal onto a fresh page.  Each step
+  * erases one page, so run it when there is time for that.
+  */
+ot_bool vworm_journal_step();
+
+
 
 
 
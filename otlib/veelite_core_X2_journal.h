@@ -0,0 +1,421 @@
+/* Copyright 2026 OpenTag contributors
+  *
+  * Licensed under the OpenTag License, Version 1.0 (the "License");
+  * you may not use this file except in compliance with the License.
+  * You may obtain a copy of the License at
+  *
+  * http://www.indigresso.com/wiki/doku.php?id=opentag:license_1_0
+  *
+  * Unless required by applicable law or agreed to in writing, software
+  * distributed under the License is distributed on an "AS IS" BASIS,
+  * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  * See the License for the specific language governing permissions and
+  * limitations under the License.
+  *
+  */
+/**
+  * @file       /OTlib/veelite_core_X2_journal.h
+  * @author     OpenTag contributors
+  * @version    V1.0
+  * @date       16 October 2026
+  * @brief      Write journal for the X2 Veelite Cores
+  * @ingroup    Veelite
+  *
+  * Journal Design Notes:
+  * With OT_FEATURE_VLJOURNAL, a write that cannot be done in place is appended
+  * to a journal of (vaddr, value) records, instead of attaching an ancillary
+  * block or recombining.  Blocks that have records in the journal are merged
+  * into a fallow block in idle time (vworm_journal_step()), one at a time, and
+  * each merge logs the new block position in the journal.  When the journal
+  * page gets full, it is compacted onto the other journal page.  vworm_init()
+  * rebuilds the X2table by replaying the journal, so a write is safe as soon
+  * as vworm_write() returns, and vworm_save() does nothing.  The journal uses
+  * two pages after the fallow pages (VWORM_JOURNAL_ADDR), which must also be
+  * reserved for the filesystem.  Format the filesystem when changing modes.
+  *
+  * The journal is the same on every X2 core, so it is kept here and not in the
+  * cores.  It only uses what the cores already have: the X2table, PTR_OFFSET(),
+  * NAND_erase_page(), NAND_write_short() and vworm_mark_physical().
+  *
+  * Only the X2 Veelite Cores should include this file, after their X2table.
+  ******************************************************************************
+  */
+
+#ifndef __VEELITE_CORE_X2_JOURNAL_H
+#define __VEELITE_CORE_X2_JOURNAL_H
+
+
+
+/** Write Journal <BR>
+  * ========================================================================<BR>
+  * The journal page starts with a header word (sequence number), then the
+  * JOURNAL_MAGIC word.  Each record after that is two words: vaddr, value.
+  * The value is written first and the vaddr last, so a record only counts once
+  * its vaddr is written.  Records with vaddr JOURNAL_TABLE give the position
+  * of a block, as (block index << 8) | (physical page index).  The header is
+  * written after everything else on a new page, and then the old page can be
+  * erased: of two valid pages, the one with the next sequence number is used.
+  */
+#if ((VWORM_SIZE > 0) && (OT_FEATURE(VLJOURNAL) == ENABLED))
+#   ifndef VWORM_JOURNAL_ADDR
+#       define VWORM_JOURNAL_ADDR   (OTF_VWORM_START_ADDR + \
+                                    (VWORM_PAGESIZE*(VWORM_PRIMARY_PAGES+VWORM_FALLOW_PAGES)))
+#   endif
+#   define JOURNAL_PAGE(NUM)        PTR_OFFSET(VWORM_JOURNAL_ADDR, ((NUM)*VWORM_PAGESIZE))
+#   define JOURNAL_MAGIC            0x4A56
+#   define JOURNAL_TABLE            0xFFFE
+#   define JOURNAL_SLOTS            (VWORM_PAGESIZE/4)
+#   define JOURNAL_RESERVE          (VWORM_PRIMARY_PAGES+1)
+#   define JOURNAL_MERGELEVEL       (JOURNAL_SLOTS/2)
+#   define JOURNAL_NEXTSEQ(SEQ)     (((SEQ)+1) & 0x7FFF)
+#   define JOURNAL_PENDING(BLOCK)   (X2journal.pending[(BLOCK)>>3] & (1<<((BLOCK)&7)))
+
+#   if (JOURNAL_SLOTS < ((VWORM_PRIMARY_PAGES*2) + 8))
+#       error "The Veelite journal needs larger pages or fewer primary pages."
+#   endif
+
+/** @typedef X2_journal
+  * RAM state of the journal: the active page, its sequence number, the next
+  * free record slot, and a bit for each block that has records in the journal
+  * since its last merge.
+  */
+typedef struct {
+    ot_u16* page;
+    ot_u16  seq;
+    ot_int  tail;
+    ot_u8   pending[(VWORM_PRIMARY_PAGES+7)/8];
+} X2_journal;
+
+X2_journal X2journal;
+
+
+
+/** Journal Subroutine Prototypes <BR>
+  * ========================================================================<BR>
+  */
+/** @brief Returns the journaled value of a vaddr, if the journal has one
+  * @param addr         (vaddr) virtual address of the word
+  * @retval ot_u16*     physical pointer to the newest value, or NULL
+  */
+ot_u16* sub_journal_find(vaddr addr);
+
+/** @brief Appends a write to the journal, compacting it first if it is full
+  * @param addr         (vaddr) virtual address of the word
+  * @param data         (ot_u16) value to write
+  * @retval ot_u8       0 on success
+  */
+ot_u8 sub_journal_write(vaddr addr, ot_u16 data);
+
+/** @brief Merges a block with its journal records, into a fallow block
+  * @param block        (ot_int) index of the block in the X2table
+  * @retval none
+  */
+void sub_journal_merge(ot_int block);
+
+/** @brief Merges all blocks and moves the journal onto its other page
+  * @param none
+  * @retval none
+  */
+void sub_journal_compact();
+
+/** @brief Builds the X2table from the journal, or starts a new journal
+  * @param none
+  * @retval ot_u8       0 on success
+  */
+ot_u8 sub_journal_init();
+
+
+
+/// Physical page index of a page pointer, for JOURNAL_TABLE records
+#define PAGE_INDEX(PTR)     (ot_u16)(((ot_u8*)(PTR) - (ot_u8*)(OTF_VWORM_START_ADDR)) >> VWORM_PAGESHIFT)
+
+ot_u8 sub_journal_put(ot_u16 addr, ot_u16 data) {
+    ot_u16* r_ptr;
+    ot_u8   test;
+
+    r_ptr   = &X2journal.page[X2journal.tail << 1];
+    test    = NAND_write_short(&r_ptr[1], data);
+    test   |= NAND_write_short(&r_ptr[0], addr);
+    X2journal.tail++;
+
+    return test;
+}
+
+
+
+ot_u8 sub_journal_start() {
+    ot_u8   test;
+    ot_int  i;
+
+    /// Log the position of every block, then write the header, which makes
+    /// the page valid.
+    test            = NAND_erase_page(X2journal.page);
+    X2journal.tail  = 1;
+    for (i=0; i<VWORM_PRIMARY_PAGES; i++) {
+        test |= sub_journal_put(JOURNAL_TABLE, (i << 8) | PAGE_INDEX(X2table.block[i].primary));
+    }
+    test |= NAND_write_short(&X2journal.page[1], JOURNAL_MAGIC);
+    test |= NAND_write_short(&X2journal.page[0], X2journal.seq);
+
+    return test;
+}
+
+
+
+ot_bool sub_page_isblank(ot_u16* page) {
+    ot_int i;
+    for (i=0; i<(VWORM_PAGESIZE/2); i++) {
+        if (page[i] != 0xFFFF) {
+            return False;
+        }
+    }
+    return True;
+}
+
+
+
+ot_u16* sub_journal_find(vaddr addr) {
+    ot_u16* r_ptr;
+    ot_int  block;
+    ot_int  i;
+
+    addr   &= ~1;
+    block   = (addr-VWORM_BASE_VADDR) >> VWORM_PAGESHIFT;
+
+    /// Search back from the newest record, until the last merge of the block
+    for (i=(X2journal.tail-1); i>0; i--) {
+        r_ptr = &X2journal.page[i << 1];
+        if (r_ptr[0] == addr) {
+            return &r_ptr[1];
+        }
+        if ((r_ptr[0] == JOURNAL_TABLE) && ((r_ptr[1] >> 8) == block)) {
+            break;
+        }
+    }
+    return NULL;
+}
+
+
+
+ot_u8 sub_journal_write(vaddr addr, ot_u16 data) {
+    ot_int block;
+
+    /// The reserve leaves one record for each block that may need a merge
+    /// during compaction
+    if (X2journal.tail >= (JOURNAL_SLOTS-JOURNAL_RESERVE)) {
+        sub_journal_compact();
+    }
+
+    addr   &= ~1;
+    block   = (addr-VWORM_BASE_VADDR) >> VWORM_PAGESHIFT;
+    X2journal.pending[block>>3] |= (1 << (block&7));
+
+    return sub_journal_put(addr, data);
+}
+
+
+
+void sub_journal_merge(ot_int block) {
+    ot_u8   done[VWORM_PAGESIZE/16];
+    ot_u16* old_ptr;
+    ot_u16* new_ptr;
+    ot_u16* r_ptr;
+    ot_int  i;
+    ot_int  word;
+    vaddr   base;
+
+    old_ptr = X2table.block[block].primary;
+    new_ptr = X2table.fallow[(VWORM_FALLOW_PAGES-1)];
+    base    = VWORM_BASE_VADDR + (block << VWORM_PAGESHIFT);
+    for (i=0; i<(VWORM_PAGESIZE/16); i++) {
+        done[i] = 0;
+    }
+
+    /// 1. Write the newest journal record of each word into the fallow block
+    for (i=(X2journal.tail-1); i>0; i--) {
+        r_ptr = &X2journal.page[i << 1];
+        if (r_ptr[0] == JOURNAL_TABLE) {
+            if ((r_ptr[1] >> 8) == block) {
+                break;
+            }
+        }
+        else if ((r_ptr[0] >= base) && (r_ptr[0] < (base+VWORM_PAGESIZE))) {
+            word = (r_ptr[0] - base) >> 1;
+            if ((done[word>>3] & (1 << (word&7))) == 0) {
+                done[word>>3] |= (1 << (word&7));
+                if (r_ptr[1] != 0xFFFF) {
+                    vworm_mark_physical(&new_ptr[word], r_ptr[1]);
+                }
+            }
+        }
+    }
+
+    /// 2. Copy the other words from the old block
+    for (word=0; word<(VWORM_PAGESIZE/2); word++) {
+        if (((done[word>>3] & (1 << (word&7))) == 0) && (old_ptr[word] != 0xFFFF)) {
+            vworm_mark_physical(&new_ptr[word], old_ptr[word]);
+        }
+    }
+
+    /// 3. Log the new position of the block.  After this, the old block is
+    ///    garbage, and vworm_init() will erase it if the erase is interrupted.
+    sub_journal_put(JOURNAL_TABLE, (block << 8) | PAGE_INDEX(new_ptr));
+
+    /// 4. Erase the old block and put it at the bottom of the fallows
+    NAND_erase_page(old_ptr);
+    for (i=(VWORM_FALLOW_PAGES-1); i>0; i--) {
+        X2table.fallow[i] = X2table.fallow[i-1];
+    }
+    X2table.fallow[0]               = old_ptr;
+    X2table.block[block].primary    = new_ptr;
+    X2journal.pending[block>>3]    &= ~(1 << (block&7));
+}
+
+
+
+void sub_journal_compact() {
+    ot_u16* old_page;
+    ot_int  i;
+
+    /// 1. Merge every block that has records in the journal
+    for (i=0; i<VWORM_PRIMARY_PAGES; i++) {
+        if (JOURNAL_PENDING(i)) {
+            sub_journal_merge(i);
+        }
+    }
+
+    /// 2. Start the other journal page, and then erase the old one
+    old_page        = X2journal.page;
+    X2journal.page  = (old_page == JOURNAL_PAGE(0)) ? JOURNAL_PAGE(1) : JOURNAL_PAGE(0);
+    X2journal.seq   = JOURNAL_NEXTSEQ(X2journal.seq);
+    sub_journal_start();
+    NAND_erase_page(old_page);
+}
+
+
+
+ot_u8 sub_journal_init() {
+    ot_u8   test = 0;
+    ot_u16* cursor;
+    ot_u16* r_ptr;
+    ot_int  i;
+    ot_int  j;
+
+    /// 1. Start from the initial block positions, with nothing journaled
+    cursor = (ot_u16*)(OTF_VWORM_START_ADDR);
+    for (i=0; i<VWORM_PRIMARY_PAGES; i++) {
+        X2table.block[i].primary    = cursor;
+        X2table.block[i].ancillary  = NULL;
+        cursor = PTR_OFFSET(cursor, VWORM_PAGESIZE);
+    }
+    for (i=0; i<(ot_int)sizeof(X2journal.pending); i++) {
+        X2journal.pending[i] = 0;
+    }
+
+    /// 2. Find the valid journal page.  If both are valid, a compaction was
+    ///    interrupted after the new page was done.
+    X2journal.page = NULL;
+    for (i=0; i<2; i++) {
+        r_ptr = JOURNAL_PAGE(i);
+        if ((r_ptr[1] == JOURNAL_MAGIC) && (r_ptr[0] != 0xFFFF)) {
+            if ((X2journal.page == NULL) || (r_ptr[0] == JOURNAL_NEXTSEQ(X2journal.page[0]))) {
+                X2journal.page = r_ptr;
+            }
+        }
+    }
+
+    /// 3. No journal (e.g. after format): start one on the first page
+    if (X2journal.page == NULL) {
+        X2journal.page  = JOURNAL_PAGE(0);
+        X2journal.seq   = 0;
+        test           |= NAND_erase_page(JOURNAL_PAGE(1));
+        test           |= sub_journal_start();
+    }
+
+    /// 4. Replay the journal.  The tail follows the last record that has any
+    ///    data, so a record that was interrupted is never written over.
+    else {
+        X2journal.seq   = X2journal.page[0];
+        X2journal.tail  = 1;
+        for (i=1; i<JOURNAL_SLOTS; i++) {
+            r_ptr = &X2journal.page[i << 1];
+            if (r_ptr[0] == JOURNAL_TABLE) {
+                j = r_ptr[1] >> 8;
+                if (j < VWORM_PRIMARY_PAGES) {
+                    X2table.block[j].primary = PTR_OFFSET(OTF_VWORM_START_ADDR, \
+                                                ((ot_u32)(r_ptr[1] & 0xFF) << VWORM_PAGESHIFT));
+                    X2journal.pending[j>>3] &= ~(1 << (j&7));
+                }
+            }
+            else if (r_ptr[0] != 0xFFFF) {
+                j = (r_ptr[0]-VWORM_BASE_VADDR) >> VWORM_PAGESHIFT;
+                if (j < VWORM_PRIMARY_PAGES) {
+                    X2journal.pending[j>>3] |= (1 << (j&7));
+                }
+            }
+            if ((r_ptr[0] & r_ptr[1]) != 0xFFFF) {
+                X2journal.tail = i+1;
+            }
+        }
+
+        /// Erase the other page if a compaction left anything on it
+        r_ptr = (X2journal.page == JOURNAL_PAGE(0)) ? JOURNAL_PAGE(1) : JOURNAL_PAGE(0);
+        if (sub_page_isblank(r_ptr) == False) {
+            test |= NAND_erase_page(r_ptr);
+        }
+    }
+
+    /// 5. Every other page is a fallow.  A fallow might not be blank, if a
+    ///    merge was interrupted, so erase it if needed.
+    cursor  = (ot_u16*)(OTF_VWORM_START_ADDR);
+    j       = 0;
+    for (i=0; i<(VWORM_PRIMARY_PAGES+VWORM_FALLOW_PAGES); i++) {
+        ot_int k;
+        for (k=0; (k<VWORM_PRIMARY_PAGES) && (X2table.block[k].primary != cursor); k++);
+        if (k == VWORM_PRIMARY_PAGES) {
+            if (j < VWORM_FALLOW_PAGES) {
+                X2table.fallow[j++] = cursor;
+            }
+            if (sub_page_isblank(cursor) == False) {
+                test |= NAND_erase_page(cursor);
+            }
+        }
+        cursor = PTR_OFFSET(cursor, VWORM_PAGESIZE);
+    }
+
+    return test;
+}
+#endif
+
+
+
+
+#ifndef EXTF_vworm_journal_step
+ot_bool vworm_journal_step() {
+#if ((VWORM_SIZE > 0) && (OT_FEATURE(VLNVWRITE) == ENABLED) && (OT_FEATURE(VLJOURNAL) == ENABLED))
+    ot_int i;
+
+    /// 1. Nothing to do until the journal page is half full
+    if (X2journal.tail < JOURNAL_MERGELEVEL) {
+        return False;
+    }
+
+    /// 2. Merge one block that has records in the journal
+    for (i=0; i<VWORM_PRIMARY_PAGES; i++) {
+        if (JOURNAL_PENDING(i)) {
+            sub_journal_merge(i);
+            return True;
+        }
+    }
+
+    /// 3. All blocks are merged, so move the journal onto its other page
+    sub_journal_compact();
+    return True;
+#else
+    return False;
+#endif
+}
+#endif
+
+
+#endif
@@ -42,6 +42,10 @@
   * device's SRAM shuts off.  In most types of devices (anything without a user
   * removable battery) this is not a big problem.
   *
+  * Journal Design Notes:
+  * With OT_FEATURE_VLJOURNAL, writes that cannot be done in place go to a
+  * write journal, which is shared by the X2 cores (see veelite_core_X2_journal.h).
+  *
   *
   * Compatibility Notes:
   * As far as I know, this module works with every FLASH controller that uses
@@ -68,6 +72,9 @@
 #ifndef OT_FEATURE_VLNVWRITE
 #   define OT_FEATURE_VLNVWRITE ENABLED
 #endif
+#ifndef OT_FEATURE_VLJOURNAL
+#   define OT_FEATURE_VLJOURNAL DISABLED
+#endif
 
 
 
@@ -230,6 +237,15 @@ void sub_attach_fallow(block_ptr* block_in);
 
 
 
+/** Write Journal <BR>
+  * ========================================================================<BR>
+  * With OT_FEATURE_VLJOURNAL, this includes the journal that is shared by the
+  * X2 cores.  Otherwise, it only provides vworm_journal_step().
+  */
+#include "veelite_core_X2_journal.h"
+
+
+
 
 
 
@@ -281,6 +297,13 @@ ot_u8 vworm_format( ) {
         cursor  = PTR_OFFSET(cursor, VWORM_PAGESIZE);
     }
 
+    /// 3. With the journal, erase the journal pages and start a new journal
+#   if (OT_FEATURE_VLJOURNAL == ENABLED)
+        output |= NAND_erase_page(JOURNAL_PAGE(0));
+        output |= NAND_erase_page(JOURNAL_PAGE(1));
+        output |= sub_journal_init();
+#   endif
+
     return output;
 #else
     return 0;
@@ -321,6 +344,12 @@ ot_u8 vworm_init( ) {
     }
 #endif /* (CC_SUPPORT == GCC) */
 
+    /// 0. With the journal, the X2table comes from the journal.  The last page
+    ///    is not used for saving the table.
+#   if (OT_FEATURE_VLJOURNAL == ENABLED)
+        return sub_journal_init();
+#   endif
+
     s_ptr = (ot_u16*)(VWORM_BASE_PHYSICAL + (VWORM_PAGESIZE*(VWORM_NUM_PAGES-1)));
 
     /// 1. If the last block starts with FFFF, assume that a format just
@@ -371,8 +400,8 @@ void vworm_print_table() {
 //
 //    printf("VWORM X2table: Primaries\n");
 //    for (i=0; i<VWORM_PRIMARY_PAGES; i++) {
-//        printf("%02d: %08X - %08X\n", i, \
-//            (unsigned int)X2table.block[i].primary, \
+//        printf("%02d: %08X - %08X\n", i,
+//            (unsigned int)X2table.block[i].primary,
 //            (unsigned int)X2table.block[i].ancillary);
 //    }
 //
@@ -388,6 +417,11 @@ void vworm_print_table() {
 ot_u8 vworm_save( ) {
 #if ((VWORM_SIZE > 0) && (OT_FEATURE_VLNVWRITE == ENABLED))
     /// @note init & save processes have not been tested enough.
+#   if (OT_FEATURE_VLJOURNAL == ENABLED)
+        /// With the journal, the X2table can always be rebuilt from the journal
+        return 0;
+#   endif
+
     /// Saves the state of the vworm onto the last physical block, which may
     /// require recombination before being able to be used.
 
@@ -447,7 +481,17 @@ ot_u16 vworm_read(vaddr addr) {
     index   = (addr-VWORM_BASE_VADDR) >> VWORM_PAGESHIFT;
     p_ptr   = PTR_OFFSET(X2table.block[index].primary, offset);
 
-    /// 2. return either the primary pointer in full or the XNOR
+#   if (OT_FEATURE_VLJOURNAL == ENABLED)
+    /// 2. If the block has records in the journal, the newest one is the data
+    if (JOURNAL_PENDING(index)) {
+        a_ptr = sub_journal_find(addr);
+        if (a_ptr != NULL) {
+            return *a_ptr;
+        }
+    }
+#   endif
+
+    /// 3. return either the primary pointer in full or the XNOR
     if (X2table.block[index].ancillary == NULL) {
         return *p_ptr;
     }
@@ -466,9 +510,11 @@ ot_u8 vworm_write(vaddr addr, ot_u16 data) {
 #if ((VWORM_SIZE > 0) && (OT_FEATURE_VLNVWRITE == ENABLED))
     ot_int  index;
     ot_int  offset;
-    ot_u16  wrtest;
     ot_u16* p_ptr;
+#   if (OT_FEATURE_VLJOURNAL != ENABLED)
+    ot_u16  wrtest;
     ot_u16* a_ptr;
+#   endif
 
     SEGFAULT_CHECK(addr, in_vworm, 7, "VLC_445");   //__LINE__
 
@@ -477,6 +523,16 @@ ot_u8 vworm_write(vaddr addr, ot_u16 data) {
     index   = (addr-VWORM_BASE_VADDR) >> VWORM_PAGESHIFT;
     p_ptr   = PTR_OFFSET(X2table.block[index].primary, offset);
 
+#   if (OT_FEATURE_VLJOURNAL == ENABLED)
+    /// 2. With the journal, write in place if the block has nothing in the
+    ///    journal and there is no 0->1 write requirement.  Otherwise, journal
+    ///    the write.  In journal mode blocks never have an ancillary.
+    if ((JOURNAL_PENDING(index) == 0) && ((data & ~(*p_ptr)) == 0)) {
+        return vworm_mark_physical(p_ptr, data);
+    }
+    return sub_journal_write(addr, data);
+
+#   else
     /// 2. No ancillary block, but try a write anyway
     if (X2table.block[index].ancillary == NULL) {
 
@@ -520,6 +576,7 @@ ot_u8 vworm_write(vaddr addr, ot_u16 data) {
         p_ptr = sub_recombine_block(&X2table.block[index], offset, 2);
         return vworm_mark_physical(p_ptr, data);
     }
+#   endif
 #else
     return 0;
 #endif
@@ -535,8 +592,8 @@ ot_u8 vworm_mark(vaddr addr, ot_u16 value) {
 
 ot_u8 vworm_mark_physical(ot_u16* addr, ot_u16 value) {
 #if ((VWORM_SIZE > 0) && (OT_FEATURE_VLNVWRITE == ENABLED))
-    BUSERROR_CHECK( (((ot_u16)addr < VWORM_BASE_PHYSICAL) || \
-                    ((ot_u16)addr >= (VWORM_BASE_PHYSICAL+VWORM_ALLOC))), 7, "VLC_511");    //__LINE__
+    BUSERROR_CHECK( ((addr < (ot_u16*)VWORM_BASE_PHYSICAL) || \
+                    (addr >= (ot_u16*)(VWORM_BASE_PHYSICAL+VWORM_ALLOC))), 7, "VLC_511");    //__LINE__
 
     return NAND_write_short(addr, value);
 #else
@@ -565,6 +622,9 @@ ot_u8 vworm_wipeblock(vaddr addr, ot_uint wipe_span) {
 
 
 
+
+
+
 /** VSRAM Functions <BR>
   * ========================================================================<BR>
   */
@@ -42,6 +42,10 @@
   * device's SRAM shuts off.  In most types of devices (anything without a user
   * removable battery) this is not a big problem.
   *
+  * Journal Design Notes:
+  * With OT_FEATURE_VLJOURNAL, writes that cannot be done in place go to a
+  * write journal, which is shared by the X2 cores (see veelite_core_X2_journal.h).
+  *
   *
   * Compatibility Notes:
   * As far as I know, this module works with every FLASH controller that uses
@@ -63,6 +67,9 @@
 #ifndef OT_FEATURE_VLNVWRITE
 #   define OT_FEATURE_VLNVWRITE ENABLED
 #endif
+#ifndef OT_FEATURE_VLJOURNAL
+#   define OT_FEATURE_VLJOURNAL DISABLED
+#endif
 
 
 
@@ -225,6 +232,15 @@ void sub_attach_fallow(block_ptr* block_in);
 
 
 
+/** Write Journal <BR>
+  * ========================================================================<BR>
+  * With OT_FEATURE_VLJOURNAL, this includes the journal that is shared by the
+  * X2 cores.  Otherwise, it only provides vworm_journal_step().
+  */
+#include "veelite_core_X2_journal.h"
+
+
+
 
 
 
@@ -296,6 +312,13 @@ ot_u8 vworm_format( ) {
         cursor  = PTR_OFFSET(cursor, VWORM_PAGESIZE);
     }
 
+    /// 3. With the journal, erase the journal pages and start a new journal
+#   if (OT_FEATURE(VLJOURNAL) == ENABLED)
+        output |= NAND_erase_page(JOURNAL_PAGE(0));
+        output |= NAND_erase_page(JOURNAL_PAGE(1));
+        output |= sub_journal_init();
+#   endif
+
     return output;
 #else
     return 0;
@@ -329,6 +352,12 @@ ot_u8 vworm_init( ) {
         }
 #   endif
 
+    /// 0. With the journal, the X2table comes from the journal.  The last page
+    ///    is not used for saving the table.
+#   if (OT_FEATURE(VLJOURNAL) == ENABLED)
+        return sub_journal_init();
+#   endif
+
     s_ptr = (ot_u16*)(VWORM_BASE_PHYSICAL + (VWORM_PAGESIZE*(VWORM_NUM_PAGES-1)));
 
     /// 1. If the last block starts with FFFF, assume that a format just
@@ -400,6 +429,11 @@ void vworm_print_table() {
 ot_u8 vworm_save( ) {
 #if ((VWORM_SIZE > 0) && (OT_FEATURE_VLNVWRITE == ENABLED))
     /// @note init & save processes have not been tested enough.
+#   if (OT_FEATURE(VLJOURNAL) == ENABLED)
+        /// With the journal, the X2table can always be rebuilt from the journal
+        return 0;
+#   endif
+
     /// Saves the state of the vworm onto the last physical block, which may
     /// require recombination before being able to be used.
 
@@ -461,7 +495,17 @@ ot_u16 vworm_read(vaddr addr) {
     index   = (addr-VWORM_BASE_VADDR) >> VWORM_PAGESHIFT;
     p_ptr   = PTR_OFFSET(X2table.block[index].primary, offset);
 
-    /// 2. return either the primary pointer in full or the XNOR
+#   if (OT_FEATURE(VLJOURNAL) == ENABLED)
+    /// 2. If the block has records in the journal, the newest one is the data
+    if (JOURNAL_PENDING(index)) {
+        a_ptr = sub_journal_find(addr);
+        if (a_ptr != NULL) {
+            return *a_ptr;
+        }
+    }
+#   endif
+
+    /// 3. return either the primary pointer in full or the XNOR
     if (X2table.block[index].ancillary == NULL) {
         return *p_ptr;
     }
@@ -486,9 +530,11 @@ ot_u8 vworm_write(vaddr addr, ot_u16 data) {
 #if ((VWORM_SIZE > 0) && (OT_FEATURE_VLNVWRITE == ENABLED))
     ot_int  index;
     ot_int  offset;
-    ot_u16  wrtest;
     ot_u16* p_ptr;
+#   if (OT_FEATURE(VLJOURNAL) != ENABLED)
+    ot_u16  wrtest;
     ot_u16* a_ptr;
+#   endif
 
     SEGFAULT_CHECK(addr, in_vworm, 7, "VLC_493");   //__LINE__
 
@@ -497,6 +543,16 @@ ot_u8 vworm_write(vaddr addr, ot_u16 data) {
     index   = (addr-VWORM_BASE_VADDR) >> VWORM_PAGESHIFT;
     p_ptr   = PTR_OFFSET(X2table.block[index].primary, offset);
 
+#   if (OT_FEATURE(VLJOURNAL) == ENABLED)
+    /// 2. With the journal, write in place if the block has nothing in the
+    ///    journal and there is no 0->1 write requirement.  Otherwise, journal
+    ///    the write.  In journal mode blocks never have an ancillary.
+    if ((JOURNAL_PENDING(index) == 0) && ((data & ~(*p_ptr)) == 0)) {
+        return vworm_mark_physical(p_ptr, data);
+    }
+    return sub_journal_write(addr, data);
+
+#   else
     /// 2. No ancillary block, but try a write anyway
     if (X2table.block[index].ancillary == NULL) {
 
@@ -540,6 +596,7 @@ ot_u8 vworm_write(vaddr addr, ot_u16 data) {
         p_ptr = sub_recombine_block(&X2table.block[index], offset, 2);
         return vworm_mark_physical(p_ptr, data);
     }
+#   endif
 #else
     return 0;
 #endif
@@ -591,6 +648,9 @@ ot_u8 vworm_wipeblock(vaddr addr, ot_uint wipe_span) {
 
 
 
+
+
+
 /** VSRAM Functions <BR>
   * ========================================================================<BR>
   */
@@ -0,0 +1,446 @@
+/* Copyright 2026 OpenTag contributors
+  *
+  * Licensed under the OpenTag License, Version 1.0 (the "License");
+  * you may not use this file except in compliance with the License.
+  * You may obtain a copy of the License at
+  *
+  * http://www.indigresso.com/wiki/doku.php?id=opentag:license_1_0
+  *
+  * Unless required by applicable law or agreed to in writing, software
+  * distributed under the License is distributed on an "AS IS" BASIS,
+  * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  * See the License for the specific language governing permissions and
+  * limitations under the License.
+  *
+  */
+/**
+  * @file       /OTplatform/posix/veelite_core_posix.c
+  * @author     OpenTag contributors
+  * @version    V1.0
+  * @date       16 October 2026
+  * @brief      Memory-mapped Veelite Core for POSIX
+  * @ingroup    Veelite
+  *
+  * Summary:
+  * This module is part of the Veelite Core, which contains the low-level read
+  * and write filesystem functionality.  This variant is for POSIX hosts, like
+  * gateways and simulators, which have a real filesystem instead of Flash.
+  * VWORM is an image file that is mapped into memory with mmap().
+  *
+  * Design Notes:
+  * vworm_init() maps the image, so startup takes the same time whatever the
+  * size of the image, and nothing is loaded until it is used.  Writes go
+  * straight into the mapping, and vworm_save() flushes it to the file with
+  * msync().  Unlike Flash, any bit can be written either way, so there is no
+  * wear leveling and no fallow pages, and the data is contiguous: vworm_get()
+  * returns a pointer that can be used directly.  Set VWORM_CONTIGUOUS to 
+  * ENABLED in the platform config, so Veelite copies file data from it in one
+  * go.  VSRAM (the ISF mirror) is volatile on every platform, so it is in 
+  * process memory here, too.
+  *
+  * Image File:
+  * The path comes from vworm_image, the OT_VWORM_IMAGE environment variable,
+  * or VWORM_IMAGE_FILE (see veelite_core_posix.h).  If the file does not exist
+  * it is created erased (0xFF, like new Flash) and the stock files are copied
+  * into it.  The new image is built in a temporary file and renamed into place
+  * when it is complete, so a crash during startup leaves either no image or a
+  * whole one, never a partial image that would be mapped as-is next time.
+  *
+  * MCU builds get the stock files from the linker, which places the arrays
+  * from the app's data file, and the rest of each bank stays erased.
+  * The lengths of those arrays are not known here, so the platform config must
+  * give them (in bytes) as OVERHEAD_STOCK_BYTES, ISFS_STOCK_BYTES,
+  * GFB_STOCK_BYTES and ISF_STOCK_BYTES.  A bank with no length is left erased.
+  * An existing image is never reloaded from the stock files, so delete the
+  * image to go back to them.
+  *
+  * Page Geometry:
+  * FLASH_PAGE_SIZE, FLASH_NUM_PAGES and FLASH_FS_FALLOWS only size the image
+  * (primary pages x page size).  If the platform config does not give them,
+  * the image just covers the filesystem.
+  ******************************************************************************
+  */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "OT_types.h"
+#include "OT_config.h"
+#include "OT_platform.h"
+#include "veelite_core.h"
+#include "veelite_core_posix.h"
+
+
+#ifndef FLASH_FS_ADDR
+#   define FLASH_FS_ADDR        0
+#endif
+#ifndef FLASH_PAGE_SIZE
+#   define FLASH_PAGE_SIZE      512
+#endif
+#ifndef FLASH_FS_FALLOWS
+#   define FLASH_FS_FALLOWS     0
+#endif
+#ifndef FLASH_NUM_PAGES
+#   define FLASH_NUM_PAGES      ( FLASH_FS_FALLOWS + \
+                                ((ISF_START_VADDR + ISF_TOTAL_BYTES + FLASH_PAGE_SIZE - 1) / FLASH_PAGE_SIZE) )
+#endif
+
+#define VWORM_IMAGE_BYTES       (VWORM_PRIMARY_PAGES * VWORM_PAGESIZE)
+
+#if ((ISF_START_VADDR + ISF_TOTAL_BYTES - VWORM_BASE_VADDR) > VWORM_IMAGE_BYTES)
+#   error "The VWORM image (FLASH_NUM_PAGES - FLASH_FS_FALLOWS pages) is smaller than the filesystem"
+#endif
+
+
+/// Image file path (see veelite_core_posix.h), the path that was used, and
+/// the mapping
+const char*         vworm_image = NULL;
+static const char*  vworm_path  = NULL;
+static ot_u8*       vworm_base  = NULL;
+
+/// VSRAM (Mirror) memory buffer
+#if (VSRAM_SIZE > 0)
+    ot_u16 vsram[ (VSRAM_SIZE/2) ];
+#endif
+
+/// Stock files from the app's data file (see "Image File", above)
+#ifdef OVERHEAD_STOCK_BYTES
+    extern const ot_u8 overhead_files[];
+#endif
+#ifdef ISFS_STOCK_BYTES
+    extern const ot_u8 isfs_stock_codes[];
+#endif
+#if ((GFB_TOTAL_BYTES > 0) && defined(GFB_STOCK_BYTES))
+    extern const ot_u8 gfb_stock_files[];
+#endif
+#ifdef ISF_STOCK_BYTES
+    extern const ot_u8 isf_stock_files[];
+#endif
+
+
+ot_u8 sub_build_image(const char* path);
+void sub_load_stock(ot_u8* image);
+
+
+
+
+
+
+/** Generic Veelite Core Function Implementations <BR>
+  * ========================================================================<BR>
+  * Used for any and all memory topologies
+  */
+
+vas_loc vas_check(vaddr addr) {
+    if ((addr >= VWORM_BASE_VADDR) && \
+        (addr < (VWORM_BASE_VADDR+VWORM_IMAGE_BYTES)) ) {
+        return in_vworm;
+    }
+    if ((addr >= VSRAM_BASE_VADDR) && \
+        (addr < (VSRAM_BASE_VADDR+VSRAM_SIZE)) ) {
+        return in_vsram;
+    }
+    return vas_error;
+}
+
+
+
+
+
+/** VWORM Functions <BR>
+  * ========================================================================<BR>
+  */
+
+ot_u8 vworm_format( ) {
+    if ((vworm_base == NULL) && (vworm_init() != 0)) {
+        return MEM_HW_FAULT;
+    }
+    memset(vworm_base, 0xFF, VWORM_IMAGE_BYTES);
+    return 0;
+}
+
+
+
+ot_u8 vworm_init( ) {
+    struct stat st;
+    const char* path;
+    void*       map;
+    int         fd;
+
+    if (vworm_base != NULL) {
+        return 0;
+    }
+
+    path = vworm_image;
+    if (path == NULL) {
+        path = getenv("OT_VWORM_IMAGE");
+    }
+    if (path == NULL) {
+        path = VWORM_IMAGE_FILE;
+    }
+
+    /// 1. Open the image.  If it does not exist, or it is too small to be
+    ///    mapped, a complete one is made first (see sub_build_image()).
+    fd = open(path, O_RDWR);
+    if ((fd >= 0) && ((fstat(fd, &st) != 0) || (st.st_size < VWORM_IMAGE_BYTES))) {
+        close(fd);
+        fd = -1;
+    }
+    if (fd < 0) {
+        if (sub_build_image(path) != 0) {
+            return MEM_HW_FAULT;
+        }
+        fd = open(path, O_RDWR);
+        if (fd < 0) {
+            return MEM_HW_FAULT;
+        }
+    }
+
+    /// 2. Map it.  The mapping stays valid after the descriptor is closed.
+    map = mmap(NULL, VWORM_IMAGE_BYTES, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return MEM_HW_FAULT;
+    }
+    vworm_base = (ot_u8*)map;
+    vworm_path = path;
+
+    return 0;
+}
+
+
+
+void vworm_print_table() {
+#ifdef DEBUG_ON
+    printf("VWORM image: %s, %d bytes mapped at %p\n",
+            (vworm_path != NULL) ? vworm_path : "(none)",
+            VWORM_IMAGE_BYTES, (void*)vworm_base);
+#endif
+}
+
+
+
+ot_u8 vworm_save( ) {
+    if (vworm_base == NULL) {
+        return 0;
+    }
+    return (msync(vworm_base, VWORM_IMAGE_BYTES, MS_SYNC) != 0) ? MEM_HW_FAULT : 0;
+}
+
+
+
+ot_u16 vworm_read(vaddr addr) {
+    if (vas_check(addr) != in_vworm) {
+        return NULL_vaddr;
+    }
+    addr = (addr - VWORM_BASE_VADDR) & ~1;
+    return *(ot_u16*)&vworm_base[addr];
+}
+
+
+
+ot_u8 vworm_write(vaddr addr, ot_u16 data) {
+    if (vas_check(addr) != in_vworm) {
+        return MEM_ADDR_FAULT;
+    }
+    addr -= VWORM_BASE_VADDR;
+
+    /// On an odd addr, only the byte at addr is written, which is the odd byte
+    /// of data (the UPPER byte of an OpenTag TwoBytes union).
+    if (addr & 1) {
+        Twobytes scratch;
+        scratch.ushort      = data;
+        vworm_base[addr]    = scratch.ubyte[1];
+    }
+    else {
+        *(ot_u16*)&vworm_base[addr] = data;
+    }
+    return 0;
+}
+
+
+
+ot_u8 vworm_mark(vaddr addr, ot_u16 value) {
+    return vworm_write(addr, value);
+}
+
+
+
+ot_u8 vworm_mark_physical(ot_u16* addr, ot_u16 value) {
+    if ( ((ot_u8*)addr < vworm_base) || \
+         ((ot_u8*)addr >= (vworm_base+VWORM_IMAGE_BYTES)) ) {
+        return MEM_ADDR_FAULT;
+    }
+    *addr = value;
+    return 0;
+}
+
+
+
+ot_u8* vworm_get(vaddr addr) {
+    if (vas_check(addr) != in_vworm) {
+        return NULL;
+    }
+    return &vworm_base[addr - VWORM_BASE_VADDR];
+}
+
+
+
+ot_u8 vworm_wipeblock(vaddr addr, ot_uint wipe_span) {
+    if ( (vas_check(addr) != in_vworm) || \
+         (wipe_span > (VWORM_BASE_VADDR + VWORM_IMAGE_BYTES - addr)) ) {
+        return MEM_ADDR_FAULT;
+    }
+    memset(&vworm_base[addr - VWORM_BASE_VADDR], 0xFF, wipe_span);
+    return 0;
+}
+
+
+
+
+
+/** VSRAM Functions <BR>
+  * ========================================================================<BR>
+  */
+
+ot_u16 vsram_read(vaddr addr) {
+#if (VSRAM_SIZE <= 0)
+    return 0;
+#else
+    addr -= VSRAM_BASE_VADDR;
+    addr >>= 1;
+    return vsram[addr];
+#endif
+}
+
+
+
+ot_u8 vsram_mark(vaddr addr, ot_u16 value) {
+#if (VSRAM_SIZE <= 0)
+    return ~0;
+#else
+    addr -= VSRAM_BASE_VADDR;
+    addr >>= 1;
+    vsram[addr] = value;
+    return 0;
+#endif
+}
+
+
+
+ot_u8 vsram_mark_physical(ot_u16* addr, ot_u16 value) {
+#if (VSRAM_SIZE <= 0)
+    return ~0;
+#else
+    *addr = value;
+    return 0;
+#endif
+}
+
+
+
+ot_u8* vsram_get(vaddr addr) {
+#if (VSRAM_SIZE <= 0)
+    return NULL;
+#else
+    ot_u8* output;
+    addr   -= VSRAM_BASE_VADDR;
+    output  = (ot_u8*)vsram + addr;
+    return output;
+#endif
+}
+
+
+
+
+
+
+/** Subroutine Implementations <BR>
+  * ========================================================================<BR>
+  */
+
+#define STOCK_PTR(VADDR)    &image[(VADDR) - VWORM_BASE_VADDR]
+
+ot_u8 sub_build_image(const char* path) {
+/// Makes a complete image at path, so that a crash can never leave a new or
+/// half-grown image there.  The image is built in a temporary file next to it
+/// (same filesystem), flushed, and then renamed into place, which replaces
+/// the old file (if any) in one step.  An old image that is too small keeps
+/// its data, and the rest is erased.  A new image is erased and gets the
+/// stock files.
+    struct stat st;
+    char*       tmp_path;
+    ot_u8*      image;
+    void*       map;
+    int         tmp_fd;
+    int         fd;
+    ot_u8       result = MEM_HW_FAULT;
+
+    tmp_path = malloc(strlen(path) + 8);
+    if (tmp_path == NULL) {
+        return MEM_HW_FAULT;
+    }
+    sprintf(tmp_path, "%s.XXXXXX", path);
+    tmp_fd = mkstemp(tmp_path);
+    if (tmp_fd < 0) {
+        free(tmp_path);
+        return MEM_HW_FAULT;
+    }
+    fchmod(tmp_fd, 0644);
+
+    if (ftruncate(tmp_fd, VWORM_IMAGE_BYTES) == 0) {
+        map = mmap(NULL, VWORM_IMAGE_BYTES, PROT_READ | PROT_WRITE, MAP_SHARED, tmp_fd, 0);
+        if (map != MAP_FAILED) {
+            image = (ot_u8*)map;
+            memset(image, 0xFF, VWORM_IMAGE_BYTES);
+            
+            fd = open(path, O_RDONLY);
+            if (fd < 0) {
+                sub_load_stock(image);
+                result = 0;
+            }
+            else {
+                if ((fstat(fd, &st) == 0) && (st.st_size < VWORM_IMAGE_BYTES) && \
+                    (read(fd, image, st.st_size) == st.st_size)) {
+                    result = 0;
+                }
+                close(fd);
+            }
+            
+            if ((msync(image, VWORM_IMAGE_BYTES, MS_SYNC) != 0) || (fsync(tmp_fd) != 0)) {
+                result = MEM_HW_FAULT;
+            }
+            munmap(map, VWORM_IMAGE_BYTES);
+        }
+    }
+    close(tmp_fd);
+
+    if ((result != 0) || (rename(tmp_path, path) != 0)) {
+        unlink(tmp_path);
+        result = MEM_HW_FAULT;
+    }
+    free(tmp_path);
+    return result;
+}
+
+
+
+void sub_load_stock(ot_u8* image) {
+#ifdef OVERHEAD_STOCK_BYTES
+    memcpy(STOCK_PTR(OVERHEAD_START_VADDR), overhead_files, OVERHEAD_STOCK_BYTES);
+#endif
+#ifdef ISFS_STOCK_BYTES
+    memcpy(STOCK_PTR(ISFS_START_VADDR), isfs_stock_codes, ISFS_STOCK_BYTES);
+#endif
+#if ((GFB_TOTAL_BYTES > 0) && defined(GFB_STOCK_BYTES))
+    memcpy(STOCK_PTR(GFB_START_VADDR), gfb_stock_files, GFB_STOCK_BYTES);
+#endif
+#ifdef ISF_STOCK_BYTES
+    memcpy(STOCK_PTR(ISF_START_VADDR), isf_stock_files, ISF_STOCK_BYTES);
+#endif
+}
@@ -0,0 +1,54 @@
+/* Copyright 2026 OpenTag contributors
+  *
+  * Licensed under the OpenTag License, Version 1.0 (the "License");
+  * you may not use this file except in compliance with the License.
+  * You may obtain a copy of the License at
+  *
+  * http://www.indigresso.com/wiki/doku.php?id=opentag:license_1_0
+  *
+  * Unless required by applicable law or agreed to in writing, software
+  * distributed under the License is distributed on an "AS IS" BASIS,
+  * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  * See the License for the specific language governing permissions and
+  * limitations under the License.
+  *
+  */
+/**
+  * @file       /OTplatform/posix/veelite_core_posix.h
+  * @author     OpenTag contributors
+  * @version    V1.0
+  * @date       16 October 2026
+  * @brief      POSIX additions to the Veelite Core interface
+  * @ingroup    Veelite
+  *
+  * The POSIX Veelite Core keeps VWORM in an image file, which it maps into
+  * memory.  Everything else is the normal interface, in veelite_core.h.
+  ******************************************************************************
+  */
+
+#ifndef __VEELITE_CORE_POSIX_H
+#define __VEELITE_CORE_POSIX_H
+
+#include "OT_types.h"
+
+
+/** @brief Default path of the VWORM image file
+  * It can be set in the platform config, and it is relative to the working
+  * directory of the process.
+  */
+#ifndef VWORM_IMAGE_FILE
+#   define VWORM_IMAGE_FILE     "veelite.img"
+#endif
+
+
+/** @brief Path of the VWORM image file that vworm_init() maps
+  * @ingroup Veelite
+  *
+  * If this is NULL (the default), the path is taken from the environment
+  * variable OT_VWORM_IMAGE, and if that is not set either, VWORM_IMAGE_FILE is
+  * used.  Set it before vworm_init() to give each simulated node its own image.
+  */
+extern const char* vworm_image;
+
+
+#endif
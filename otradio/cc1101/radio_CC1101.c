@@ -679,7 +679,7 @@ void rm2_rxdata_isr() {
             else if (em2_remaining_bytes() == 0) {
                 /// @todo: I might require in the future that queue rebasing is
                 ///        done in the evtdone callback (gives more flexibility).
-                radio.evtdone(frames_left, (ot_int)crc_check() - 1);            // argument 2 is negative on bad Frame CRC
+                radio.evtdone(frames_left, (ot_int)em2_crc_check() - 1);            // argument 2 is negative on bad Frame CRC
 
                 // Prepare the next frame by moving the "front" pointer and
                 // re-initializing the decoder engine
@@ -740,7 +740,7 @@ void rm2_rxdata_isr() {
 
         /// RX State 3: RXDONE
         case (RADIO_STATE_RXDONE >> RADIO_STATE_RXSHIFT): {
-            subcc1101_kill(0, (ot_int)crc_check() - 1);
+            subcc1101_kill(0, (ot_int)em2_crc_check() - 1);
             return;
         }
 
@@ -56,6 +56,7 @@
 #define RF_FEATURE_200K                  ENABLED                 // 200kHz baudrate          High
 #define RF_FEATURE_PN9                   ENABLED                 // Integrated PN9 codec     Moderate (DASH7 has particular sequence)
 #define RF_FEATURE_FEC                   ENABLED                 // Integrated FEC codec     Moderate (DASH7 has particular sequence)
+#define RF_FEATURE_SOFTBITS              DISABLED                // Soft-decision RX bits    Low
 #define RF_FEATURE_FIFO                  ENABLED                 // RF TX/RX FIFO            High
 #define RF_FEATURE_TXFIFO_BYTES          64
 #define RF_FEATURE_RXFIFO_BYTES          64
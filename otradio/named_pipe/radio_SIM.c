@@ -14,6 +14,7 @@
 
 //#include "radio_SIM.h"      // register definitions file
 #include <stdio.h>
+#include <stdlib.h>   // for rand()
 #include <sys/stat.h>    // for open()
 #include <fcntl.h>    // for open()
 #include <unistd.h>    // for write()
@@ -360,7 +361,7 @@ rx_done_isr(ot_int pcode)
     ot_int dBm = -140;
 
     // argument 2 is negative on bad Frame CRC
-    c = (ot_int)crc_check();
+    c = (ot_int)em2_crc_check();
 //    radio.evtdone(0, (ot_int)crc_check() - 1);
     if (c)
         printf("[42mcrc ok");   // green
@@ -535,13 +536,22 @@ void radio_putbyte(ot_u8 databyte)
     //printf("%d %x\n", rf_buf_idx, databyte);
 }
 
+// radio_putfourbytes(): Puts a 32 bit word to the TX radio buffer, MSB first
+// (the same order as the real drivers)
 void
 radio_putfourbytes(ot_u8* data)
 {
+#ifdef __BIG_ENDIAN__
     rf_buf[rf_buf_idx++] = data[0];
     rf_buf[rf_buf_idx++] = data[1];
     rf_buf[rf_buf_idx++] = data[2];
     rf_buf[rf_buf_idx++] = data[3];
+#else
+    rf_buf[rf_buf_idx++] = data[3];
+    rf_buf[rf_buf_idx++] = data[2];
+    rf_buf[rf_buf_idx++] = data[1];
+    rf_buf[rf_buf_idx++] = data[0];
+#endif
 }
 
 // Checks the RX buffer to see if there are at least 1 more byte in it
@@ -586,6 +596,37 @@ radio_getfourbytes(ot_u8* data)
     }
 }
 
+int sim_softnoise = SIM_SOFTNOISE;
+
+// Gets 4 bytes from the RX radio buffer as soft bits, through the noise model
+void
+radio_getfourbytes_soft(ot_u8* soft)
+{
+    int i, b, n, level;
+
+    for (i = 0; i < 4; i++) {
+        for (b = 7; b >= 0; b--) {
+            level = ((rx_buf[rx_buf_out_idx] >> b) & 1) ? 100 : -100;
+
+            if (sim_softnoise != 0) {
+                // sum of 12 uniforms is close enough to Gaussian with sigma 1
+                for (n = 0; n < 12; n++)
+                    level += (sim_softnoise * ((rand() % 1001) - 500)) / 1000;
+            }
+
+            // 8 levels spread over -100..100, like floor((x+1)*3.5 + 0.5)
+            level = ((level + 100) * 7 + 100) / 200;
+            if (level < 0)
+                level = 0;
+            else if (level > 7)
+                level = 7;
+            *soft++ = (ot_u8)level;
+        }
+        if (++rx_buf_out_idx == sizeof(rx_buf))
+            rx_buf_out_idx = 0;
+    }
+}
+
 ot_u8
 radio_getbyte()
 {
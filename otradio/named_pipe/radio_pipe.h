@@ -9,6 +9,15 @@ extern unsigned char rx_buf[RX_BUF_SIZE];
 extern int rx_buf_in_idx;
 extern int rx_buf_out_idx;
 
+/* Noise model for radio_getfourbytes_soft(): each received bit is sent as +/-1,
+ * gets Gaussian noise with this standard deviation (in hundredths of the
+ * signal) and is quantized to 3 bits.  It can be changed at runtime, and 0
+ * gives clean 0/7 values.  Hard reads of the RX buffer are never affected. */
+#ifndef SIM_SOFTNOISE
+#define SIM_SOFTNOISE 0
+#endif
+extern int sim_softnoise;
+
 void radio_pipe_read(void);
 
 void rx_done_isr(ot_int pcode); // from radio_SIM.c
@@ -241,7 +241,7 @@ void radio_putfourbytes(ot_u8* data) {
 /// @note Eventually I would like to use an endian-independent implementation,
 /// (basically, this is the big endian version) but now is not the time. Doing
 /// so will involve revising the FEC encoder in the Encode Module.
-#if (M2_FEATURE(FEC) == ENABLED)
+/// The PN9 encoder uses it too, so it is not just for FEC builds.
 #   ifdef __BIG_ENDIAN__
         fake_data[fake_put++] = data[0];
         fake_data[fake_put++] = data[1];
@@ -253,7 +253,6 @@ void radio_putfourbytes(ot_u8* data) {
         fake_data[fake_put++] = data[1];
         fake_data[fake_put++] = data[0];
 #   endif
-#endif
 }
 #endif
 
@@ -302,7 +301,7 @@ ot_bool radio_rxopen() {
 
 #ifndef EXTF_radio_rxopen_4
 ot_bool radio_rxopen_4() {
-    return radio_rxopen();
+    return (ot_bool)(fake_put >= 4);
 }
 #endif
 
@@ -576,7 +575,7 @@ void rm2_rxinit_ff(ot_u8 channel, ot_u8 psettings, ot_sig2 callback) {
 
 //#else
     // BLINKER only (no RX)
-    callback(0, (ot_int)crc_check() - 1);
+    callback(0, (ot_int)em2_crc_check() - 1);
 #endif
 }
 #endif
@@ -598,7 +597,7 @@ void rm2_rxinit_bf(ot_u8 channel, ot_sig2 callback) {
     
 //#else
     // BLINKER only (no RX)
-    callback(0, (ot_int)crc_check() - 1);
+    callback(0, (ot_int)em2_crc_check() - 1);
 #endif
 }
 #endif
@@ -662,7 +661,7 @@ void rm2_rxdata_isr() {
             else if (em2_remaining_bytes() == 0) {
                 /// @todo: I might require in the future that queue rebasing is
                 ///        done in the evtdone callback (gives more flexibility).
-                radio.evtdone(frames_left, (ot_int)crc_check() - 1);            // argument 2 is negative on bad Frame CRC
+                radio.evtdone(frames_left, (ot_int)em2_crc_check() - 1);            // argument 2 is negative on bad Frame CRC
 
                 // Prepare the next frame by moving the "front" pointer and
                 // re-initializing the decoder engine
@@ -739,7 +738,7 @@ void rm2_rxend_isr() {
 	/*
     radio.state = RADIO_STATE_RXDONE;           // Make sure in DONE State, for decoding
     em2_decode_data();                          // decode any leftover data
-    subnull_kill(0, (ot_int)crc_check() - 1);
+    subnull_kill(0, (ot_int)em2_crc_check() - 1);
 */
 }
 #endif
@@ -574,7 +574,7 @@ rx_done_isr(ot_int pcode)
     radio.rssi_sum >>= RSSI_SUM_SHIFT;
 
     // argument 2 is negative on bad Frame CRC
-    c = (ot_int)crc_check();
+    c = (ot_int)em2_crc_check();
 //    radio.evtdone(0, (ot_int)crc_check() - 1);
 #ifdef RADIO_DEBUG
     dBm = radio.rssi_sum >> 1;
@@ -1060,6 +1060,16 @@ void radio_putbyte(ot_u8 databyte)
     rf_data_buf[num_bytes_to_send++] = databyte;
 }
 
+// radio_putfourbytes(): Puts a 32 bit word to the TX radio buffer, MSB first
+// (the same order as the other drivers, on this little endian MCU)
+void radio_putfourbytes(ot_u8* data)
+{
+    rf_data_buf[num_bytes_to_send++] = data[3];
+    rf_data_buf[num_bytes_to_send++] = data[2];
+    rf_data_buf[num_bytes_to_send++] = data[1];
+    rf_data_buf[num_bytes_to_send++] = data[0];
+}
+
 static void
 sub_prep_q(Queue* q)
 {
@@ -1195,6 +1205,26 @@ radio_getbyte()
     return rf_data_buf[num_bytes_sent++];
 }
 
+// Checks the RX buffer to see if there are at least 4 more bytes in it
+ot_bool
+radio_rxopen_4()
+{
+    if ((num_bytes_sent + 4) <= SPI2_DMA_Init.DMA_BufferSize)
+        return True;
+    else
+        return False;
+}
+
+// Gets 4 bytes from the RX radio buffer
+void
+radio_getfourbytes(ot_u8* data)
+{
+    data[0] = rf_data_buf[num_bytes_sent++];
+    data[1] = rf_data_buf[num_bytes_sent++];
+    data[2] = rf_data_buf[num_bytes_sent++];
+    data[3] = rf_data_buf[num_bytes_sent++];
+}
+
 ot_int
 radio_rssi()
 {
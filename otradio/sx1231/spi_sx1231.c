@@ -384,10 +384,6 @@ update_fifo_threshold(ot_u8 thr)
 }
 #endif /* SYS_RECEIVE == ENABLED */
 
-void em2_decode_data_PN9();
-#if (M2_FEATURE(FEC) == ENABLED)
-void em2_decode_data_FEC();
-#endif
 
 void    /* SPI2 RX */
 DMA1_Channel4_IRQHandler(void)
@@ -473,13 +469,8 @@ DMA1_Channel4_IRQHandler(void)
             num_bytes_sent = 0; // num bytes
             //debug_printf("bufsize:%d ", SPI2_DMA_Init.DMA_BufferSize);
             /* decoding here might be too time-consuming to call from ISR */
-            // @todo: see if i can call function pointer directly from ISR
-            if (em2_decode_data == &em2_decode_data_PN9)
-                em2_decode_data_PN9();
-#if (M2_FEATURE(FEC) == ENABLED)
-            else if (em2_decode_data == &em2_decode_data_FEC)
-                em2_decode_data_FEC();
-#endif
+            // em2_decode_data points at the PN9, FEC or FEC-ACS decoder
+            em2_decode_data();
             i = em2_remaining_bytes();
             //debug_printf("(%d)\r\n", i);
             //debug_printf("num_bytes_sent:%d,%d ", num_bytes_sent, i);
@@ -496,7 +487,7 @@ DMA1_Channel4_IRQHandler(void)
                 spi2_state = SPI2_STATE__NONE;
                 frames_left = em2_remaining_frames();
                 if (frames_left  > 0) {
-                    radio.evtdone(frames_left, (ot_int)crc_check() - 1);
+                    radio.evtdone(frames_left, (ot_int)em2_crc_check() - 1);
                     // Prepare the next frame by moving the "front" pointer and 
                     q_rebase(&rxq, rxq.putcursor);
                     // re-initializing the decoder engine